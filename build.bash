@@ -15,18 +15,36 @@ case "$1" in
         cmake --build build --parallel $job_count
         run-clang-tidy -p build -quiet -export-fixes build/clang-tidy-fixes.yaml
         ;;
+    "--benchmark")
+        cmake -B build/host -S host
+        cmake --build build/host --parallel $job_count
+        build/host/filament-dryer-benchmark "${@:2}"
+        ;;
     "--build")
         cmake -B build  -S . -DPICO_SDK_PATH=$sdk_path "${@:2}"
         cmake --build build --parallel $job_count
         ;;
+    "--simulate")
+        cmake -B build/host -S host
+        cmake --build build/host --parallel $job_count
+        build/host/filament-dryer-simulator "${@:2}"
+        ;;
+    "--test")
+        cmake -B build/host -S host
+        cmake --build build/host --parallel $job_count
+        build/host/filament-dryer-tests "${@:2}"
+        ;;
     "--clean")
         rm -rf build
         ;;
     *)
         echo "Usage: build.bash [OPTION]"
         echo "  --analyze       Analyzes the C/C++ code in the project"
+        echo "  --benchmark     Builds and runs the host benchmarks of the firmware's hot paths"
         echo "  --build         Builds the project without testing"
         echo "  --clean         Cleans all project files"
+        echo "  --simulate      Builds and runs the heater controller against a simulated dryer"
+        echo "  --test          Builds and runs the host tests of the firmware's platform independent code"
         exit 1
         ;;
 esac
@@ -0,0 +1,18 @@
+/*------------------------------------------------------------------------------
+Copyright (c) 2023 Joe Porembski
+SPDX-License-Identifier: BSD-3-Clause
+------------------------------------------------------------------------------*/
+#pragma once
+
+/*
+ * Host stand-in for the pico-sdk header of the same name. The memory-mapped flash is a small in-memory image, which
+ * host::loadConfiguration() fills in the same layout as load.py writes to the real flash.
+ */
+
+#include "pico/types.h"
+
+#define PICO_FLASH_SIZE_BYTES (4 * 1024)
+
+extern uint8_t host_flash_image[PICO_FLASH_SIZE_BYTES];
+
+#define XIP_BASE ((uintptr_t)host_flash_image)
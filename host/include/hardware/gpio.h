@@ -0,0 +1,20 @@
+/*------------------------------------------------------------------------------
+Copyright (c) 2023 Joe Porembski
+SPDX-License-Identifier: BSD-3-Clause
+------------------------------------------------------------------------------*/
+#pragma once
+
+/*
+ * Host stand-in for the pico-sdk header of the same name. Pin states are held in memory, where the simulator reads
+ * them back (e.g. to see whether the heater relay is on).
+ */
+
+#include "pico/types.h"
+
+#define GPIO_OUT 1
+#define GPIO_IN 0
+
+void gpio_init(uint gpio);
+void gpio_set_dir(uint gpio, bool out);
+void gpio_put(uint gpio, bool value);
+bool gpio_get(uint gpio);
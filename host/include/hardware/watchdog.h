@@ -0,0 +1,25 @@
+/*------------------------------------------------------------------------------
+Copyright (c) 2023 Joe Porembski
+SPDX-License-Identifier: BSD-3-Clause
+------------------------------------------------------------------------------*/
+#pragma once
+
+/*
+ * Host stand-in for the pico-sdk header of the same name. The scratch registers are plain memory which survives a
+ * simulated reset, see host::resetByWatchdog().
+ */
+
+#include "pico/types.h"
+
+typedef struct
+{
+    volatile uint32_t scratch[8];
+} watchdog_hw_t;
+
+extern watchdog_hw_t host_watchdog;
+
+#define watchdog_hw (&host_watchdog)
+
+bool watchdog_caused_reboot(void);
+void watchdog_enable(uint32_t delay_ms, bool pause_on_debug);
+void watchdog_update(void);
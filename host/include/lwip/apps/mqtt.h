@@ -0,0 +1,22 @@
+/*------------------------------------------------------------------------------
+Copyright (c) 2023 Joe Porembski
+SPDX-License-Identifier: BSD-3-Clause
+------------------------------------------------------------------------------*/
+#pragma once
+
+/*
+ * Host stand-in for the lwIP header of the same name. Only the connection status is provided, which is all the MQTT
+ * context needs; the client itself is not built on the host.
+ */
+
+typedef enum
+{
+    MQTT_CONNECT_ACCEPTED = 0,
+    MQTT_CONNECT_REFUSED_PROTOCOL_VERSION = 1,
+    MQTT_CONNECT_REFUSED_IDENTIFIER = 2,
+    MQTT_CONNECT_REFUSED_SERVER = 3,
+    MQTT_CONNECT_REFUSED_USERNAME_PASS = 4,
+    MQTT_CONNECT_REFUSED_NOT_AUTHORIZED_ = 5,
+    MQTT_CONNECT_DISCONNECTED = 256,
+    MQTT_CONNECT_TIMEOUT = 257
+} mqtt_connection_status_t;
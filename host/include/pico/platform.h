@@ -0,0 +1,14 @@
+/*------------------------------------------------------------------------------
+Copyright (c) 2023 Joe Porembski
+SPDX-License-Identifier: BSD-3-Clause
+------------------------------------------------------------------------------*/
+#pragma once
+
+/*
+ * Host stand-in for the pico-sdk header of the same name. There is only one thread of firmware code on the host, so the
+ * core it claims to run on is chosen by the caller, see host::setCore().
+ */
+
+#include "pico/types.h"
+
+uint get_core_num(void);
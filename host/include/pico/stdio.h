@@ -0,0 +1,11 @@
+/*------------------------------------------------------------------------------
+Copyright (c) 2023 Joe Porembski
+SPDX-License-Identifier: BSD-3-Clause
+------------------------------------------------------------------------------*/
+#pragma once
+
+/*
+ * Host stand-in for the pico-sdk header of the same name. printf goes straight to the host's stdout.
+ */
+
+#include <stdio.h>
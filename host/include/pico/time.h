@@ -0,0 +1,73 @@
+/*------------------------------------------------------------------------------
+Copyright (c) 2023 Joe Porembski
+SPDX-License-Identifier: BSD-3-Clause
+------------------------------------------------------------------------------*/
+#pragma once
+
+/*
+ * Host stand-in for the pico-sdk header of the same name. Time is driven by a virtual clock, see host::advanceClock().
+ * Sleeping advances the clock rather than blocking, and alarms fire in order as the clock passes them, in place of
+ * the alarm interrupt.
+ */
+
+#include "pico/types.h"
+
+typedef struct alarm_pool alarm_pool_t;
+typedef int32_t alarm_id_t;
+typedef int64_t (*alarm_callback_t)(alarm_id_t id, void* user_data);
+
+typedef struct repeating_timer repeating_timer_t;
+typedef bool (*repeating_timer_callback_t)(repeating_timer_t* rt);
+
+struct repeating_timer
+{
+    int64_t delay_us;
+    alarm_pool_t* pool;
+    alarm_id_t alarm_id;
+    repeating_timer_callback_t callback;
+    void* user_data;
+};
+
+uint32_t time_us_32(void);
+uint64_t time_us_64(void);
+absolute_time_t get_absolute_time(void);
+void sleep_us(uint64_t us);
+void sleep_ms(uint32_t ms);
+alarm_pool_t* alarm_pool_create(uint hardware_alarm_num, uint max_timers);
+alarm_id_t alarm_pool_add_alarm_in_ms(alarm_pool_t* pool, uint32_t ms, alarm_callback_t callback, void* user_data, bool fire_if_past);
+bool alarm_pool_cancel_alarm(alarm_pool_t* pool, alarm_id_t alarm_id);
+bool alarm_pool_add_repeating_timer_ms(alarm_pool_t* pool,
+                                       int32_t delay_ms,
+                                       repeating_timer_callback_t callback,
+                                       void* user_data,
+                                       repeating_timer_t* out);
+bool cancel_repeating_timer(repeating_timer_t* timer);
+
+static const absolute_time_t nil_time = 0;
+
+void sleep_until(absolute_time_t target);
+
+static inline uint64_t to_us_since_boot(absolute_time_t t)
+{
+    return t;
+}
+
+static inline uint32_t to_ms_since_boot(absolute_time_t t)
+{
+    return (uint32_t)(t / 1000);
+}
+
+static inline absolute_time_t delayed_by_ms(absolute_time_t t, uint32_t ms)
+{
+    return t + (uint64_t)ms * 1000;
+}
+
+static inline int64_t absolute_time_diff_us(absolute_time_t from, absolute_time_t to)
+{
+    return (int64_t)(to - from);
+}
+
+static inline bool add_repeating_timer_ms(int32_t delay_ms, repeating_timer_callback_t callback, void* user_data, repeating_timer_t* out)
+{
+    return alarm_pool_add_repeating_timer_ms(NULL, delay_ms, callback, user_data, out);
+}
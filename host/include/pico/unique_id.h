@@ -0,0 +1,15 @@
+/*------------------------------------------------------------------------------
+Copyright (c) 2023 Joe Porembski
+SPDX-License-Identifier: BSD-3-Clause
+------------------------------------------------------------------------------*/
+#pragma once
+
+/*
+ * Host stand-in for the pico-sdk header of the same name. Every host build reports the same fixed board ID.
+ */
+
+#include "pico/types.h"
+
+#define PICO_UNIQUE_BOARD_ID_SIZE_BYTES 8
+
+void pico_get_unique_board_id_string(char* id_out, uint len);
@@ -0,0 +1,17 @@
+/*------------------------------------------------------------------------------
+Copyright (c) 2023 Joe Porembski
+SPDX-License-Identifier: BSD-3-Clause
+------------------------------------------------------------------------------*/
+#pragma once
+
+#include <cstdint>
+
+
+namespace host {
+/**
+ * @return The number of heap allocations made so far, counted by a replacement of the global operator new.
+ *
+ * @note This is only counted in the executables which link allocations.cpp.
+ */
+uint64_t allocations();
+} // namespace host
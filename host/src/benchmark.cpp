@@ -0,0 +1,324 @@
+/*------------------------------------------------------------------------------
+Copyright (c) 2023 Joe Porembski
+SPDX-License-Identifier: BSD-3-Clause
+------------------------------------------------------------------------------*/
+#include "allocations.hpp"
+#include "cbor.hpp"
+#include "connectivity/mqtt/detail/context.hpp"
+#include "connectivity/mqtt/detail/publish-window.hpp"
+#include "connectivity/mqtt/topic-table.hpp"
+#include "controllers/heater.hpp"
+#include "fixtures.hpp"
+#include "hal.hpp"
+#include "mailbox.hpp"
+#include "report-filter.hpp"
+#include "sensors/constants.hpp"
+#include "sensors/dht-format.hpp"
+#include "sensors/filter.hpp"
+#include "utilities.hpp"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <string_view>
+#include <vector>
+
+
+/*
+ * Times the firmware's hot paths on the host, so that a change which slows one of them down shows up before it reaches
+ * a Pico. The results of the same workloads are checked by the host tests, which should pass before these timings are
+ * trusted.
+ *
+ * Host timings are not Pico timings; compare runs against each other on the same machine.
+ */
+
+using namespace fixtures;
+
+inline constexpr uint32_t DEFAULT_ITERATIONS = 100000;
+inline constexpr uint32_t DEFAULT_REPETITIONS = 5;
+
+/**
+ * A single timed operation.
+ */
+struct Benchmark
+{
+    /** The name used to select the benchmark. */
+    std::string_view name;
+
+    /** Runs the operation the given number of times, returning a value derived from the results. */
+    uint32_t (*run)(uint32_t);
+};
+
+/** Consumes the results of each run, so the compiler cannot discard the work that produced them. */
+static volatile uint32_t sink;
+
+static uint32_t runDHTFrame(uint32_t iterations)
+{
+    std::vector<sensors::detail::DHTEdge> edges = dhtEdges(DHT_FRAME);
+    uint32_t result = 0;
+    for (uint32_t i = 0; i < iterations; i++) {
+        Centidegrees temperature = 0;
+        Centipercent humidity = 0;
+        decodeDHT(edges, temperature, humidity);
+        result += static_cast<uint16_t>(temperature) + static_cast<uint16_t>(humidity);
+    }
+    return result;
+}
+
+static uint32_t runConfiguration(uint32_t iterations)
+{
+    host::loadConfiguration(serializedConfiguration());
+    uint32_t result = 0;
+    for (uint32_t i = 0; i < iterations; i++) {
+        SystemConfiguration cfg;
+        read(cfg);
+        result += static_cast<uint32_t>(cfg.deviceName().size());
+    }
+    return result;
+}
+
+static uint32_t dispatched_bytes = 0;
+
+static uint32_t runDispatch(uint32_t iterations)
+{
+    for (std::string_view topic : SUBSCRIBED_TOPICS) {
+        mqtt::detail::context().subscribe(topic, [](std::string_view /* topic */, mqtt::Payload data) {
+            dispatched_bytes += static_cast<uint32_t>(data.size());
+        });
+    }
+
+    dispatched_bytes = 0;
+    for (uint32_t i = 0; i < iterations; i++) {
+        dispatch(SUBSCRIBED_TOPICS[i % SUBSCRIBED_TOPICS.size()], DISPATCH_PAYLOAD, DISPATCH_PAYLOAD.size());
+    }
+    return dispatched_bytes;
+}
+
+static uint32_t runHeater(uint32_t iterations)
+{
+    controllers::Heater heater(HEATER_CONTROL_PIN, HEATER_FEEDBACK_PIN, HEATER_HYSTERESIS, HEATER_MAX_ON_TIME_MS);
+    heater.setTargetTemperature(toCenti(50));
+    heater.setMode(controllers::HeaterMode::PID);
+    uint32_t result = 0;
+    for (uint32_t i = 0; i < iterations; i++) {
+        // Sweep the measurement across the target so both the PID and the time-proportioned output keep moving.
+        Centidegrees temperature = static_cast<Centidegrees>(toCenti(45) + (i % 1000));
+        heater.update(Sample{temperature, SampleQuality::GOOD, 0});
+        host::advanceClock(CONTROL_PERIOD_US);
+        result += heater.duty();
+    }
+
+    // A reading above the cut-off switches the heater off, so none of its alarms outlive it.
+    heater.update(Sample{toCenti(100), SampleQuality::GOOD, 0});
+    return result;
+}
+
+/**
+ * @return A raw DHT22 temperature, in tenths of a degree, swept across the heater's target as @a i increases.
+ */
+static int16_t rawTemperature(uint32_t i)
+{
+    return static_cast<int16_t>(400 + (i % 200));
+}
+
+static uint32_t runMeasurementFixed(uint32_t iterations)
+{
+    constexpr Centidegrees TARGET = toCenti(50);
+    NumberBuffer number;
+    uint32_t result = 0;
+    for (uint32_t i = 0; i < iterations; i++) {
+        Centidegrees temperature = static_cast<Centidegrees>(rawTemperature(i) * DHTFormat<DHTType::DHT22>::DATA_FACTOR);
+        result += (temperature < TARGET) + static_cast<uint32_t>(formatCenti(temperature, number).size());
+    }
+    return result;
+}
+
+/*
+ * The same reading scaled, compared with the target, and formatted the way the firmware did before measurements were
+ * fixed point. The host has an FPU and the string fits in std::string's own buffer, so the gap to measurement-fixed is
+ * mostly printf-style float formatting and says nothing about the RP2040, where every step is soft-float; the firmware
+ * times both paths on the Pico when built with BENCHMARK_ITERATIONS.
+ */
+static uint32_t runMeasurementFloat(uint32_t iterations)
+{
+    constexpr float TARGET = 50.0f;
+    constexpr float DATA_FACTOR = 10.0f;
+    uint32_t result = 0;
+    for (uint32_t i = 0; i < iterations; i++) {
+        float temperature = rawTemperature(i) / DATA_FACTOR;
+        result += (temperature < TARGET) + static_cast<uint32_t>(std::to_string(temperature).size());
+    }
+    return result;
+}
+
+static uint32_t runFilter(uint32_t iterations)
+{
+    sensors::SampleFilter filter(TEMPERATURE_MAX_RATE, SAMPLE_EWMA_SHIFT, SAMPLE_MAX_AGE_MS);
+    uint32_t result = 0;
+    for (uint32_t i = 0; i < iterations; i++) {
+        int16_t reading = static_cast<int16_t>(toCenti(40) + (i % 7) * 10);
+        result += static_cast<uint16_t>(filter.update(reading, true, i * 2000ULL).value);
+    }
+    return result;
+}
+
+static uint32_t runMailbox(uint32_t iterations)
+{
+    Mailbox<MailboxValue> mailbox;
+    MailboxValue value = {};
+    uint32_t result = 0;
+    for (uint32_t i = 0; i < iterations; i++) {
+        mailbox.write(mailboxValue(i));
+        result += mailbox.read(value) + value.words[0];
+    }
+    return result;
+}
+
+static uint32_t runTelemetry(uint32_t iterations)
+{
+    mqtt::TopicTable topics;
+    topics.build(TELEMETRY_TOPICS.data(), TELEMETRY_TOPICS.size(), DEVICE_NAME);
+    uint32_t result = 0;
+    for (uint32_t i = 0; i < iterations; i++) {
+        result += formatTelemetry(topics, static_cast<Centidegrees>(toCenti(40) + (i % 1000)), static_cast<int32_t>(i % 5000));
+    }
+    return result;
+}
+
+static uint32_t runTelemetryStrings(uint32_t iterations)
+{
+    uint32_t result = 0;
+    for (uint32_t i = 0; i < iterations; i++) {
+        Centidegrees temperature = static_cast<Centidegrees>(toCenti(40) + (i % 1000));
+        result += formatTelemetryWithStrings(DEVICE_NAME, temperature, static_cast<int32_t>(i % 5000));
+    }
+    return result;
+}
+
+static uint32_t runCBOR(uint32_t iterations)
+{
+    std::array<uint8_t, CBOR_PAYLOAD_SIZE> payload;
+    uint32_t result = 0;
+    for (uint32_t i = 0; i < iterations; i++) {
+        CBORWriter writer(payload.data(), payload.size());
+        result += static_cast<uint32_t>(encodeSnapshot(writer, i, static_cast<Centidegrees>(toCenti(40) + (i % 1000))));
+    }
+    return result;
+}
+
+static uint32_t runPublishWindow(uint32_t iterations)
+{
+    mqtt::TopicTable topics;
+    topics.build(TELEMETRY_TOPICS.data(), TELEMETRY_TOPICS.size(), DEVICE_NAME);
+    mqtt::detail::PublishWindow window(MQTT_IN_FLIGHT_LIMIT - 2);
+    InFlightRequests requests;
+    uint32_t result = 0;
+    for (uint32_t i = 0; i < iterations; i++) {
+        uint32_t sent = publishThroughWindow(window, topics, requests, static_cast<Centidegrees>(toCenti(40) + (i % 1000)));
+        sent = drainWindow(window, requests, sent);
+        result += drainWindow(window, requests, sent);
+    }
+    return result;
+}
+
+static uint32_t runReportFilter(uint32_t iterations)
+{
+    ReportFilters filters;
+    uint32_t result = 0;
+    for (uint32_t i = 0; i < iterations; i++) {
+        result += reportCycle(filters, i);
+    }
+    return result;
+}
+
+inline constexpr std::array<Benchmark, 13> BENCHMARKS = {{
+    {"dht-frame", runDHTFrame},
+    {"measurement-fixed", runMeasurementFixed},
+    {"measurement-float", runMeasurementFloat},
+    {"config-read", runConfiguration},
+    {"topic-dispatch", runDispatch},
+    {"heater-update", runHeater},
+    {"sample-filter", runFilter},
+    {"mailbox", runMailbox},
+    {"telemetry-format", runTelemetry},
+    {"telemetry-strings", runTelemetryStrings},
+    {"telemetry-cbor", runCBOR},
+    {"publish-window", runPublishWindow},
+    {"report-filter", runReportFilter},
+}};
+
+static void printUsage(const char* program)
+{
+    printf("Usage: %s [--iterations N] [--repetitions N] [NAME]...\n", program);
+    printf("  Runs the named benchmarks, or all of them if none are named:\n");
+    for (const Benchmark& benchmark : BENCHMARKS) {
+        printf("    %s\n", benchmark.name.data());
+    }
+}
+
+/**
+ * Runs @a benchmark, measuring its time and heap allocations.
+ *
+ * @param[out] allocations_per_iteration The mean number of heap allocations per iteration.
+ * @return The fastest time per iteration over all repetitions, in nanoseconds.
+ */
+static double measure(const Benchmark& benchmark, uint32_t iterations, uint32_t repetitions, double& allocations_per_iteration)
+{
+    // One untimed run first, so that one-off setup such as subscribing is not counted against every iteration.
+    sink = benchmark.run(1);
+
+    double fastest_ns = 0.0;
+    uint64_t allocations_before = host::allocations();
+    for (uint32_t repetition = 0; repetition < repetitions; repetition++) {
+        auto start = std::chrono::steady_clock::now();
+        sink = benchmark.run(iterations);
+        std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+
+        double per_iteration_ns = elapsed.count() / iterations;
+        if (repetition == 0 || per_iteration_ns < fastest_ns) {
+            fastest_ns = per_iteration_ns;
+        }
+    }
+    allocations_per_iteration = static_cast<double>(host::allocations() - allocations_before) / (iterations * repetitions);
+    return fastest_ns;
+}
+
+int main(int argc, char** argv)
+{
+    uint32_t iterations = DEFAULT_ITERATIONS;
+    uint32_t repetitions = DEFAULT_REPETITIONS;
+    std::vector<std::string_view> selected;
+    for (int index = 1; index < argc; index++) {
+        std::string_view argument = argv[index];
+        if ((argument == "--iterations" || argument == "--repetitions") && index + 1 < argc) {
+            uint32_t value = static_cast<uint32_t>(std::strtoul(argv[++index], nullptr, 10));
+            (argument == "--iterations" ? iterations : repetitions) = std::max<uint32_t>(value, 1);
+        }
+        else if (std::any_of(BENCHMARKS.cbegin(), BENCHMARKS.cend(), [&](const Benchmark& b) { return b.name == argument; })) {
+            selected.push_back(argument);
+        }
+        else {
+            printUsage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    printf("%-18s %12s %12s\n", "Benchmark", "ns/iteration", "allocs/iter");
+    for (const Benchmark& benchmark : BENCHMARKS) {
+        if (!selected.empty() && std::find(selected.cbegin(), selected.cend(), benchmark.name) == selected.cend()) {
+            continue;
+        }
+
+        // The firmware logs from several of these paths; on the Pico that cost is real, so it is kept in the timing.
+        host::silenceOutput();
+        double allocations_per_iteration = 0.0;
+        double per_iteration_ns = measure(benchmark, iterations, repetitions, allocations_per_iteration);
+        host::restoreOutput();
+        printf("%-18s %12.1f %12.2f\n", benchmark.name.data(), per_iteration_ns, allocations_per_iteration);
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,297 @@
+/*------------------------------------------------------------------------------
+Copyright (c) 2023 Joe Porembski
+SPDX-License-Identifier: BSD-3-Clause
+------------------------------------------------------------------------------*/
+#include "fixtures.hpp"
+
+#include "connectivity/mqtt/detail/context.hpp"
+#include "controllers/heater.hpp"
+#include "sensors/dht-format.hpp"
+#include "text-buffer.hpp"
+
+#include <array>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <string_view>
+#include <vector>
+
+
+namespace fixtures {
+inline constexpr uint32_t DHT_PREAMBLE_US = 80;
+inline constexpr uint32_t DHT_BIT_LOW_US = 50;
+inline constexpr uint32_t DHT_ZERO_HIGH_US = 26;
+inline constexpr uint32_t DHT_ONE_HIGH_US = 70;
+
+inline constexpr uint32_t MS_PER_SECOND = 1000;
+inline constexpr uint32_t MS_PER_CENTISECOND = 10;
+inline constexpr uint32_t HISTORY_NOW_MS = 3600000;
+
+/**
+ * Builds a batch of history records ending just before HISTORY_NOW_MS, with the heater cycling and the odd bad reading.
+ *
+ * @param[in] temperature The temperature of the latest record in hundredths of a degree Celsius.
+ * @return The records, oldest first.
+ */
+static std::array<HistoryRecord, HISTORY_BATCH_SIZE> historyRecords(Centidegrees temperature)
+{
+    std::array<HistoryRecord, HISTORY_BATCH_SIZE> records;
+    for (uint32_t index = 0; index < records.size(); index++) {
+        HistoryRecord& record = records[index];
+        record.timepoint = HISTORY_NOW_MS - (HISTORY_BATCH_SIZE - index) * HISTORY_PERIOD_MS;
+        record.temperature = temperature - static_cast<Centidegrees>(HISTORY_BATCH_SIZE - index);
+        record.humidity = temperature + 1000;
+        record.target_temperature = toCenti(50);
+        record.flags = HistoryRecord::TEMPERATURE_GOOD;
+        if (index % 7 != 0) {
+            record.flags |= HistoryRecord::HUMIDITY_GOOD;
+        }
+        if (index % 4 < 2) {
+            record.flags |= HistoryRecord::HEATER_ON;
+        }
+    }
+    return records;
+}
+
+/**
+ * Stands in for the MQTT client, so the telemetry workload measures the formatting and not the network.
+ */
+static uint32_t publishTelemetry(const char* topic, std::string_view payload)
+{
+    return static_cast<uint32_t>(std::string_view(topic).size() + payload.size());
+}
+
+MailboxValue mailboxValue(uint32_t version)
+{
+    MailboxValue value;
+    value.words.fill(version);
+    return value;
+}
+
+std::vector<sensors::detail::DHTEdge> dhtEdges(const sensors::detail::DHTFrame& frame)
+{
+    std::vector<sensors::detail::DHTEdge> edges;
+    uint32_t time_us = 0;
+    edges.push_back({time_us, true});
+    time_us += DHT_PREAMBLE_US;
+    edges.push_back({time_us, false});
+
+    for (uint8_t byte : frame) {
+        for (int8_t bit = 7; bit >= 0; bit--) {
+            time_us += DHT_BIT_LOW_US;
+            edges.push_back({time_us, true});
+            time_us += ((byte >> bit) & 1) ? DHT_ONE_HIGH_US : DHT_ZERO_HIGH_US;
+            edges.push_back({time_us, false});
+        }
+    }
+    return edges;
+}
+
+bool decodeDHT(const std::vector<sensors::detail::DHTEdge>& edges, Centidegrees& temperature, Centipercent& humidity)
+{
+    sensors::detail::DHTFrameBuilder builder;
+    sensors::detail::DHTTiming timing;
+    if (!sensors::detail::decode(edges.data(), edges.size(), builder, timing)) {
+        return false;
+    }
+
+    sensors::detail::DHTFrame frame = builder.frame();
+    if (!sensors::detail::hasValidParity(frame)) {
+        return false;
+    }
+
+    DHTFormat<DHTType::DHT22>::parse(frame, temperature, humidity);
+    return true;
+}
+
+std::vector<uint8_t> serializedConfiguration()
+{
+    // Matches the layout written by load.py, a 4-byte little-endian length ahead of each string.
+    std::vector<uint8_t> configuration;
+    for (std::string_view text : CONFIGURATION_STRINGS) {
+        uint32_t length = static_cast<uint32_t>(text.size());
+        for (size_t byte = 0; byte < sizeof(length); byte++) {
+            configuration.push_back(static_cast<uint8_t>(length >> (byte * 8)));
+        }
+        configuration.insert(configuration.end(), text.cbegin(), text.cend());
+    }
+    return configuration;
+}
+
+void dispatch(std::string_view topic, std::string_view payload, size_t fragment_size)
+{
+    mqtt::detail::ContextInterface& context = mqtt::detail::context();
+    context.setPendingTopic(topic, static_cast<uint32_t>(payload.size()));
+    for (size_t offset = 0; offset < payload.size(); offset += fragment_size) {
+        std::string_view fragment = payload.substr(offset, fragment_size);
+        context.addPendingData(reinterpret_cast<const uint8_t*>(fragment.data()), static_cast<uint16_t>(fragment.size()));
+    }
+}
+
+uint32_t formatTelemetry(const mqtt::TopicTable& topics, Centidegrees temperature, int32_t jitter_us)
+{
+    NumberBuffer number;
+    uint32_t result = publishTelemetry(topics[0], formatCenti(temperature, number));
+    result += publishTelemetry(topics[1], formatCenti(temperature + 1000, number));
+    result += publishTelemetry(topics[2], formatCenti(temperature, number));
+    result += publishTelemetry(topics[3], formatCenti(toCenti(50), number));
+
+    TextBuffer<TELEMETRY_PAYLOAD_SIZE> jitter;
+    jitter.appendInteger(-jitter_us);
+    jitter.append(",");
+    jitter.appendInteger(jitter_us / 2);
+    jitter.append(",");
+    jitter.appendInteger(jitter_us);
+    result += publishTelemetry(topics[4], jitter.view());
+
+    TextBuffer<TELEMETRY_PAYLOAD_SIZE> gains;
+    gains.appendCenti(AUTOTUNE_GAINS.proportional);
+    gains.append(",");
+    gains.appendCenti(static_cast<int32_t>(AUTOTUNE_GAINS.integral_time_ms / MS_PER_CENTISECOND));
+    gains.append(",");
+    gains.appendCenti(static_cast<int32_t>(AUTOTUNE_GAINS.derivative_time_ms / MS_PER_CENTISECOND));
+    result += publishTelemetry(topics[5], gains.view());
+
+    std::array<HistoryRecord, HISTORY_BATCH_SIZE> records = historyRecords(temperature);
+    TextBuffer<HISTORY_PAYLOAD_SIZE> history;
+    for (const HistoryRecord& record : records) {
+        TextBuffer<TELEMETRY_PAYLOAD_SIZE> line;
+        line.appendInteger((HISTORY_NOW_MS - record.timepoint) / MS_PER_SECOND);
+        line.append(",");
+        if (record.flags & HistoryRecord::TEMPERATURE_GOOD) {
+            line.appendCenti(record.temperature);
+        }
+        line.append(",");
+        if (record.flags & HistoryRecord::HUMIDITY_GOOD) {
+            line.appendCenti(record.humidity);
+        }
+        line.append(",");
+        line.appendCenti(record.target_temperature);
+        line.append(",");
+        line.append((record.flags & HistoryRecord::HEATER_ON) ? controllers::Heater::STATUS_ON : controllers::Heater::STATUS_OFF);
+        line.append("\n");
+        if (!history.append(line.view())) {
+            break;
+        }
+    }
+    return result + publishTelemetry(topics[6], history.view());
+}
+
+uint32_t formatTelemetryWithStrings(std::string_view device_name, Centidegrees temperature, int32_t jitter_us)
+{
+    std::string name(device_name);
+    char topic[TOPIC_BUFFER_SIZE];
+    snprintf(topic, TOPIC_BUFFER_SIZE, TELEMETRY_TOPICS[0].format.data(), name.c_str());
+    uint32_t result = publishTelemetry(topic, centiToString(temperature));
+    snprintf(topic, TOPIC_BUFFER_SIZE, TELEMETRY_TOPICS[1].format.data(), name.c_str());
+    result += publishTelemetry(topic, centiToString(temperature + 1000));
+    snprintf(topic, TOPIC_BUFFER_SIZE, TELEMETRY_TOPICS[2].format.data(), name.c_str());
+    result += publishTelemetry(topic, centiToString(temperature));
+    snprintf(topic, TOPIC_BUFFER_SIZE, TELEMETRY_TOPICS[3].format.data(), name.c_str());
+    result += publishTelemetry(topic, centiToString(toCenti(50)));
+
+    std::string jitter = std::to_string(-jitter_us) + "," + std::to_string(jitter_us / 2) + "," + std::to_string(jitter_us);
+    snprintf(topic, TOPIC_BUFFER_SIZE, TELEMETRY_TOPICS[4].format.data(), name.c_str());
+    result += publishTelemetry(topic, jitter);
+
+    std::string gains = centiToString(AUTOTUNE_GAINS.proportional) + ","
+                        + centiToString(static_cast<int32_t>(AUTOTUNE_GAINS.integral_time_ms / MS_PER_CENTISECOND)) + ","
+                        + centiToString(static_cast<int32_t>(AUTOTUNE_GAINS.derivative_time_ms / MS_PER_CENTISECOND));
+    snprintf(topic, TOPIC_BUFFER_SIZE, TELEMETRY_TOPICS[5].format.data(), name.c_str());
+    result += publishTelemetry(topic, gains);
+
+    std::array<HistoryRecord, HISTORY_BATCH_SIZE> records = historyRecords(temperature);
+    std::string history;
+    for (const HistoryRecord& record : records) {
+        history += std::to_string((HISTORY_NOW_MS - record.timepoint) / MS_PER_SECOND) + ",";
+        history += ((record.flags & HistoryRecord::TEMPERATURE_GOOD) ? centiToString(record.temperature) : "") + ",";
+        history += ((record.flags & HistoryRecord::HUMIDITY_GOOD) ? centiToString(record.humidity) : "") + ",";
+        history += centiToString(record.target_temperature) + ",";
+        history += (record.flags & HistoryRecord::HEATER_ON) ? controllers::Heater::STATUS_ON : controllers::Heater::STATUS_OFF;
+        history += "\n";
+    }
+    snprintf(topic, TOPIC_BUFFER_SIZE, TELEMETRY_TOPICS[6].format.data(), name.c_str());
+    return result + publishTelemetry(topic, history);
+}
+
+size_t encodeSnapshot(CBORWriter& writer, uint32_t sequence, Centidegrees temperature)
+{
+    writer.map(8);
+    writer.text("sequence");
+    writer.integer(sequence);
+    writer.text("timestamp");
+    writer.integer(sequence * 10000ULL);
+    writer.text("temperature");
+    writer.decimal(temperature);
+    writer.text("humidity");
+    writer.decimal(temperature + 1000);
+    writer.text("sensor_quality");
+    writer.text("good");
+    writer.text("heater");
+    writer.boolean(sequence & 1);
+    writer.text("profile");
+    writer.null();
+    writer.text("control_jitter");
+    writer.array(3);
+    writer.integer(-static_cast<int32_t>(sequence % 5000));
+    writer.integer(12);
+    writer.integer(sequence % 5000);
+    return writer.size();
+}
+
+uint32_t publishThroughWindow(mqtt::detail::PublishWindow& window,
+                              const mqtt::TopicTable& topics,
+                              InFlightRequests& requests,
+                              Centidegrees temperature)
+{
+    NumberBuffer number;
+    uint32_t sent = 0;
+    for (size_t index = 0; index < topics.size(); index++) {
+        std::string_view payload = formatCenti(temperature, number);
+        mqtt::detail::InFlightRequest* request = window.ready() ? window.open() : nullptr;
+        if (request != nullptr) {
+            requests[sent++] = request;
+        }
+        else {
+            window.enqueue(topics[index], payload, topics.policy(index));
+        }
+    }
+    return sent;
+}
+
+uint32_t drainWindow(mqtt::detail::PublishWindow& window, InFlightRequests& requests, uint32_t in_flight)
+{
+    for (uint32_t index = 0; index < in_flight; index++) {
+        window.complete(requests[index]);
+    }
+
+    uint32_t sent = 0;
+    for (const mqtt::detail::QueuedPublish* next = window.front(); next != nullptr; next = window.front()) {
+        mqtt::detail::InFlightRequest* request = window.open();
+        if (request == nullptr) {
+            break;
+        }
+        requests[sent++] = request;
+        window.pop();
+    }
+    return sent;
+}
+
+uint32_t reportCycle(ReportFilters& filters, uint32_t cycle)
+{
+    std::array<int32_t, REPORT_DEADBANDS.size()> values = {toCenti(30),
+                                                           toCenti(25) + static_cast<int32_t>(cycle % 7),
+                                                           toCenti(40) + static_cast<int32_t>(cycle % 100),
+                                                           toCenti(50),
+                                                           static_cast<int32_t>((cycle / 9) & 1)};
+    uint32_t now_ms = cycle * REPORT_PERIOD_MS;
+    uint32_t due = 0;
+    for (size_t index = 0; index < filters.size(); index++) {
+        if (filters[index].due(values[index], REPORT_DEADBANDS[index], now_ms, REPORT_HEARTBEAT_MS)) {
+            filters[index].reported(values[index], now_ms);
+            due++;
+        }
+    }
+    return due;
+}
+} // namespace fixtures
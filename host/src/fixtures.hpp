@@ -0,0 +1,159 @@
+/*------------------------------------------------------------------------------
+Copyright (c) 2023 Joe Porembski
+SPDX-License-Identifier: BSD-3-Clause
+------------------------------------------------------------------------------*/
+#pragma once
+
+#include "cbor.hpp"
+#include "connectivity/mqtt/common.hpp"
+#include "connectivity/mqtt/detail/publish-window.hpp"
+#include "connectivity/mqtt/topic-table.hpp"
+#include "controllers/pid.hpp"
+#include "history.hpp"
+#include "measurement.hpp"
+#include "report-filter.hpp"
+#include "sensors/detail/dht-frame.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+
+/*
+ * Inputs and workloads shared by the host tests and benchmarks, so that what is timed is exactly what is checked.
+ */
+namespace fixtures {
+inline constexpr uint8_t HEATER_CONTROL_PIN = 19;
+inline constexpr uint8_t HEATER_FEEDBACK_PIN = 254;
+inline constexpr Centidegrees HEATER_HYSTERESIS = 250;
+inline constexpr uint64_t HEATER_MAX_ON_TIME_MS = 10 * 60 * 1000;
+inline constexpr uint64_t US_PER_MS = 1000;
+inline constexpr uint64_t CONTROL_PERIOD_US = 2000 * 1000;
+
+/** A DHT22 frame of 65.3% and -10.1C. */
+inline constexpr sensors::detail::DHTFrame DHT_FRAME = {0x02, 0x8D, 0x80, 0x65, 0x74};
+inline constexpr Centipercent DHT_FRAME_HUMIDITY = 6530;
+inline constexpr Centidegrees DHT_FRAME_TEMPERATURE = -1010;
+
+inline constexpr std::array<std::string_view, 4> CONFIGURATION_STRINGS = {"dryer-network",
+                                                                           "correct horse battery",
+                                                                           "broker.local",
+                                                                           "dryer"};
+inline constexpr std::array<std::string_view, 5> SUBSCRIBED_TOPICS = {"dryer/container/target_temperature/set",
+                                                                       "dryer/container/heater/autotune",
+                                                                       "dryer/container/heater/mode/set",
+                                                                       "dryer/container/heater/pid/set",
+                                                                       "dryer/container/heater/pid/window/set"};
+inline constexpr std::string_view DISPATCH_PAYLOAD = "55.0";
+inline constexpr std::string_view DEVICE_NAME = "dryer";
+inline constexpr size_t TELEMETRY_PAYLOAD_SIZE = 64;
+inline constexpr size_t TOPIC_BUFFER_SIZE = UINT8_MAX;
+inline constexpr mqtt::PublishPolicy MEASUREMENT_POLICY = {mqtt::QoS::AT_MOST_ONCE, true};
+inline constexpr mqtt::PublishPolicy STATE_POLICY = {mqtt::QoS::AT_LEAST_ONCE, true};
+inline constexpr mqtt::PublishPolicy HISTORY_POLICY = {mqtt::QoS::AT_LEAST_ONCE, false};
+inline constexpr std::array<mqtt::TopicDefinition, 7> TELEMETRY_TOPICS = {{
+    {"%s/board/temperature", MEASUREMENT_POLICY},
+    {"%s/container/humidity", MEASUREMENT_POLICY},
+    {"%s/container/temperature", MEASUREMENT_POLICY},
+    {"%s/container/target_temperature", STATE_POLICY},
+    {"%s/board/control/jitter", MEASUREMENT_POLICY},
+    {"%s/container/heater/autotune/result", STATE_POLICY},
+    {"%s/container/history", HISTORY_POLICY},
+}};
+inline constexpr controllers::PIDGains AUTOTUNE_GAINS = {toCenti(12), 240000, 60000};
+inline constexpr uint32_t HISTORY_BATCH_SIZE = 20;
+inline constexpr size_t HISTORY_PAYLOAD_SIZE = 1024;
+inline constexpr uint32_t HISTORY_PERIOD_MS = 10000;
+inline constexpr uint8_t MQTT_IN_FLIGHT_LIMIT = 5;
+inline constexpr size_t CBOR_PAYLOAD_SIZE = 512;
+inline constexpr uint32_t REPORT_PERIOD_MS = 10000;
+inline constexpr uint32_t REPORT_HEARTBEAT_MS = 60000;
+inline constexpr std::array<int32_t, 5> REPORT_DEADBANDS = {50, 50, 20, 0, 0};
+
+using InFlightRequests = std::array<mqtt::detail::InFlightRequest*, MQTT_IN_FLIGHT_LIMIT>;
+using ReportFilters = std::array<ReportFilter, REPORT_DEADBANDS.size()>;
+
+/** A value about the size of the control loop's feedback, with every word set from the write number. */
+struct MailboxValue
+{
+    std::array<uint32_t, 16> words;
+};
+
+/**
+ * @return A value with every word set to @a version.
+ */
+MailboxValue mailboxValue(uint32_t version);
+
+/**
+ * @return The edges a DHT sensor sends for @a frame, with nominal timing.
+ */
+std::vector<sensors::detail::DHTEdge> dhtEdges(const sensors::detail::DHTFrame& frame);
+
+/**
+ * Decodes @a edges as a DHT22 frame.
+ *
+ * @return True if the frame decoded and passed its parity check, false otherwise.
+ */
+bool decodeDHT(const std::vector<sensors::detail::DHTEdge>& edges, Centidegrees& temperature, Centipercent& humidity);
+
+/**
+ * @return CONFIGURATION_STRINGS in the layout written by load.py.
+ */
+std::vector<uint8_t> serializedConfiguration();
+
+/**
+ * Delivers @a payload on @a topic the way lwIP does, in fragments of at most @a fragment_size bytes.
+ */
+void dispatch(std::string_view topic, std::string_view payload, size_t fragment_size);
+
+/**
+ * Formats and publishes one cycle of telemetry, the way the network loop does: four measurements, the control jitter,
+ * the auto-tune gains, and a batch of HISTORY_BATCH_SIZE history records, each on its topic in @a topics.
+ *
+ * @return The total size of the topics and payloads.
+ */
+uint32_t formatTelemetry(const mqtt::TopicTable& topics, Centidegrees temperature, int32_t jitter_us);
+
+/**
+ * Formats and publishes the same cycle as formatTelemetry() the way the network loop did before the topic table: each
+ * topic formatted with snprintf for every publish, and each payload built as a std::string. Kept as the baseline the
+ * topic table and stack buffers are measured against.
+ *
+ * @return The total size of the topics and payloads, the same as formatTelemetry() for the same values.
+ */
+uint32_t formatTelemetryWithStrings(std::string_view device_name, Centidegrees temperature, int32_t jitter_us);
+
+/**
+ * Encodes a snapshot shaped like the one the network loop publishes in CBOR mode.
+ *
+ * @return The size of the encoded snapshot.
+ */
+size_t encodeSnapshot(CBORWriter& writer, uint32_t sequence, Centidegrees temperature);
+
+/**
+ * Publishes a cycle of telemetry through @a window the way the client does: sent while there is room, queued after.
+ *
+ * @return The number of publishes sent straight away.
+ */
+uint32_t publishThroughWindow(mqtt::detail::PublishWindow& window,
+                              const mqtt::TopicTable& topics,
+                              InFlightRequests& requests,
+                              Centidegrees temperature);
+
+/**
+ * Completes every request in flight, then sends what was queued, as the client does when the broker acknowledges.
+ *
+ * @return The number of queued publishes sent.
+ */
+uint32_t drainWindow(mqtt::detail::PublishWindow& window, InFlightRequests& requests, uint32_t in_flight);
+
+/**
+ * Runs one cycle of report-by-exception over values shaped like the container's: a temperature drifting slowly up,
+ * a steady humidity, and a heater which toggles now and then.
+ *
+ * @return The number of values due to be published.
+ */
+uint32_t reportCycle(ReportFilters& filters, uint32_t cycle);
+} // namespace fixtures
@@ -0,0 +1,326 @@
+/*------------------------------------------------------------------------------
+Copyright (c) 2023 Joe Porembski
+SPDX-License-Identifier: BSD-3-Clause
+------------------------------------------------------------------------------*/
+#include "hal.hpp"
+
+#include <hardware/flash.h>
+#include <hardware/gpio.h>
+#include <hardware/watchdog.h>
+#include <pico/platform.h>
+#include <pico/time.h>
+#include <pico/unique_id.h>
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+
+inline constexpr uint64_t US_PER_MS = 1000;
+inline constexpr const char* HOST_BOARD_ID = "E660000000000000";
+
+/** The largest number of alarms pending at once, like the fixed size of a pico-sdk alarm pool. */
+inline constexpr size_t MAX_ALARMS = 16;
+
+uint8_t host_flash_image[PICO_FLASH_SIZE_BYTES];
+watchdog_hw_t host_watchdog;
+
+static uint64_t clock_us = 0;
+static std::array<bool, NUM_BANK0_GPIOS> pin_states = {};
+static int saved_stdout = -1;
+static uint core_number = 0;
+static bool watchdog_reboot = false;
+static uint32_t watchdog_feeds = 0;
+
+/**
+ * An alarm waiting for the virtual clock to reach it.
+ */
+struct PendingAlarm
+{
+    /** The alarm's identifier, or 0 if the slot is free. */
+    alarm_id_t id;
+    uint64_t due_us;
+    alarm_callback_t callback;
+    void* user_data;
+};
+
+// A fixed table rather than a map, so that alarms cost no heap allocations the firmware would not make.
+static std::array<PendingAlarm, MAX_ALARMS> pending_alarms = {};
+static alarm_id_t next_alarm_id = 1;
+
+/**
+ * Adds an alarm to the first free slot.
+ *
+ * @return True if the alarm was added, false if every slot is taken.
+ */
+static bool addAlarm(const PendingAlarm& alarm)
+{
+    for (PendingAlarm& slot : pending_alarms) {
+        if (slot.id == 0) {
+            slot = alarm;
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * Fires the earliest alarm due at or before @a until_us, advancing the clock to it.
+ *
+ * @return True if an alarm fired, false if none are due.
+ */
+static bool fireNextAlarm(uint64_t until_us)
+{
+    PendingAlarm* next = nullptr;
+    for (PendingAlarm& alarm : pending_alarms) {
+        if (alarm.id != 0 && alarm.due_us <= until_us && (next == nullptr || alarm.due_us < next->due_us)) {
+            next = &alarm;
+        }
+    }
+
+    if (next == nullptr) {
+        return false;
+    }
+
+    PendingAlarm alarm = *next;
+    next->id = 0;
+    clock_us = std::max(clock_us, alarm.due_us);
+
+    // Matches the pico-sdk: a negative result is relative to when the alarm was due, a positive one to now.
+    int64_t reschedule_us = alarm.callback(alarm.id, alarm.user_data);
+    if (reschedule_us != 0) {
+        alarm.due_us = reschedule_us < 0 ? alarm.due_us + std::llabs(reschedule_us) : clock_us + reschedule_us;
+        addAlarm(alarm);
+    }
+    return true;
+}
+
+static int64_t onRepeatingTimer(alarm_id_t id, void* user_data)
+{
+    repeating_timer_t* timer = static_cast<repeating_timer_t*>(user_data);
+    timer->alarm_id = id;
+    if (!timer->callback(timer)) {
+        timer->alarm_id = 0;
+        return 0;
+    }
+    return timer->delay_us;
+}
+
+namespace host {
+void advanceClock(uint64_t elapsed_us)
+{
+    uint64_t until_us = clock_us + elapsed_us;
+    while (fireNextAlarm(until_us)) {
+    }
+    clock_us = until_us;
+}
+
+void setCore(uint8_t core)
+{
+    core_number = core;
+}
+
+void resetByWatchdog()
+{
+    watchdog_reboot = true;
+    watchdog_feeds = 0;
+}
+
+uint32_t watchdogFeeds()
+{
+    return watchdog_feeds;
+}
+
+bool pinState(uint8_t gpio)
+{
+    return gpio < NUM_BANK0_GPIOS && pin_states[gpio];
+}
+
+bool loadConfiguration(const std::vector<uint8_t>& configuration)
+{
+    // The configuration sits directly below its 4-byte length, which occupies the last 4 bytes of flash.
+    uint32_t length = static_cast<uint32_t>(configuration.size());
+    if (length + sizeof(length) > PICO_FLASH_SIZE_BYTES) {
+        return false;
+    }
+
+    size_t length_offset = PICO_FLASH_SIZE_BYTES - sizeof(length);
+    std::memcpy(&host_flash_image[length_offset - length], configuration.data(), length);
+    std::memcpy(&host_flash_image[length_offset], &length, sizeof(length));
+    return true;
+}
+
+void silenceOutput()
+{
+    if (saved_stdout >= 0) {
+        return;
+    }
+
+    fflush(stdout);
+    saved_stdout = dup(fileno(stdout));
+    if (freopen("/dev/null", "w", stdout) == nullptr) {
+        restoreOutput();
+    }
+}
+
+void restoreOutput()
+{
+    if (saved_stdout < 0) {
+        return;
+    }
+
+    fflush(stdout);
+    dup2(saved_stdout, fileno(stdout));
+    close(saved_stdout);
+    saved_stdout = -1;
+}
+} // namespace host
+
+void gpio_init(uint gpio)
+{
+    if (gpio < NUM_BANK0_GPIOS) {
+        pin_states[gpio] = false;
+    }
+}
+
+void gpio_set_dir(uint gpio, bool out)
+{
+    static_cast<void>(gpio);
+    static_cast<void>(out);
+}
+
+void gpio_put(uint gpio, bool value)
+{
+    if (gpio < NUM_BANK0_GPIOS) {
+        pin_states[gpio] = value;
+    }
+}
+
+bool gpio_get(uint gpio)
+{
+    return host::pinState(gpio);
+}
+
+uint32_t time_us_32()
+{
+    return static_cast<uint32_t>(clock_us);
+}
+
+uint64_t time_us_64()
+{
+    return clock_us;
+}
+
+absolute_time_t get_absolute_time()
+{
+    return clock_us;
+}
+
+void sleep_us(uint64_t us)
+{
+    host::advanceClock(us);
+}
+
+void sleep_ms(uint32_t ms)
+{
+    host::advanceClock(ms * US_PER_MS);
+}
+
+void sleep_until(absolute_time_t target)
+{
+    if (target > clock_us) {
+        host::advanceClock(target - clock_us);
+    }
+}
+
+uint get_core_num()
+{
+    return core_number;
+}
+
+bool watchdog_caused_reboot()
+{
+    return watchdog_reboot;
+}
+
+void watchdog_enable(uint32_t delay_ms, bool pause_on_debug)
+{
+    static_cast<void>(delay_ms);
+    static_cast<void>(pause_on_debug);
+}
+
+void watchdog_update()
+{
+    watchdog_feeds++;
+}
+
+alarm_pool_t* alarm_pool_create(uint hardware_alarm_num, uint max_timers)
+{
+    // Every alarm on the host shares the one virtual clock, so there is no pool to hand out.
+    static_cast<void>(hardware_alarm_num);
+    static_cast<void>(max_timers);
+    return nullptr;
+}
+
+alarm_id_t alarm_pool_add_alarm_in_ms(alarm_pool_t* pool, uint32_t ms, alarm_callback_t callback, void* user_data, bool fire_if_past)
+{
+    static_cast<void>(pool);
+    static_cast<void>(fire_if_past);
+    alarm_id_t id = next_alarm_id++;
+    if (!addAlarm(PendingAlarm{id, clock_us + ms * US_PER_MS, callback, user_data})) {
+        return -1;
+    }
+    return id;
+}
+
+bool alarm_pool_cancel_alarm(alarm_pool_t* pool, alarm_id_t alarm_id)
+{
+    static_cast<void>(pool);
+    for (PendingAlarm& alarm : pending_alarms) {
+        if (alarm.id == alarm_id) {
+            alarm.id = 0;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool alarm_pool_add_repeating_timer_ms(alarm_pool_t* pool,
+                                       int32_t delay_ms,
+                                       repeating_timer_callback_t callback,
+                                       void* user_data,
+                                       repeating_timer_t* out)
+{
+    // A negative delay times each run from the start of the last, a positive one from its end; the callbacks here take
+    // no virtual time, so both are the same.
+    int64_t delay_us = static_cast<int64_t>(delay_ms) * static_cast<int64_t>(US_PER_MS);
+    out->delay_us = delay_us < 0 ? delay_us : -delay_us;
+    out->pool = pool;
+    out->callback = callback;
+    out->user_data = user_data;
+    out->alarm_id = alarm_pool_add_alarm_in_ms(pool, static_cast<uint32_t>(std::llabs(delay_us) / US_PER_MS), onRepeatingTimer, out, true);
+    return out->alarm_id > 0;
+}
+
+bool cancel_repeating_timer(repeating_timer_t* timer)
+{
+    bool cancelled = timer->alarm_id != 0 && alarm_pool_cancel_alarm(timer->pool, timer->alarm_id);
+    timer->alarm_id = 0;
+    return cancelled;
+}
+
+void pico_get_unique_board_id_string(char* id_out, uint len)
+{
+    if (len == 0) {
+        return;
+    }
+
+    std::strncpy(id_out, HOST_BOARD_ID, len - 1);
+    id_out[len - 1] = '\0';
+}
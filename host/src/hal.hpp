@@ -0,0 +1,62 @@
+/*------------------------------------------------------------------------------
+Copyright (c) 2023 Joe Porembski
+SPDX-License-Identifier: BSD-3-Clause
+------------------------------------------------------------------------------*/
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+
+namespace host {
+/**
+ * Advances the virtual clock behind time_us_64() and milliseconds().
+ *
+ * @param[in] elapsed_us The time to advance by in microseconds.
+ */
+void advanceClock(uint64_t elapsed_us);
+
+/**
+ * Sets the core the firmware code which follows claims to run on, as returned by get_core_num().
+ *
+ * @param[in] core The core number, 0 or 1.
+ */
+void setCore(uint8_t core);
+
+/**
+ * Simulates a reset caused by the watchdog: watchdog_caused_reboot() returns true from now on, and the scratch
+ * registers keep their values.
+ */
+void resetByWatchdog();
+
+/**
+ * @return The number of times the watchdog has been fed since boot or the last resetByWatchdog().
+ */
+uint32_t watchdogFeeds();
+
+/**
+ * @param[in] gpio The GPIO pin.
+ * @return The last value written to @a gpio.
+ */
+bool pinState(uint8_t gpio);
+
+/**
+ * Writes a configuration to the simulated flash, where read() will find it.
+ *
+ * @param[in] configuration The serialized configuration, as written by load.py.
+ * @return True if the configuration fits in the simulated flash, false otherwise.
+ */
+bool loadConfiguration(const std::vector<uint8_t>& configuration);
+
+/**
+ * Sends stdout to /dev/null until restoreOutput() is called.
+ *
+ * The firmware logs liberally, which would otherwise drown out the results of a long run.
+ */
+void silenceOutput();
+
+/**
+ * Restores stdout after a call to silenceOutput().
+ */
+void restoreOutput();
+} // namespace host
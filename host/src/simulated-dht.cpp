@@ -0,0 +1,104 @@
+/*------------------------------------------------------------------------------
+Copyright (c) 2023 Joe Porembski
+SPDX-License-Identifier: BSD-3-Clause
+------------------------------------------------------------------------------*/
+#include "simulated-dht.hpp"
+
+#include "utilities.hpp"
+
+#include <cmath>
+#include <cstdint>
+#include <random>
+
+
+namespace host {
+inline constexpr uint32_t DHT22_MINIMUM_READ_PERIOD_MS = 2000;
+inline constexpr double DHT22_RESOLUTION = 0.1;
+inline constexpr double CENTI_PER_UNIT_F = 100.0;
+inline constexpr uint32_t NOISE_SEED = 22;
+
+/**
+ * @param[in] value A measurement in whole units.
+ * @return @a value quantized to the DHT22's resolution, in hundredths.
+ */
+static int16_t quantize(double value)
+{
+    return static_cast<int16_t>(std::lround(value / DHT22_RESOLUTION) * DHT22_RESOLUTION * CENTI_PER_UNIT_F);
+}
+
+SimulatedDHT::SimulatedDHT(const ThermalPlant& plant, double noise_c)
+    : _plant(plant),
+      _noise(0.0, noise_c > 0.0 ? noise_c : 0.0),
+      _generator(NOISE_SEED),
+      _temperature(0),
+      _humidity(0),
+      _valid(false),
+      _busy(false),
+      _has_read(false),
+      _last_read_timepoint(0),
+      _early_read_count(0)
+{}
+
+Centidegrees SimulatedDHT::temperature() const
+{
+    return _temperature;
+}
+
+Centipercent SimulatedDHT::humidity() const
+{
+    return _humidity;
+}
+
+bool SimulatedDHT::valid() const
+{
+    return _valid;
+}
+
+uint32_t SimulatedDHT::minimumReadPeriod() const
+{
+    return DHT22_MINIMUM_READ_PERIOD_MS;
+}
+
+bool SimulatedDHT::busy() const
+{
+    return _busy;
+}
+
+bool SimulatedDHT::beginRead()
+{
+    if (_busy) {
+        return false;
+    }
+
+    _busy = true;
+    return true;
+}
+
+bool SimulatedDHT::poll()
+{
+    if (!_busy) {
+        return false;
+    }
+
+    uint64_t timepoint = milliseconds();
+    _busy = false;
+    if (_has_read && timepoint - _last_read_timepoint < DHT22_MINIMUM_READ_PERIOD_MS) {
+        _early_read_count++;
+        _valid = false;
+        return true;
+    }
+
+    double noise = _noise.stddev() > 0.0 ? _noise(_generator) : 0.0;
+    _temperature = quantize(_plant.airTemperature() + noise);
+    _humidity = quantize(_plant.relativeHumidity());
+    _valid = true;
+    _has_read = true;
+    _last_read_timepoint = timepoint;
+    return true;
+}
+
+uint32_t SimulatedDHT::earlyReadCount() const
+{
+    return _early_read_count;
+}
+} // namespace host
@@ -0,0 +1,63 @@
+/*------------------------------------------------------------------------------
+Copyright (c) 2023 Joe Porembski
+SPDX-License-Identifier: BSD-3-Clause
+------------------------------------------------------------------------------*/
+#pragma once
+
+#include "sensors/environment-sensor.hpp"
+#include "thermal-plant.hpp"
+
+#include <cstdint>
+#include <random>
+
+
+namespace host {
+/**
+ * A DHT22 reading the air of a ThermalPlant.
+ *
+ * Readings are quantized to the DHT22's 0.1 unit resolution, with optional gaussian noise. Like the real sensor, a read
+ * started less than 2 seconds after the previous one fails.
+ */
+class SimulatedDHT final : public sensors::EnvironmentSensor
+{
+public:
+    /**
+     * Constructor.
+     *
+     * @param[in] plant The plant whose air is measured.
+     * @param[in] noise_c The standard deviation of the noise added to each temperature reading, in degrees Celsius.
+     */
+    SimulatedDHT(const ThermalPlant& plant, double noise_c);
+
+    Centidegrees temperature() const override;
+
+    Centipercent humidity() const override;
+
+    bool valid() const override;
+
+    uint32_t minimumReadPeriod() const override;
+
+    bool busy() const override;
+
+    bool beginRead() override;
+
+    bool poll() override;
+
+    /**
+     * @return The number of reads which failed for being started too soon after the previous one.
+     */
+    uint32_t earlyReadCount() const;
+
+private:
+    const ThermalPlant& _plant;
+    std::normal_distribution<double> _noise;
+    std::mt19937 _generator;
+    Centidegrees _temperature;
+    Centipercent _humidity;
+    bool _valid;
+    bool _busy;
+    bool _has_read;
+    uint64_t _last_read_timepoint;
+    uint32_t _early_read_count;
+};
+} // namespace host
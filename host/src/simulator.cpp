@@ -0,0 +1,312 @@
+/*------------------------------------------------------------------------------
+Copyright (c) 2023 Joe Porembski
+SPDX-License-Identifier: BSD-3-Clause
+------------------------------------------------------------------------------*/
+#include "controllers/heater.hpp"
+#include "controllers/profile.hpp"
+#include "hal.hpp"
+#include "sensors/constants.hpp"
+#include "sensors/filter.hpp"
+#include "simulated-dht.hpp"
+#include "thermal-plant.hpp"
+#include "utilities.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <string_view>
+
+
+/*
+ * Runs the firmware's heater controller against a simulated dryer, faster than real time.
+ *
+ * The control cycle mirrors controlLoop() in src/main.cpp: read the sensor, filter the reading, update the heater, then
+ * wait out the control period. Between control cycles the thermal plant is stepped forward in small increments, with the
+ * heater powered whenever its control pin is high.
+ */
+
+inline constexpr uint8_t HEATER_CONTROL_PIN = 19;
+inline constexpr uint8_t HEATER_FEEDBACK_PIN = 254;
+inline constexpr uint32_t MINIMUM_CONTROL_PERIOD_MS = 1000;
+inline constexpr uint64_t PLANT_STEP_MS = 100;
+inline constexpr uint64_t US_PER_MS = 1000;
+inline constexpr double MS_PER_S = 1000.0;
+inline constexpr double S_PER_HOUR = 3600.0;
+inline constexpr double J_PER_WH = 3600.0;
+inline constexpr double CENTI_PER_UNIT_F = 100.0;
+
+/**
+ * The options of a simulation run.
+ */
+struct Options
+{
+    double hours = 12.0;
+    double target_c = 50.0;
+    double hysteresis_c = 2.5;
+    double max_on_time_s = 600.0;
+    double noise_c = 0.0;
+    double band_c = 1.0;
+    double window_s = 0.0;
+    bool set_gains = false;
+    controllers::PIDGains gains = {};
+    controllers::HeaterMode mode = controllers::HeaterMode::HYSTERESIS;
+    bool run_profile = false;
+    controllers::Profile profile = {};
+    host::PlantParameters plant = host::defaultPlantParameters();
+    bool verbose = false;
+};
+
+/**
+ * The measured performance of a simulation run.
+ */
+struct Results
+{
+    double peak_c = 0.0;
+    double time_to_target_s = -1.0;
+    double settling_time_s = 0.0;
+    double absolute_error_sum_c = 0.0;
+    uint64_t settled_samples = 0;
+    uint32_t relay_switches = 0;
+    double profile_complete_s = -1.0;
+};
+
+static void printUsage(const char* program)
+{
+    printf("Usage: %s [OPTION VALUE]...\n", program);
+    printf("  --hours H            Length of the simulated run (default 12)\n");
+    printf("  --target C           Target temperature (default 50)\n");
+    printf("  --mode MODE          hysteresis, pid, or autotune (default hysteresis)\n");
+    printf("  --profile PROFILE    Runs a drying profile (pla, petg, nylon, tpu, or custom segments) instead of --target\n");
+    printf("  --gains Kp,Ti,Td     PID gains in %%/C, seconds, seconds\n");
+    printf("  --window S           PID time-proportioning window in seconds\n");
+    printf("  --hysteresis C       Hysteresis of the bang-bang mode (default 2.5)\n");
+    printf("  --max-on S           Maximum heater on time in seconds (default 600)\n");
+    printf("  --ambient C          Ambient temperature (default 22)\n");
+    printf("  --power W            Heater power (default 150)\n");
+    printf("  --spool-mass KG      Spool mass (default 1.0)\n");
+    printf("  --band C             Band around the target used for the settling time (default 1)\n");
+    printf("  --noise C            Standard deviation of sensor noise (default 0)\n");
+    printf("  --verbose            Show the controller's log output\n");
+}
+
+static bool parseOptions(int argc, char** argv, Options& options)
+{
+    for (int index = 1; index < argc; index++) {
+        std::string_view option = argv[index];
+        if (option == "--verbose") {
+            options.verbose = true;
+            continue;
+        }
+
+        if (index + 1 >= argc) {
+            return false;
+        }
+
+        const char* value = argv[++index];
+        if (option == "--hours") {
+            options.hours = std::atof(value);
+        }
+        else if (option == "--target") {
+            options.target_c = std::atof(value);
+        }
+        else if (option == "--mode") {
+            if (!controllers::fromString(value, options.mode)) {
+                return false;
+            }
+        }
+        else if (option == "--profile") {
+            if (!controllers::fromString(value, options.profile)) {
+                return false;
+            }
+            options.run_profile = true;
+        }
+        else if (option == "--gains") {
+            double proportional = 0.0;
+            double integral_s = 0.0;
+            double derivative_s = 0.0;
+            if (sscanf(value, "%lf,%lf,%lf", &proportional, &integral_s, &derivative_s) != 3) {
+                return false;
+            }
+            options.gains.proportional = static_cast<int32_t>(std::lround(proportional * CENTI_PER_UNIT_F));
+            options.gains.integral_time_ms = static_cast<uint32_t>(std::lround(integral_s * MS_PER_S));
+            options.gains.derivative_time_ms = static_cast<uint32_t>(std::lround(derivative_s * MS_PER_S));
+            options.set_gains = true;
+        }
+        else if (option == "--window") {
+            options.window_s = std::atof(value);
+        }
+        else if (option == "--hysteresis") {
+            options.hysteresis_c = std::atof(value);
+        }
+        else if (option == "--max-on") {
+            options.max_on_time_s = std::atof(value);
+        }
+        else if (option == "--ambient") {
+            options.plant.ambient_temperature_c = std::atof(value);
+        }
+        else if (option == "--power") {
+            options.plant.heater_power_w = std::atof(value);
+        }
+        else if (option == "--spool-mass") {
+            options.plant.spool_mass_kg = std::atof(value);
+        }
+        else if (option == "--band") {
+            options.band_c = std::atof(value);
+        }
+        else if (option == "--noise") {
+            options.noise_c = std::atof(value);
+        }
+        else {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void printResults(const Options& options,
+                         const Results& results,
+                         const host::ThermalPlant& plant,
+                         const controllers::ProfileRunner& profile,
+                         double wall_s)
+{
+    double simulated_s = options.hours * S_PER_HOUR;
+    if (options.run_profile) {
+        printf("Simulated %.1f h of the %s profile under %s control in %.2f s\n",
+               options.hours,
+               options.profile.name,
+               controllers::toString(options.mode).data(),
+               wall_s);
+        if (results.profile_complete_s < 0.0) {
+            printf("  Profile:         %s%% complete, at most %.0f s remaining\n",
+                   centiToString(profile.progress()).c_str(),
+                   profile.remaining() / MS_PER_S);
+        }
+        else {
+            printf("  Profile:         complete after %.0f s\n", results.profile_complete_s);
+        }
+        // Overshoot and settling are measured against a fixed target, which a profile does not have.
+        printf("  Peak air:        %.2f C\n", results.peak_c);
+    }
+    else {
+        printf("Simulated %.1f h of %s control at %.1fC in %.2f s\n",
+               options.hours,
+               controllers::toString(options.mode).data(),
+               options.target_c,
+               wall_s);
+        if (results.time_to_target_s < 0.0) {
+            printf("  Target never reached (peak %.2fC)\n", results.peak_c);
+        }
+        else {
+            printf("  Time to target:  %.0f s\n", results.time_to_target_s);
+            printf("  Overshoot:       %.2f C\n", std::fmax(results.peak_c - options.target_c, 0.0));
+            if (results.settling_time_s >= simulated_s) {
+                printf("  Settling time:   not settled within +/-%.1f C\n", options.band_c);
+            }
+            else {
+                printf("  Settling time:   %.0f s (+/-%.1f C)\n", results.settling_time_s, options.band_c);
+            }
+        }
+        if (results.settled_samples > 0) {
+            printf("  Mean |error|:    %.2f C after settling\n", results.absolute_error_sum_c / results.settled_samples);
+        }
+    }
+    printf("  Energy:          %.1f Wh\n", plant.energy() / J_PER_WH);
+    printf("  Relay switches:  %u\n", results.relay_switches);
+    printf("  Final spool:     %.2f C\n", plant.spoolTemperature());
+}
+
+int main(int argc, char** argv)
+{
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        printUsage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    if (!options.verbose) {
+        host::silenceOutput();
+    }
+
+    host::ThermalPlant plant(options.plant);
+    host::SimulatedDHT sensor(plant, options.noise_c);
+    Centidegrees target = static_cast<Centidegrees>(std::lround(options.target_c * CENTI_PER_UNIT_F));
+    Centidegrees hysteresis = static_cast<Centidegrees>(std::lround(options.hysteresis_c * CENTI_PER_UNIT_F));
+    uint64_t max_on_time_ms = static_cast<uint64_t>(options.max_on_time_s * MS_PER_S);
+    controllers::Heater heater(HEATER_CONTROL_PIN, HEATER_FEEDBACK_PIN, hysteresis, max_on_time_ms);
+    sensors::SampleFilter temperature_filter(TEMPERATURE_MAX_RATE, SAMPLE_EWMA_SHIFT, SAMPLE_MAX_AGE_MS);
+    sensors::SampleFilter humidity_filter(HUMIDITY_MAX_RATE, SAMPLE_EWMA_SHIFT, SAMPLE_MAX_AGE_MS);
+    controllers::ProfileRunner profile;
+    uint32_t control_period_ms = std::max(sensor.minimumReadPeriod(), MINIMUM_CONTROL_PERIOD_MS);
+
+    heater.setTargetTemperature(target);
+    if (options.set_gains) {
+        heater.setGains(options.gains);
+    }
+    if (options.window_s > 0.0) {
+        heater.setWindow(static_cast<uint32_t>(options.window_s * MS_PER_S));
+    }
+    heater.setMode(options.mode);
+    if (options.run_profile) {
+        Centidegrees ambient = static_cast<Centidegrees>(std::lround(options.plant.ambient_temperature_c * CENTI_PER_UNIT_F));
+        profile.start(options.profile, ambient, 0);
+    }
+
+    Results results;
+    uint64_t duration_ms = static_cast<uint64_t>(options.hours * S_PER_HOUR * MS_PER_S);
+    uint64_t next_control_ms = 0;
+    bool was_on = false;
+    auto wall_start = std::chrono::steady_clock::now();
+
+    for (uint64_t now_ms = 0; now_ms < duration_ms; now_ms += PLANT_STEP_MS) {
+        if (now_ms >= next_control_ms) {
+            sensor.beginRead();
+            sensor.poll();
+            const Sample& temperature = temperature_filter.update(sensor.temperature(), sensor.valid(), now_ms);
+            const Sample& humidity = humidity_filter.update(sensor.humidity(), sensor.valid(), now_ms);
+            if (profile.update(temperature, humidity, now_ms)) {
+                heater.setTargetTemperature(profile.setpoint());
+            }
+            if (results.profile_complete_s < 0.0 && profile.state() == controllers::ProfileState::COMPLETE) {
+                results.profile_complete_s = now_ms / MS_PER_S;
+            }
+            heater.update(temperature);
+            next_control_ms += control_period_ms;
+        }
+
+        bool is_on = host::pinState(HEATER_CONTROL_PIN);
+        if (is_on && !was_on) {
+            results.relay_switches++;
+        }
+        was_on = is_on;
+
+        plant.step(is_on, PLANT_STEP_MS / MS_PER_S);
+        host::advanceClock(PLANT_STEP_MS * US_PER_MS);
+
+        double air = plant.airTemperature();
+        double now_s = (now_ms + PLANT_STEP_MS) / MS_PER_S;
+        if (results.time_to_target_s < 0.0 && air >= options.target_c) {
+            results.time_to_target_s = now_s;
+        }
+        results.peak_c = std::fmax(results.peak_c, air);
+
+        // The settling time is the last time the air left the band, so every sample after it is within the band.
+        if (std::fabs(air - options.target_c) > options.band_c) {
+            results.settling_time_s = now_s;
+            results.absolute_error_sum_c = 0.0;
+            results.settled_samples = 0;
+        }
+        else {
+            results.absolute_error_sum_c += std::fabs(air - options.target_c);
+            results.settled_samples++;
+        }
+    }
+
+    double wall_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - wall_start).count();
+    host::restoreOutput();
+
+    printResults(options, results, plant, profile, wall_s);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,82 @@
+/*------------------------------------------------------------------------------
+Copyright (c) 2023 Joe Porembski
+SPDX-License-Identifier: BSD-3-Clause
+------------------------------------------------------------------------------*/
+#include "thermal-plant.hpp"
+
+#include <cmath>
+
+
+namespace host {
+inline constexpr double MAGNUS_A = 17.62;
+inline constexpr double MAGNUS_B_C = 243.12;
+
+/**
+ * @param[in] temperature The temperature in degrees Celsius.
+ * @return The saturation vapour pressure of water relative to 0 degrees Celsius (Magnus formula).
+ */
+static double saturationPressure(double temperature)
+{
+    return std::exp((MAGNUS_A * temperature) / (MAGNUS_B_C + temperature));
+}
+
+PlantParameters defaultPlantParameters()
+{
+    PlantParameters parameters;
+    parameters.heater_power_w = 150.0;
+    parameters.heater_capacity_j_per_k = 400.0;
+    parameters.heater_to_air_w_per_k = 6.0;
+    parameters.air_capacity_j_per_k = 3000.0;
+    parameters.air_to_ambient_w_per_k = 1.8;
+    parameters.spool_mass_kg = 1.0;
+    parameters.spool_specific_heat_j_per_kg_k = 1800.0;
+    parameters.air_to_spool_w_per_k = 0.8;
+    parameters.ambient_temperature_c = 22.0;
+    parameters.ambient_humidity_percent = 50.0;
+    return parameters;
+}
+
+ThermalPlant::ThermalPlant(const PlantParameters& parameters)
+    : _parameters(parameters),
+      _heater_temperature(parameters.ambient_temperature_c),
+      _air_temperature(parameters.ambient_temperature_c),
+      _spool_temperature(parameters.ambient_temperature_c),
+      _energy(0.0)
+{}
+
+double ThermalPlant::airTemperature() const
+{
+    return _air_temperature;
+}
+
+double ThermalPlant::spoolTemperature() const
+{
+    return _spool_temperature;
+}
+
+double ThermalPlant::relativeHumidity() const
+{
+    double humidity = _parameters.ambient_humidity_percent * saturationPressure(_parameters.ambient_temperature_c)
+                      / saturationPressure(_air_temperature);
+    return std::fmin(humidity, 100.0);
+}
+
+double ThermalPlant::energy() const
+{
+    return _energy;
+}
+
+void ThermalPlant::step(bool heater_on, double elapsed_s)
+{
+    double heater_power = heater_on ? _parameters.heater_power_w : 0.0;
+    double heater_to_air = _parameters.heater_to_air_w_per_k * (_heater_temperature - _air_temperature);
+    double air_to_spool = _parameters.air_to_spool_w_per_k * (_air_temperature - _spool_temperature);
+    double air_to_ambient = _parameters.air_to_ambient_w_per_k * (_air_temperature - _parameters.ambient_temperature_c);
+    double spool_capacity = _parameters.spool_mass_kg * _parameters.spool_specific_heat_j_per_kg_k;
+
+    _heater_temperature += (heater_power - heater_to_air) * elapsed_s / _parameters.heater_capacity_j_per_k;
+    _air_temperature += (heater_to_air - air_to_spool - air_to_ambient) * elapsed_s / _parameters.air_capacity_j_per_k;
+    _spool_temperature += air_to_spool * elapsed_s / spool_capacity;
+    _energy += heater_power * elapsed_s;
+}
+} // namespace host
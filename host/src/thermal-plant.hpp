@@ -0,0 +1,103 @@
+/*------------------------------------------------------------------------------
+Copyright (c) 2023 Joe Porembski
+SPDX-License-Identifier: BSD-3-Clause
+------------------------------------------------------------------------------*/
+#pragma once
+
+#include <cstdint>
+
+
+namespace host {
+/**
+ * The physical parameters of a dryer enclosure.
+ */
+struct PlantParameters
+{
+    /** Electrical power of the heater when on, in watts. */
+    double heater_power_w;
+
+    /** Heat capacity of the heating element, in joules per kelvin. */
+    double heater_capacity_j_per_k;
+
+    /** Conductance from the heating element to the air, in watts per kelvin. */
+    double heater_to_air_w_per_k;
+
+    /** Heat capacity of the air and enclosure walls, in joules per kelvin. */
+    double air_capacity_j_per_k;
+
+    /** Conductance from the air to the ambient surroundings, in watts per kelvin. */
+    double air_to_ambient_w_per_k;
+
+    /** Mass of the filament spool, in kilograms. */
+    double spool_mass_kg;
+
+    /** Specific heat of the filament, in joules per kilogram kelvin. */
+    double spool_specific_heat_j_per_kg_k;
+
+    /** Conductance from the air to the spool, in watts per kelvin. */
+    double air_to_spool_w_per_k;
+
+    /** Ambient temperature, in degrees Celsius. */
+    double ambient_temperature_c;
+
+    /** Ambient relative humidity, in percent. */
+    double ambient_humidity_percent;
+};
+
+/**
+ * Returns parameters for a small insulated box with a 150 W heater and a 1 kg spool of PLA.
+ */
+PlantParameters defaultPlantParameters();
+
+/**
+ * A lumped thermal model of the dryer: the heating element, the air and walls of the enclosure, and the spool, each
+ * at a single temperature, with heat flowing between them and out to the ambient surroundings.
+ */
+class ThermalPlant
+{
+public:
+    /**
+     * Constructor. The plant starts at ambient temperature.
+     *
+     * @param[in] parameters The physical parameters of the enclosure.
+     */
+    explicit ThermalPlant(const PlantParameters& parameters);
+
+    /**
+     * @return The air temperature in degrees Celsius, as seen by the sensor.
+     */
+    double airTemperature() const;
+
+    /**
+     * @return The spool temperature in degrees Celsius.
+     */
+    double spoolTemperature() const;
+
+    /**
+     * Approximates the relative humidity of the air, assuming no moisture enters or leaves the enclosure.
+     *
+     * @return The relative humidity in percent.
+     */
+    double relativeHumidity() const;
+
+    /**
+     * @return The electrical energy used by the heater so far, in joules.
+     */
+    double energy() const;
+
+    /**
+     * Advances the model.
+     *
+     * @param[in] heater_on True if the heater is powered, false otherwise.
+     * @param[in] elapsed_s The time to advance by in seconds.
+     */
+    void step(bool heater_on, double elapsed_s);
+
+private:
+    PlantParameters _parameters;
+    double _heater_temperature;
+    double _air_temperature;
+    double _spool_temperature;
+    double _energy;
+};
+} // namespace host
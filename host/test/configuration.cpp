@@ -0,0 +1,23 @@
+/*------------------------------------------------------------------------------
+Copyright (c) 2023 Joe Porembski
+SPDX-License-Identifier: BSD-3-Clause
+------------------------------------------------------------------------------*/
+#include "fixtures.hpp"
+#include "hal.hpp"
+#include "test.hpp"
+
+#include "utilities.hpp"
+
+
+using namespace fixtures;
+
+TEST_CASE(configurationReads)
+{
+    SystemConfiguration cfg;
+    EXPECT(host::loadConfiguration(serializedConfiguration()));
+    EXPECT(read(cfg));
+    EXPECT(cfg.ssid() == CONFIGURATION_STRINGS[0]);
+    EXPECT(cfg.passphrase() == CONFIGURATION_STRINGS[1]);
+    EXPECT(cfg.mqttBroker() == CONFIGURATION_STRINGS[2]);
+    EXPECT(cfg.deviceName() == CONFIGURATION_STRINGS[3]);
+}
@@ -0,0 +1,248 @@
+/*------------------------------------------------------------------------------
+Copyright (c) 2023 Joe Porembski
+SPDX-License-Identifier: BSD-3-Clause
+------------------------------------------------------------------------------*/
+#include "fixtures.hpp"
+#include "hal.hpp"
+#include "test.hpp"
+
+#include "controllers/autotune.hpp"
+#include "controllers/heater.hpp"
+#include "controllers/pid.hpp"
+#include "controllers/profile.hpp"
+#include "measurement.hpp"
+
+#include <cstdint>
+#include <string_view>
+
+
+using namespace fixtures;
+
+inline constexpr uint64_t MS_PER_SECOND = 1000;
+inline constexpr Centidegrees AUTOTUNE_SETPOINT = toCenti(50);
+inline constexpr Centidegrees AUTOTUNE_STEP = 10;
+inline constexpr Sample HUMID = {toCenti(40), SampleQuality::GOOD, 0};
+
+/**
+ * Switches @a heater off with a reading above its cut-off, so that none of its alarms outlive it.
+ */
+static void switchOff(controllers::Heater& heater)
+{
+    heater.update(Sample{toCenti(100), SampleQuality::GOOD, 0});
+}
+
+TEST_CASE(heaterFollowsHysteresis)
+{
+    controllers::Heater heater(HEATER_CONTROL_PIN, HEATER_FEEDBACK_PIN, HEATER_HYSTERESIS, HEATER_MAX_ON_TIME_MS);
+    heater.setTargetTemperature(toCenti(50));
+
+    // Start well clear of the minimum off time, which is measured from boot.
+    host::advanceClock(HEATER_MAX_ON_TIME_MS * US_PER_MS);
+    heater.update(Sample{toCenti(20), SampleQuality::GOOD, 0});
+    EXPECT(heater.isOn());
+    host::advanceClock(CONTROL_PERIOD_US);
+    heater.update(Sample{toCenti(51), SampleQuality::GOOD, 0});
+    EXPECT(heater.isOn());
+    host::advanceClock(CONTROL_PERIOD_US);
+    heater.update(Sample{toCenti(60), SampleQuality::GOOD, 0});
+    EXPECT(!heater.isOn());
+}
+
+TEST_CASE(heaterCutsOffWhenUpdatesStop)
+{
+    controllers::Heater heater(HEATER_CONTROL_PIN, HEATER_FEEDBACK_PIN, HEATER_HYSTERESIS, HEATER_MAX_ON_TIME_MS);
+    heater.setTargetTemperature(toCenti(50));
+    host::advanceClock(HEATER_MAX_ON_TIME_MS * US_PER_MS);
+    heater.update(Sample{toCenti(20), SampleQuality::GOOD, 0});
+    EXPECT(heater.isOn());
+
+    // The guard timer switches the pin off without an update, and the next update notices.
+    host::advanceClock(HEATER_MAX_ON_TIME_MS * US_PER_MS / 2);
+    EXPECT(!host::pinState(HEATER_CONTROL_PIN));
+    heater.update(Sample{toCenti(20), SampleQuality::GOOD, 0});
+    EXPECT(!heater.isOn());
+    switchOff(heater);
+}
+
+TEST_CASE(heaterCutsOffOverTemperatureInAnyMode)
+{
+    controllers::Heater heater(HEATER_CONTROL_PIN, HEATER_FEEDBACK_PIN, HEATER_HYSTERESIS, HEATER_MAX_ON_TIME_MS);
+    heater.setTargetTemperature(toCenti(50));
+    heater.setMode(controllers::HeaterMode::PID);
+    host::advanceClock(HEATER_MAX_ON_TIME_MS * US_PER_MS);
+    heater.update(Sample{toCenti(20), SampleQuality::GOOD, 0});
+    EXPECT(heater.isOn());
+
+    // The first reading past the margin switches it off mid-window, whatever the PID output.
+    host::advanceClock(CONTROL_PERIOD_US);
+    heater.update(Sample{toCenti(61), SampleQuality::GOOD, 0});
+    EXPECT(!heater.isOn());
+    EXPECT(!host::pinState(HEATER_CONTROL_PIN));
+}
+
+TEST_CASE(pidProportionalAndDerivative)
+{
+    controllers::PID proportional({toCenti(10), 0, 0});
+    EXPECT(proportional.update(toCenti(50), toCenti(49), 0) == toCenti(10));
+    EXPECT(proportional.update(toCenti(50), toCenti(40), 1000) == toCenti(100));
+    EXPECT(proportional.update(toCenti(50), toCenti(60), 2000) == 0);
+
+    // The derivative acts on the measurement: a fall of 1C over Td pushes the output up by Kp.
+    controllers::PID derivative({toCenti(10), 0, 1000});
+    EXPECT(derivative.update(toCenti(50), toCenti(50), 0) == 0);
+    EXPECT(derivative.update(toCenti(50), toCenti(49), 1000) == toCenti(20));
+}
+
+TEST_CASE(pidIntegralDoesNotWindUp)
+{
+    controllers::PID pid({toCenti(10), 1000, 0});
+    for (uint64_t timepoint = 0; timepoint < 100 * MS_PER_SECOND; timepoint += MS_PER_SECOND) {
+        EXPECT(pid.update(toCenti(50), toCenti(20), timepoint) == toCenti(100));
+    }
+
+    // Had the integral kept growing while saturated, the output would stay at 100% long after the error went away.
+    EXPECT(pid.update(toCenti(50), toCenti(50), 100 * MS_PER_SECOND) == 0);
+
+    // The integral builds up below saturation, at Kp per Ti for each degree of error.
+    pid.reset();
+    EXPECT(pid.update(toCenti(50), toCenti(49), 0) == toCenti(10));
+    EXPECT(pid.update(toCenti(50), toCenti(49), 1000) == toCenti(20));
+}
+
+TEST_CASE(relayAutotuneDerivesGains)
+{
+    // A container which warms and cools by a fixed step each second, so it oscillates around the setpoint.
+    controllers::RelayAutotune autotune;
+    autotune.begin(AUTOTUNE_SETPOINT, 0);
+    Centidegrees temperature = AUTOTUNE_SETPOINT;
+    bool heater_on = false;
+    for (uint64_t timepoint = MS_PER_SECOND; autotune.state() == controllers::AutotuneState::RUNNING; timepoint += MS_PER_SECOND) {
+        temperature += heater_on ? AUTOTUNE_STEP : -AUTOTUNE_STEP;
+        heater_on = autotune.update(temperature, timepoint);
+    }
+
+    // The relay switches 10 past each edge of the 50 noise band, so each half cycle crosses 120 in 12 seconds.
+    EXPECT(autotune.state() == controllers::AutotuneState::SUCCEEDED);
+    EXPECT(autotune.gains().integral_time_ms == 12 * MS_PER_SECOND);
+    EXPECT(autotune.gains().derivative_time_ms == 3 * MS_PER_SECOND);
+    EXPECT(autotune.gains().proportional > 0);
+}
+
+TEST_CASE(relayAutotuneTimesOut)
+{
+    controllers::RelayAutotune autotune;
+    autotune.begin(AUTOTUNE_SETPOINT, 0);
+    EXPECT(autotune.update(toCenti(20), MS_PER_SECOND));
+    EXPECT(!autotune.update(toCenti(20), 5 * 60 * 60 * MS_PER_SECOND));
+    EXPECT(autotune.state() == controllers::AutotuneState::FAILED);
+}
+
+TEST_CASE(heaterAutotuneFailsWhenCutOff)
+{
+    controllers::Heater heater(HEATER_CONTROL_PIN, HEATER_FEEDBACK_PIN, HEATER_HYSTERESIS, HEATER_MAX_ON_TIME_MS);
+    heater.setTargetTemperature(AUTOTUNE_SETPOINT);
+    heater.setMode(controllers::HeaterMode::AUTOTUNE);
+    host::advanceClock(HEATER_MAX_ON_TIME_MS * US_PER_MS);
+
+    // Warm up past the setpoint, then cool below it to start the first measured cycle.
+    heater.update(Sample{toCenti(20), SampleQuality::GOOD, 0});
+    EXPECT(heater.isOn());
+    host::advanceClock(CONTROL_PERIOD_US);
+    heater.update(Sample{toCenti(51), SampleQuality::GOOD, 0});
+    EXPECT(!heater.isOn());
+    host::advanceClock(HEATER_MAX_ON_TIME_MS * US_PER_MS);
+    heater.update(Sample{toCenti(49), SampleQuality::GOOD, 0});
+    EXPECT(heater.isOn());
+
+    // A container which never warms back up holds the relay on until the maximum on time cuts it off, which would time
+    // the cycle from the limit rather than the container, so the auto-tune fails instead.
+    for (uint64_t elapsed_us = 0; elapsed_us <= 2 * HEATER_MAX_ON_TIME_MS * US_PER_MS; elapsed_us += CONTROL_PERIOD_US) {
+        host::advanceClock(CONTROL_PERIOD_US);
+        heater.update(Sample{toCenti(49), SampleQuality::GOOD, 0});
+    }
+    EXPECT(heater.autotuneState() == controllers::AutotuneState::FAILED);
+    EXPECT(heater.mode() == controllers::HeaterMode::HYSTERESIS);
+    switchOff(heater);
+}
+
+TEST_CASE(profileFromString)
+{
+    controllers::Profile profile;
+    EXPECT(controllers::fromString("pla", profile));
+    EXPECT(std::string_view(profile.name) == "pla");
+    EXPECT(profile.segment_count == 2);
+    EXPECT(profile.segments[0].target == toCenti(45));
+
+    EXPECT(controllers::fromString("50,900,3600;70,1200.5,43200,5", profile));
+    EXPECT(std::string_view(profile.name) == "custom");
+    EXPECT(profile.segment_count == 2);
+    EXPECT(profile.segments[0].target == toCenti(50));
+    EXPECT(profile.segments[0].ramp_ms == 900 * MS_PER_SECOND);
+    EXPECT(profile.segments[0].soak_ms == 3600 * MS_PER_SECOND);
+    EXPECT(profile.segments[0].dry_humidity == 0);
+    EXPECT(profile.segments[1].ramp_ms == 1200500);
+    EXPECT(profile.segments[1].dry_humidity == toCenti(5));
+
+    EXPECT(!controllers::fromString("", profile));
+    EXPECT(!controllers::fromString("50,900", profile));
+    EXPECT(!controllers::fromString("50,900,3600,5,1", profile));
+    EXPECT(!controllers::fromString("50,-900,3600", profile));
+    EXPECT(!controllers::fromString("50,900,3600,101", profile));
+    EXPECT(!controllers::fromString("1;1;1;1;1;1;1;1;1", profile));
+    EXPECT(!controllers::fromString("1,1,1;1,1,1;1,1,1;1,1,1;1,1,1;1,1,1;1,1,1;1,1,1;1,1,1", profile));
+    EXPECT(controllers::fromString("1,1,1;1,1,1;1,1,1;1,1,1;1,1,1;1,1,1;1,1,1;1,1,1", profile));
+}
+
+TEST_CASE(profileRunnerNamesIdleProfile)
+{
+    // The name is published and encoded as text, so it must never be null, even before a profile has run.
+    controllers::ProfileRunner runner;
+    EXPECT(runner.profile().name != nullptr);
+    EXPECT(std::string_view(runner.profile().name) == "none");
+    EXPECT(runner.profile().segment_count == 0);
+}
+
+TEST_CASE(profileRunnerSteps)
+{
+    controllers::Profile profile;
+    controllers::fromString("50,100,100;60,0,100,5", profile);
+    controllers::ProfileRunner runner;
+    EXPECT(runner.start(profile, toCenti(20), 0));
+    EXPECT(runner.remaining() == 300 * MS_PER_SECOND);
+
+    // The ramp moves in whole steps of half a degree.
+    Sample temperature = {toCenti(20), SampleQuality::GOOD, 0};
+    EXPECT(runner.update(temperature, HUMID, 50 * MS_PER_SECOND));
+    EXPECT(runner.setpoint() == toCenti(35));
+    EXPECT(runner.progress() == toCenti(50) / 3);
+    runner.update(temperature, HUMID, 150 * MS_PER_SECOND);
+    EXPECT(runner.setpoint() == toCenti(50));
+
+    // The second segment has no ramp, and soaks for its full time while the container is not dry.
+    runner.update(temperature, HUMID, 200 * MS_PER_SECOND);
+    EXPECT(runner.segment() == 1);
+    EXPECT(runner.setpoint() == toCenti(60));
+    EXPECT(runner.update(temperature, HUMID, 300 * MS_PER_SECOND));
+    EXPECT(runner.state() == controllers::ProfileState::COMPLETE);
+    EXPECT(runner.progress() == toCenti(100));
+    EXPECT(runner.remaining() == 0);
+}
+
+TEST_CASE(profileRunnerEndsSoakWhenDry)
+{
+    controllers::Profile profile;
+    controllers::fromString("50,0,36000,5", profile);
+    controllers::ProfileRunner runner;
+    runner.start(profile, toCenti(50), 0);
+
+    // Dry air alone is not enough, the container must also be at the target.
+    Sample dry = {toCenti(4), SampleQuality::GOOD, 0};
+    Sample cold = {toCenti(30), SampleQuality::GOOD, 0};
+    Sample warm = {toCenti(50), SampleQuality::GOOD, 0};
+    runner.update(cold, dry, 0);
+    runner.update(cold, dry, 3600 * MS_PER_SECOND);
+    EXPECT(runner.state() == controllers::ProfileState::RUNNING);
+    runner.update(warm, dry, 3600 * MS_PER_SECOND);
+    runner.update(warm, dry, 5400 * MS_PER_SECOND);
+    EXPECT(runner.state() == controllers::ProfileState::COMPLETE);
+}
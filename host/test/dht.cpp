@@ -0,0 +1,174 @@
+/*------------------------------------------------------------------------------
+Copyright (c) 2023 Joe Porembski
+SPDX-License-Identifier: BSD-3-Clause
+------------------------------------------------------------------------------*/
+#include "fixtures.hpp"
+#include "test.hpp"
+
+#include "measurement.hpp"
+#include "sensors/detail/dht-edge-capture.hpp"
+#include "sensors/detail/dht-frame.hpp"
+#include "sensors/dht-format.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+
+using namespace fixtures;
+
+/*
+ * Edge traces of whole reads, in the form DHTEdgeCapture records them: the rising edge as the host releases the line,
+ * the sensor's response, 40 data bits, and the rising edge as the sensor releases the line at the end.
+ */
+
+/** A DHT22 on a short lead reading 48.7% and 23.4C, with 0 bits of 23-29 us and 1 bits of 68-74 us. */
+inline constexpr std::array<sensors::detail::DHTEdge, 85> SHORT_LEAD_TRACE = {{
+    {0, true}, {30, false}, {109, true}, {191, false}, {240, true}, {265, false}, {314, true}, {340, false},
+    {395, true}, {421, false}, {475, true}, {504, false}, {555, true}, {578, false}, {633, true}, {656, false},
+    {710, true}, {736, false}, {784, true}, {857, false}, {912, true}, {982, false}, {1033, true}, {1105, false},
+    {1154, true}, {1224, false}, {1272, true}, {1295, false}, {1343, true}, {1371, false}, {1419, true},
+    {1490, false}, {1541, true}, {1612, false}, {1660, true}, {1732, false}, {1783, true}, {1812, false},
+    {1867, true}, {1893, false}, {1944, true}, {1969, false}, {2020, true}, {2048, false}, {2099, true},
+    {2128, false}, {2183, true}, {2208, false}, {2256, true}, {2282, false}, {2331, true}, {2355, false},
+    {2407, true}, {2475, false}, {2528, true}, {2601, false}, {2655, true}, {2727, false}, {2778, true},
+    {2803, false}, {2855, true}, {2927, false}, {2982, true}, {3011, false}, {3065, true}, {3137, false},
+    {3185, true}, {3211, false}, {3262, true}, {3335, false}, {3389, true}, {3460, false}, {3510, true},
+    {3535, false}, {3588, true}, {3656, false}, {3711, true}, {3739, false}, {3788, true}, {3817, false},
+    {3867, true}, {3939, false}, {3993, true}, {4018, false}, {4073, true}
+}};
+inline constexpr sensors::detail::DHTFrame SHORT_LEAD_FRAME = {0x01, 0xE7, 0x00, 0xEA, 0xD2};
+
+/** A DHT22 on a long cable reading 61.2% and 41.5C, whose 0 bits of 44-52 us run close to the 1 bits of 60-68 us. */
+inline constexpr std::array<sensors::detail::DHTEdge, 85> LONG_CABLE_TRACE = {{
+    {0, true}, {30, false}, {114, true}, {198, false}, {238, true}, {283, false}, {324, true}, {373, false},
+    {415, true}, {463, false}, {507, true}, {554, false}, {594, true}, {640, false}, {686, true}, {736, false},
+    {781, true}, {849, false}, {896, true}, {948, false}, {992, true}, {1036, false}, {1076, true}, {1141, false},
+    {1188, true}, {1253, false}, {1299, true}, {1349, false}, {1391, true}, {1443, false}, {1485, true},
+    {1548, false}, {1591, true}, {1635, false}, {1677, true}, {1726, false}, {1768, true}, {1814, false},
+    {1859, true}, {1911, false}, {1953, true}, {2004, false}, {2050, true}, {2102, false}, {2147, true},
+    {2196, false}, {2241, true}, {2292, false}, {2334, true}, {2384, false}, {2431, true}, {2499, false},
+    {2542, true}, {2609, false}, {2653, true}, {2704, false}, {2749, true}, {2800, false}, {2847, true},
+    {2912, false}, {2959, true}, {3026, false}, {3069, true}, {3134, false}, {3176, true}, {3240, false},
+    {3287, true}, {3351, false}, {3395, true}, {3447, false}, {3493, true}, {3541, false}, {3584, true},
+    {3635, false}, {3680, true}, {3725, false}, {3770, true}, {3814, false}, {3857, true}, {3918, false},
+    {3958, true}, {4018, false}, {4062, true}, {4109, false}, {4150, true}
+}};
+inline constexpr sensors::detail::DHTFrame LONG_CABLE_FRAME = {0x02, 0x64, 0x01, 0x9F, 0x06};
+
+/** The two 20-bit words the PIO program pushes for SHORT_LEAD_FRAME, first transmitted bit most significant. */
+inline constexpr std::array<uint32_t, 2> SHORT_LEAD_PIO_WORDS = {0x01E70, 0x0EAD2};
+inline constexpr uint8_t PIO_WORD_BITS = 20;
+
+/**
+ * Decodes the first @a edge_count edges of @a trace.
+ *
+ * @return True if a full frame was decoded, false otherwise.
+ */
+template <size_t N>
+static bool decodeTrace(const std::array<sensors::detail::DHTEdge, N>& trace,
+                        size_t edge_count,
+                        sensors::detail::DHTFrame& frame,
+                        sensors::detail::DHTTiming& timing)
+{
+    sensors::detail::DHTFrameBuilder builder;
+    if (!sensors::detail::decode(trace.data(), edge_count, builder, timing)) {
+        return false;
+    }
+
+    frame = builder.frame();
+    return true;
+}
+
+TEST_CASE(dhtFrameDecodes)
+{
+    Centidegrees temperature = 0;
+    Centipercent humidity = 0;
+    EXPECT(decodeDHT(dhtEdges(DHT_FRAME), temperature, humidity));
+    EXPECT(temperature == DHT_FRAME_TEMPERATURE);
+    EXPECT(humidity == DHT_FRAME_HUMIDITY);
+}
+
+TEST_CASE(dhtFrameParityIsChecked)
+{
+    sensors::detail::DHTFrame frame = DHT_FRAME;
+    frame[4]++;
+    Centidegrees temperature = 0;
+    Centipercent humidity = 0;
+    EXPECT(!decodeDHT(dhtEdges(frame), temperature, humidity));
+}
+
+TEST_CASE(dhtShortLeadTraceDecodes)
+{
+    sensors::detail::DHTFrame frame = {};
+    sensors::detail::DHTTiming timing = {};
+    EXPECT(decodeTrace(SHORT_LEAD_TRACE, SHORT_LEAD_TRACE.size(), frame, timing));
+    EXPECT(frame == SHORT_LEAD_FRAME);
+    EXPECT(sensors::detail::hasValidParity(frame));
+    EXPECT(timing.edge_count == SHORT_LEAD_TRACE.size());
+    EXPECT(sensors::detail::DHTEdgeCapture::EXPECTED_EDGES == SHORT_LEAD_TRACE.size());
+    EXPECT(timing.zero_mean_us >= 23 && timing.zero_mean_us <= 29);
+    EXPECT(timing.one_mean_us >= 68 && timing.one_mean_us <= 74);
+    EXPECT(timing.threshold_us > 29 && timing.threshold_us < 68);
+
+    Centidegrees temperature = 0;
+    Centipercent humidity = 0;
+    DHTFormat<DHTType::DHT22>::parse(frame, temperature, humidity);
+    EXPECT(temperature == 2340);
+    EXPECT(humidity == 4870);
+}
+
+TEST_CASE(dhtLongCableTraceDecodes)
+{
+    // A fixed 48 us threshold would read the longer of these 0 bits as 1 bits; the clustered threshold does not.
+    sensors::detail::DHTFrame frame = {};
+    sensors::detail::DHTTiming timing = {};
+    EXPECT(decodeTrace(LONG_CABLE_TRACE, LONG_CABLE_TRACE.size(), frame, timing));
+    EXPECT(frame == LONG_CABLE_FRAME);
+    EXPECT(sensors::detail::hasValidParity(frame));
+    EXPECT(timing.threshold_us > 52 && timing.threshold_us < 60);
+    EXPECT(timing.margin_us > 0);
+}
+
+TEST_CASE(dhtTruncatedTraceFails)
+{
+    sensors::detail::DHTFrame frame = {};
+    sensors::detail::DHTTiming timing = {};
+    EXPECT(!decodeTrace(SHORT_LEAD_TRACE, SHORT_LEAD_TRACE.size() - 10, frame, timing));
+    EXPECT(!decodeTrace(SHORT_LEAD_TRACE, 0, frame, timing));
+    EXPECT(timing.edge_count == 0);
+}
+
+TEST_CASE(dhtPIOWordsBuildFrame)
+{
+    sensors::detail::DHTFrameBuilder builder;
+    builder.push(SHORT_LEAD_PIO_WORDS[0], PIO_WORD_BITS);
+    EXPECT(builder.bitCount() == PIO_WORD_BITS);
+    EXPECT(!builder.complete());
+
+    // A partial frame is left aligned, so the bytes received so far are already in place.
+    sensors::detail::DHTFrame partial = builder.frame();
+    EXPECT(partial[0] == 0x01 && partial[1] == 0xE7 && partial[2] == 0x00);
+
+    builder.push(SHORT_LEAD_PIO_WORDS[1], PIO_WORD_BITS);
+    EXPECT(builder.complete());
+    EXPECT(builder.frame() == SHORT_LEAD_FRAME);
+
+    // Bits past a full frame, such as a stray word left in the FIFO, are ignored.
+    builder.push(0xFFFFF, PIO_WORD_BITS);
+    EXPECT(builder.frame() == SHORT_LEAD_FRAME);
+
+    // The edge path and the PIO path build the same frame from the same read.
+    sensors::detail::DHTFrame decoded = {};
+    sensors::detail::DHTTiming timing = {};
+    EXPECT(decodeTrace(SHORT_LEAD_TRACE, SHORT_LEAD_TRACE.size(), decoded, timing));
+    EXPECT(decoded == builder.frame());
+
+    // Pushing the same bits one at a time, as the software capture does, builds the same frame too.
+    builder.reset();
+    for (size_t bit = 0; bit < sensors::detail::DHT_FRAME_BITS; bit++) {
+        uint32_t word = SHORT_LEAD_PIO_WORDS[bit / PIO_WORD_BITS];
+        builder.push(static_cast<bool>((word >> (PIO_WORD_BITS - 1 - (bit % PIO_WORD_BITS))) & 1));
+    }
+    EXPECT(builder.frame() == SHORT_LEAD_FRAME);
+}
@@ -0,0 +1,147 @@
+/*------------------------------------------------------------------------------
+Copyright (c) 2023 Joe Porembski
+SPDX-License-Identifier: BSD-3-Clause
+------------------------------------------------------------------------------*/
+#include "test.hpp"
+
+#include "history.hpp"
+
+#include <sys/time.h>
+
+#include <array>
+#include <csignal>
+#include <cstdint>
+
+
+inline constexpr uint32_t HISTORY_STRESS_WRITES = 5000000;
+inline constexpr suseconds_t HISTORY_STRESS_INTERVAL_US = 20;
+
+/**
+ * @return A record identified by @a timepoint.
+ */
+static HistoryRecord record(uint32_t timepoint)
+{
+    return HistoryRecord{timepoint, 0, 0, 0, 0};
+}
+
+TEST_CASE(historyPeeksAndPops)
+{
+    HistoryRing history;
+    std::array<HistoryRecord, 4> records;
+    for (uint32_t timepoint = 0; timepoint < 6; timepoint++) {
+        history.push(record(timepoint));
+    }
+
+    uint32_t end = history.end();
+    EXPECT(history.pending(end) == 6);
+    EXPECT(history.peek(end, records.data(), records.size()) == 4);
+    EXPECT(records[0].timepoint == 0 && records[3].timepoint == 3);
+
+    // A peek does not consume, so a failed send can be retried.
+    history.pop(2);
+    EXPECT(history.peek(end, records.data(), records.size()) == 4);
+    EXPECT(records[0].timepoint == 2 && records[3].timepoint == 5);
+    history.skip(end);
+    EXPECT(history.pending(end) == 0);
+    EXPECT(history.dropped() == 0);
+}
+
+TEST_CASE(historyLapCountsDropped)
+{
+    // Once the writer laps the reader, the oldest records are overwritten and counted as dropped.
+    HistoryRing history;
+    std::array<HistoryRecord, 4> records;
+    uint32_t written = HistoryRing::CAPACITY + 10;
+    for (uint32_t timepoint = 0; timepoint < written; timepoint++) {
+        history.push(record(timepoint));
+    }
+
+    uint32_t end = history.end();
+    EXPECT(history.peek(end, records.data(), records.size()) == records.size());
+    EXPECT(records[0].timepoint == written - HistoryRing::CAPACITY + 1);
+    EXPECT(history.dropped() == written - HistoryRing::CAPACITY + 1);
+    EXPECT(history.pending(end) == HistoryRing::CAPACITY - 1);
+
+    // A position which has already been dropped has nothing pending.
+    EXPECT(history.pending(end - HistoryRing::CAPACITY) == 0);
+}
+
+/**
+ * @return A record whose every field is derived from @a timepoint, so a record torn by a concurrent write is detectable.
+ */
+static HistoryRecord stampedRecord(uint32_t timepoint)
+{
+    return HistoryRecord{timepoint,
+                         static_cast<Centidegrees>(timepoint),
+                         static_cast<Centipercent>(~timepoint),
+                         static_cast<Centidegrees>(timepoint >> 16),
+                         static_cast<uint8_t>(timepoint)};
+}
+
+static HistoryRing* lapped_history;
+static volatile sig_atomic_t next_timepoint;
+
+/**
+ * Laps the ring from a timer signal, which lands at any point in the reader's work, including part way through a peek.
+ * It stops once HISTORY_STRESS_WRITES have been made, so a peek which keeps being lapped is left to finish.
+ */
+static void lapHistory(int /* signal */)
+{
+    for (uint32_t count = 0; count < HistoryRing::CAPACITY && static_cast<uint32_t>(next_timepoint) <= HISTORY_STRESS_WRITES; count++) {
+        lapped_history->push(stampedRecord(static_cast<uint32_t>(next_timepoint)));
+        next_timepoint = next_timepoint + 1;
+    }
+}
+
+/*
+ * Drains the ring while the writer laps it over and over, as the control loop does during a long outage. The writer is
+ * a timer signal rather than a thread, so it interrupts peek() part way through its copy even on a single core. Every
+ * record peek() returns must be whole and follow on from the last, and every record must be read or counted as dropped.
+ */
+TEST_CASE(historyPeekSurvivesLaps)
+{
+    HistoryRing history;
+    std::array<HistoryRecord, HistoryRing::CAPACITY> records;
+    lapped_history = &history;
+    next_timepoint = 1;
+
+    struct sigaction action = {};
+    struct sigaction previous_action = {};
+    action.sa_handler = lapHistory;
+    sigaction(SIGALRM, &action, &previous_action);
+    itimerval interval = {{0, HISTORY_STRESS_INTERVAL_US}, {0, HISTORY_STRESS_INTERVAL_US}};
+    itimerval previous_interval = {};
+    setitimer(ITIMER_REAL, &interval, &previous_interval);
+
+    uint32_t last_timepoint = 0;
+    uint32_t read = 0;
+    bool consistent = true;
+    while (static_cast<uint32_t>(next_timepoint) <= HISTORY_STRESS_WRITES) {
+        uint32_t count = history.peek(history.end(), records.data(), records.size());
+        if (count == 0) {
+            continue;
+        }
+
+        for (uint32_t index = 0; index < count; index++) {
+            HistoryRecord expected = stampedRecord(records[0].timepoint + index);
+            const HistoryRecord& actual = records[index];
+            consistent = consistent && actual.timepoint == expected.timepoint && actual.temperature == expected.temperature
+                         && actual.humidity == expected.humidity && actual.target_temperature == expected.target_temperature
+                         && actual.flags == expected.flags;
+        }
+        consistent = consistent && records[0].timepoint > last_timepoint;
+        last_timepoint = records[count - 1].timepoint;
+        history.pop(count);
+        read += count;
+    }
+
+    setitimer(ITIMER_REAL, &previous_interval, nullptr);
+    sigaction(SIGALRM, &previous_action, nullptr);
+    uint32_t written = static_cast<uint32_t>(next_timepoint) - 1;
+    read += history.peek(history.end(), records.data(), records.size());
+    history.skip(history.end());
+
+    EXPECT(consistent);
+    EXPECT(read > 0);
+    EXPECT(read + history.dropped() == written);
+}
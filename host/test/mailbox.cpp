@@ -0,0 +1,65 @@
+/*------------------------------------------------------------------------------
+Copyright (c) 2023 Joe Porembski
+SPDX-License-Identifier: BSD-3-Clause
+------------------------------------------------------------------------------*/
+#include "fixtures.hpp"
+#include "test.hpp"
+
+#include "mailbox.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+
+using namespace fixtures;
+
+inline constexpr uint32_t MAILBOX_STRESS_WRITES = 2000000;
+inline constexpr uint8_t MAILBOX_STRESS_READERS = 2;
+
+/*
+ * Hammers a mailbox from a writer thread and several reader threads at once, as the two cores would, checking every read
+ * is a whole value from a single write and that no reader ever goes back in time.
+ */
+TEST_CASE(mailboxReadsAreWhole)
+{
+    Mailbox<MailboxValue> mailbox;
+    std::atomic<bool> writing(true);
+    std::atomic<bool> consistent(true);
+
+    auto reader = [&]() {
+        uint32_t last_version = 0;
+        MailboxValue value;
+        while (writing.load(std::memory_order_relaxed)) {
+            uint32_t version = mailbox.read(value);
+            if (version == 0) {
+                continue;
+            }
+
+            bool whole = std::all_of(value.words.cbegin(), value.words.cend(), [&](uint32_t word) { return word == version; });
+            if (!whole || version < last_version) {
+                consistent = false;
+            }
+            last_version = version;
+        }
+    };
+
+    std::vector<std::thread> readers;
+    for (uint8_t i = 0; i < MAILBOX_STRESS_READERS; i++) {
+        readers.emplace_back(reader);
+    }
+    for (uint32_t version = 1; version <= MAILBOX_STRESS_WRITES; version++) {
+        mailbox.write(mailboxValue(version));
+    }
+    writing = false;
+    for (std::thread& thread : readers) {
+        thread.join();
+    }
+
+    MailboxValue value;
+    EXPECT(consistent);
+    EXPECT(mailbox.read(value) == MAILBOX_STRESS_WRITES);
+    EXPECT(value.words[0] == MAILBOX_STRESS_WRITES);
+}
@@ -0,0 +1,89 @@
+/*------------------------------------------------------------------------------
+Copyright (c) 2023 Joe Porembski
+SPDX-License-Identifier: BSD-3-Clause
+------------------------------------------------------------------------------*/
+#include "hal.hpp"
+#include "test.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <string_view>
+#include <vector>
+
+
+/*
+ * Runs the host tests of the firmware's platform independent code: every test case, or those named on the command line.
+ */
+
+/**
+ * A registered test case.
+ */
+struct TestCase
+{
+    /** The name used to select the test case. */
+    std::string_view name;
+
+    /** Runs the test case. */
+    void (*run)();
+};
+
+static uint32_t failed_checks = 0;
+
+/**
+ * @return The registered test cases, in the order they were registered.
+ */
+static std::vector<TestCase>& testCases()
+{
+    // Function local, so that it is constructed before the registrations in other files which use it.
+    static std::vector<TestCase> test_cases;
+    return test_cases;
+}
+
+namespace test {
+Registration::Registration(std::string_view name, void (*run)())
+{
+    testCases().push_back({name, run});
+}
+
+void check(bool passed, const char* expression, const char* file, int line)
+{
+    if (!passed) {
+        failed_checks++;
+        fprintf(stderr, "%s:%d: expected %s\n", file, line, expression);
+    }
+}
+} // namespace test
+
+int main(int argc, char** argv)
+{
+    std::vector<std::string_view> selected(argv + 1, argv + argc);
+    uint32_t run = 0;
+    uint32_t failed = 0;
+    for (const TestCase& test_case : testCases()) {
+        if (!selected.empty() && std::find(selected.cbegin(), selected.cend(), test_case.name) == selected.cend()) {
+            continue;
+        }
+
+        // The firmware logs liberally; only failures, which go to stderr, are of interest here.
+        uint32_t failed_before = failed_checks;
+        host::silenceOutput();
+        test_case.run();
+        host::restoreOutput();
+
+        run++;
+        bool passed = failed_checks == failed_before;
+        failed += passed ? 0 : 1;
+        printf("%-40s %s\n", test_case.name.data(), passed ? "passed" : "FAILED");
+    }
+
+    if (run == 0) {
+        printf("Usage: %s [NAME]...\n", argv[0]);
+        printf("  Runs the named test cases, or all of them if none are named\n");
+        return EXIT_FAILURE;
+    }
+
+    printf("%u of %u test cases passed\n", run - failed, run);
+    return failed == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
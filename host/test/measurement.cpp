@@ -0,0 +1,58 @@
+/*------------------------------------------------------------------------------
+Copyright (c) 2023 Joe Porembski
+SPDX-License-Identifier: BSD-3-Clause
+------------------------------------------------------------------------------*/
+#include "test.hpp"
+
+#include "measurement.hpp"
+
+#include <cstdint>
+
+
+TEST_CASE(parseCentiAcceptsDecimals)
+{
+    int32_t value = 0;
+    EXPECT(parseCenti("45", value) && value == 4500);
+    EXPECT(parseCenti("-3.5", value) && value == -350);
+    EXPECT(parseCenti("+45.25", value) && value == 4525);
+    EXPECT(parseCenti("0.05", value) && value == 5);
+    EXPECT(parseCenti(".5", value) && value == 50);
+    EXPECT(parseCenti("12.349", value) && value == 1234);
+}
+
+TEST_CASE(parseCentiRangeLimits)
+{
+    int32_t value = 0;
+    EXPECT(parseCenti("21474836.47", value) && value == INT32_MAX);
+    EXPECT(parseCenti("-21474836.47", value) && value == -INT32_MAX);
+    EXPECT(parseCenti("21474836.479", value) && value == INT32_MAX);
+    EXPECT(parseCenti("21474836", value) && value == 2147483600);
+    EXPECT(!parseCenti("21474836.48", value));
+    EXPECT(!parseCenti("-21474836.48", value));
+    EXPECT(!parseCenti("21474837", value));
+    EXPECT(!parseCenti("21474839", value));
+    EXPECT(!parseCenti("214748360", value));
+}
+
+TEST_CASE(parseSecondsToMilliseconds)
+{
+    uint32_t milliseconds = 0;
+    EXPECT(parseSeconds("300", milliseconds) && milliseconds == 300000);
+    EXPECT(parseSeconds("2.5", milliseconds) && milliseconds == 2500);
+    EXPECT(parseSeconds("0.011", milliseconds) && milliseconds == 10);
+    EXPECT(parseSeconds("2147483.64", milliseconds) && milliseconds == 2147483640);
+    EXPECT(!parseSeconds("2147483.65", milliseconds));
+    EXPECT(!parseSeconds("-1", milliseconds));
+    EXPECT(!parseSeconds("", milliseconds));
+}
+
+TEST_CASE(parseCentiRejectsMalformed)
+{
+    int32_t value = 0;
+    EXPECT(!parseCenti("", value));
+    EXPECT(!parseCenti("-", value));
+    EXPECT(!parseCenti(".", value));
+    EXPECT(!parseCenti("1.2.3", value));
+    EXPECT(!parseCenti("4x", value));
+    EXPECT(!parseCenti(" 45", value));
+}
@@ -0,0 +1,114 @@
+/*------------------------------------------------------------------------------
+Copyright (c) 2023 Joe Porembski
+SPDX-License-Identifier: BSD-3-Clause
+------------------------------------------------------------------------------*/
+#include "allocations.hpp"
+#include "fixtures.hpp"
+#include "test.hpp"
+
+#include "connectivity/mqtt/detail/context.hpp"
+#include "connectivity/mqtt/detail/publish-window.hpp"
+#include "connectivity/mqtt/topic-table.hpp"
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+
+using namespace fixtures;
+
+TEST_CASE(dispatchDeliversWithoutAllocating)
+{
+    uint32_t dispatched_bytes = 0;
+    for (std::string_view topic : SUBSCRIBED_TOPICS) {
+        mqtt::detail::context().subscribe(topic, [&dispatched_bytes](std::string_view /* topic */, mqtt::Payload data) {
+            dispatched_bytes += static_cast<uint32_t>(data.size());
+        });
+    }
+
+    uint64_t before = host::allocations();
+    for (std::string_view topic : SUBSCRIBED_TOPICS) {
+        dispatch(topic, DISPATCH_PAYLOAD, DISPATCH_PAYLOAD.size());
+    }
+    EXPECT(dispatched_bytes == SUBSCRIBED_TOPICS.size() * DISPATCH_PAYLOAD.size());
+    EXPECT(host::allocations() == before);
+
+    for (std::string_view topic : SUBSCRIBED_TOPICS) {
+        mqtt::detail::context().unsubscribe(topic);
+    }
+}
+
+TEST_CASE(dispatchGathersFragments)
+{
+    // A payload split across fragments is gathered before it is handed on, and one too large to gather is discarded.
+    std::string_view profile = "50,900,3600;70,1200,43200,5;50,900,3600;70,1200,43200,5";
+    std::string too_large(mqtt::detail::ContextInterface::PAYLOAD_CAPACITY + 1, '0');
+    std::string payload;
+    mqtt::detail::context().subscribe(SUBSCRIBED_TOPICS[0], [&payload](std::string_view /* topic */, mqtt::Payload data) {
+        payload = mqtt::toString(data);
+    });
+
+    dispatch(SUBSCRIBED_TOPICS[0], profile, 7);
+    EXPECT(payload == profile);
+    dispatch(SUBSCRIBED_TOPICS[0], too_large, 64);
+    EXPECT(payload == profile);
+    dispatch(SUBSCRIBED_TOPICS[0], "", 1);
+    EXPECT(payload.empty());
+
+    mqtt::detail::context().unsubscribe(SUBSCRIBED_TOPICS[0]);
+    EXPECT(!mqtt::detail::context().subscribe(std::string(200, 'x'), nullptr));
+}
+
+TEST_CASE(topicTableBuilds)
+{
+    mqtt::TopicTable topics;
+    EXPECT(topics.build(TELEMETRY_TOPICS.data(), TELEMETRY_TOPICS.size(), DEVICE_NAME));
+    EXPECT(std::string_view(topics[0]) == "dryer/board/temperature");
+    EXPECT(std::string_view(topics[4]) == "dryer/board/control/jitter");
+    EXPECT(std::string_view(topics[6]) == "dryer/container/history");
+    EXPECT(std::string_view(topics[7]).empty());
+    EXPECT(topics.policy(3).qos == mqtt::QoS::AT_LEAST_ONCE);
+    EXPECT(topics.policy(3).retain);
+}
+
+TEST_CASE(publishWindowLimitsAndCoalesces)
+{
+    mqtt::TopicTable topics;
+    topics.build(TELEMETRY_TOPICS.data(), TELEMETRY_TOPICS.size(), DEVICE_NAME);
+    mqtt::detail::PublishWindow window(MQTT_IN_FLIGHT_LIMIT);
+    InFlightRequests requests;
+    uint32_t completions = 0;
+    window.setCompletionCallback([&completions]() { completions++; });
+
+    // Fill the window, then queue two publishes on the same topic: only the second is kept.
+    for (uint8_t index = 0; index < MQTT_IN_FLIGHT_LIMIT; index++) {
+        requests[index] = window.open();
+    }
+    EXPECT(window.open() == nullptr);
+    EXPECT(!window.ready());
+    EXPECT(window.inFlight() == MQTT_IN_FLIGHT_LIMIT);
+
+    window.enqueue(topics[0], "40.00", topics.policy(0));
+    window.enqueue(topics[1], "55.00", topics.policy(1));
+    window.enqueue(topics[0], "41.00", topics.policy(0));
+    EXPECT(window.queued() == 2);
+    EXPECT(window.front()->payload() == "41.00");
+    EXPECT(std::string_view(window.front()->topic()) == topics[0]);
+
+    std::string too_long(mqtt::detail::QueuedPublish::CAPACITY, 'x');
+    EXPECT(!window.enqueue(topics[2], too_long, topics.policy(2)));
+
+    // Identifiers are unique, and a freed slot is reused under a new one.
+    uint16_t first_id = requests[0]->id;
+    window.complete(requests[0]);
+    requests[0] = window.open();
+    EXPECT(requests[0] != nullptr && requests[0]->id != first_id);
+    EXPECT(completions == 1);
+
+    EXPECT(drainWindow(window, requests, MQTT_IN_FLIGHT_LIMIT) == 2);
+    EXPECT(window.queued() == 0);
+    EXPECT(window.inFlight() == 2);
+    window.reset();
+    EXPECT(window.inFlight() == 0);
+    EXPECT(window.ready());
+}
@@ -0,0 +1,41 @@
+/*------------------------------------------------------------------------------
+Copyright (c) 2023 Joe Porembski
+SPDX-License-Identifier: BSD-3-Clause
+------------------------------------------------------------------------------*/
+#include "hal.hpp"
+#include "test.hpp"
+
+#include "scheduler.hpp"
+
+#include <pico/time.h>
+
+#include <cstdint>
+
+
+inline constexpr uint32_t PERIOD_MS = 1000;
+inline constexpr uint64_t US_PER_MS = 1000;
+
+TEST_CASE(scheduleKeepsToItsGrid)
+{
+    PeriodicSchedule schedule(PERIOD_MS);
+    schedule.start();
+    uint64_t start_us = time_us_64();
+
+    // Work shorter than the period is followed by a sleep to the deadline.
+    host::advanceClock(300 * US_PER_MS);
+    EXPECT(schedule.wait());
+    EXPECT(time_us_64() == start_us + PERIOD_MS * US_PER_MS);
+
+    // Work which runs past the next deadline skips it, and the cycle after lands back on the grid.
+    host::advanceClock(2500 * US_PER_MS);
+    EXPECT(!schedule.wait());
+    EXPECT(schedule.wait());
+    EXPECT(time_us_64() == start_us + 4 * PERIOD_MS * US_PER_MS);
+
+    PeriodStatistics statistics = schedule.statistics();
+    EXPECT(statistics.cycles == 3);
+    EXPECT(statistics.overruns == 1);
+    EXPECT(statistics.skipped == 1);
+    EXPECT(statistics.max_jitter_us == 1500 * US_PER_MS);
+    EXPECT(statistics.min_jitter_us == -500 * static_cast<int32_t>(US_PER_MS));
+}
@@ -0,0 +1,43 @@
+/*------------------------------------------------------------------------------
+Copyright (c) 2023 Joe Porembski
+SPDX-License-Identifier: BSD-3-Clause
+------------------------------------------------------------------------------*/
+#include "test.hpp"
+
+#include "measurement.hpp"
+#include "sensors/constants.hpp"
+#include "sensors/filter.hpp"
+
+#include <cstdint>
+
+
+inline constexpr uint64_t READING_PERIOD_MS = 2000;
+
+TEST_CASE(filterAcceptsFirstReading)
+{
+    sensors::SampleFilter filter(TEMPERATURE_MAX_RATE, SAMPLE_EWMA_SHIFT, SAMPLE_MAX_AGE_MS);
+    const Sample& sample = filter.update(toCenti(40), true, 0);
+    EXPECT(sample.quality == SampleQuality::GOOD);
+    EXPECT(sample.value == toCenti(40));
+}
+
+TEST_CASE(filterHoldsThenInvalidates)
+{
+    sensors::SampleFilter filter(TEMPERATURE_MAX_RATE, SAMPLE_EWMA_SHIFT, SAMPLE_MAX_AGE_MS);
+    filter.update(toCenti(40), true, 0);
+    EXPECT(filter.update(0, false, READING_PERIOD_MS).quality == SampleQuality::STALE);
+    EXPECT(filter.sample().value == toCenti(40));
+    EXPECT(filter.update(0, false, SAMPLE_MAX_AGE_MS + READING_PERIOD_MS).quality == SampleQuality::INVALID);
+}
+
+TEST_CASE(filterRejectsSpike)
+{
+    sensors::SampleFilter filter(TEMPERATURE_MAX_RATE, SAMPLE_EWMA_SHIFT, SAMPLE_MAX_AGE_MS);
+    uint64_t timepoint = 0;
+    for (; timepoint < 5 * READING_PERIOD_MS; timepoint += READING_PERIOD_MS) {
+        filter.update(toCenti(40), true, timepoint);
+    }
+
+    EXPECT(filter.update(toCenti(80), true, timepoint).value == toCenti(40));
+    EXPECT(filter.rejectedCount() == 1);
+}
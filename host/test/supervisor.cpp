@@ -0,0 +1,39 @@
+/*------------------------------------------------------------------------------
+Copyright (c) 2023 Joe Porembski
+SPDX-License-Identifier: BSD-3-Clause
+------------------------------------------------------------------------------*/
+#include "hal.hpp"
+#include "test.hpp"
+
+#include "supervisor.hpp"
+
+#include <hardware/watchdog.h>
+
+#include <cstdint>
+
+
+inline constexpr uint64_t US_PER_MS = 1000;
+inline constexpr uint32_t STALL_RECORD_MAGIC = 0x5354414C;
+
+TEST_CASE(supervisorRecordsStall)
+{
+    EXPECT(supervisor::start());
+    EXPECT(supervisor::lastReset() == "power on");
+
+    // Core 1 checks in once, then stalls. The supervisor sees the check in a second later, and gives up 30s after that.
+    host::setCore(1);
+    supervisor::checkIn(supervisor::Checkpoint::SENSOR_READ);
+    host::setCore(0);
+    host::advanceClock(31 * 1000 * US_PER_MS);
+    EXPECT(host::watchdogFeeds() == 31);
+    EXPECT(watchdog_hw->scratch[0] != STALL_RECORD_MAGIC);
+    host::advanceClock(2 * 1000 * US_PER_MS);
+    EXPECT(host::watchdogFeeds() == 31);
+    EXPECT(watchdog_hw->scratch[0] == STALL_RECORD_MAGIC);
+
+    // The scratch registers survive the reset, so the next start can say what happened.
+    host::resetByWatchdog();
+    EXPECT(supervisor::start());
+    EXPECT(supervisor::lastReset() == "watchdog: core1 stalled at sensor_read for 31s");
+    EXPECT(watchdog_hw->scratch[0] != STALL_RECORD_MAGIC);
+}
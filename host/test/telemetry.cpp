@@ -0,0 +1,133 @@
+/*------------------------------------------------------------------------------
+Copyright (c) 2023 Joe Porembski
+SPDX-License-Identifier: BSD-3-Clause
+------------------------------------------------------------------------------*/
+#include "allocations.hpp"
+#include "fixtures.hpp"
+#include "test.hpp"
+
+#include "cbor.hpp"
+#include "connectivity/mqtt/topic-table.hpp"
+#include "report-filter.hpp"
+#include "text-buffer.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <string>
+
+
+using namespace fixtures;
+
+/** {"a": 45.30, "b": [-1, null, true]} */
+inline constexpr std::array<uint8_t, 15> CBOR_EXAMPLE = {0xA2, 0x61, 0x61, 0xC4, 0x82, 0x21, 0x19, 0x11,
+                                                         0xB2, 0x61, 0x62, 0x83, 0x20, 0xF6, 0xF5};
+
+/** INT64_MIN, which takes the widest form. */
+inline constexpr std::array<uint8_t, 9> CBOR_MINIMUM = {0x3B, 0x7F, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};
+
+TEST_CASE(textBufferRefusesOverflow)
+{
+    TextBuffer<8> text;
+    EXPECT(text.append("45.30"));
+    EXPECT(text.appendInteger(-12));
+    EXPECT(!text.append("3"));
+    EXPECT(text.view() == "45.30-12");
+    EXPECT(text.overflowed());
+}
+
+TEST_CASE(telemetryFormatsWithoutAllocating)
+{
+    mqtt::TopicTable topics;
+    topics.build(TELEMETRY_TOPICS.data(), TELEMETRY_TOPICS.size(), DEVICE_NAME);
+
+    uint64_t before = host::allocations();
+    NumberBuffer number;
+    EXPECT(formatCenti(4530, number) == "45.30");
+    EXPECT(formatCenti(-5, number) == "-0.05");
+    EXPECT(formatCenti(INT32_MIN, number) == "-21474836.48");
+    EXPECT(formatInteger(0, number) == "0");
+    EXPECT(formatInteger(INT64_MIN, number) == "-9223372036854775808");
+    EXPECT(formatTelemetry(topics, toCenti(40), 250) > 0);
+    EXPECT(host::allocations() == before);
+    EXPECT(centiToString(-1010) == "-10.10");
+}
+
+TEST_CASE(telemetryMatchesStringFormatting)
+{
+    mqtt::TopicTable topics;
+    topics.build(TELEMETRY_TOPICS.data(), TELEMETRY_TOPICS.size(), DEVICE_NAME);
+
+    EXPECT(formatTelemetry(topics, toCenti(40), 250) == formatTelemetryWithStrings(DEVICE_NAME, toCenti(40), 250));
+    EXPECT(formatTelemetry(topics, -1010, -4999) == formatTelemetryWithStrings(DEVICE_NAME, -1010, -4999));
+}
+
+TEST_CASE(cborEncodes)
+{
+    std::array<uint8_t, CBOR_PAYLOAD_SIZE> payload;
+    CBORWriter writer(payload.data(), payload.size());
+    writer.map(2);
+    writer.text("a");
+    writer.decimal(4530);
+    writer.text("b");
+    writer.array(3);
+    writer.integer(-1);
+    writer.null();
+    writer.boolean(true);
+    EXPECT(!writer.overflowed());
+    EXPECT(writer.size() == CBOR_EXAMPLE.size());
+    EXPECT(std::equal(CBOR_EXAMPLE.cbegin(), CBOR_EXAMPLE.cend(), payload.cbegin()));
+
+    // The widest integers take the 8-byte form, and anything past the capacity is refused rather than cut short.
+    CBORWriter wide(payload.data(), CBOR_MINIMUM.size());
+    wide.integer(INT64_MIN);
+    EXPECT(!wide.overflowed());
+    EXPECT(std::equal(CBOR_MINIMUM.cbegin(), CBOR_MINIMUM.cend(), payload.cbegin()));
+    wide.null();
+    EXPECT(wide.overflowed());
+    EXPECT(wide.size() == CBOR_MINIMUM.size());
+
+    uint64_t before = host::allocations();
+    CBORWriter snapshot(payload.data(), payload.size());
+    EXPECT(encodeSnapshot(snapshot, 1, toCenti(40)) > 0);
+    EXPECT(!snapshot.overflowed());
+    EXPECT(host::allocations() == before);
+}
+
+TEST_CASE(reportFilterDeadbandAndHeartbeat)
+{
+    ReportFilter filter;
+    EXPECT(filter.due(4000, 20, 0, REPORT_HEARTBEAT_MS));
+    filter.reported(4000, 0);
+    EXPECT(!filter.due(4020, 20, 10000, REPORT_HEARTBEAT_MS));
+    EXPECT(!filter.due(3980, 20, 20000, REPORT_HEARTBEAT_MS));
+    EXPECT(filter.due(3979, 20, 30000, REPORT_HEARTBEAT_MS));
+    EXPECT(filter.due(4000, 20, REPORT_HEARTBEAT_MS, REPORT_HEARTBEAT_MS));
+    EXPECT(filter.due(4000, 20, 1, 0));
+    filter.reset();
+    EXPECT(filter.due(4000, ReportFilter::HEARTBEAT_ONLY, 2, REPORT_HEARTBEAT_MS));
+    EXPECT(filter.sent() == 1);
+    EXPECT(filter.suppressed() == 2);
+}
+
+TEST_CASE(reportFilterExtremes)
+{
+    // Neither the widest change nor the clock wrapping around is mistaken for something else.
+    ReportFilter extreme;
+    extreme.reported(INT32_MIN, UINT32_MAX - 1000);
+    EXPECT(extreme.due(INT32_MAX, ReportFilter::HEARTBEAT_ONLY - 1, UINT32_MAX, REPORT_HEARTBEAT_MS));
+    EXPECT(!extreme.due(INT32_MIN, 0, REPORT_HEARTBEAT_MS - 2000, REPORT_HEARTBEAT_MS));
+    EXPECT(textKey("on") != textKey("off"));
+    EXPECT(textKey("on") == textKey(std::string("on")));
+}
+
+TEST_CASE(reportFilterSuppressesSteadyValues)
+{
+    // Over ten minutes, only the drifting temperature, the toggling heater, and the heartbeats go out.
+    ReportFilters filters;
+    uint32_t due = 0;
+    for (uint32_t cycle = 0; cycle < 60; cycle++) {
+        due += reportCycle(filters, cycle);
+    }
+    EXPECT(due < 60 * filters.size() / 2);
+}
@@ -0,0 +1,45 @@
+/*------------------------------------------------------------------------------
+Copyright (c) 2023 Joe Porembski
+SPDX-License-Identifier: BSD-3-Clause
+------------------------------------------------------------------------------*/
+#pragma once
+
+#include <string_view>
+
+
+/*
+ * A minimal test harness for the host build. Each TEST_CASE registers itself before main() runs, and each EXPECT which
+ * fails is reported with its location, without stopping the rest of the test.
+ */
+namespace test {
+/**
+ * Adds a test case to those run by the test executable.
+ */
+struct Registration
+{
+    /**
+     * Constructor.
+     *
+     * @param[in] name The name used to select the test case.
+     * @param[in] run Runs the test case.
+     */
+    Registration(std::string_view name, void (*run)());
+};
+
+/**
+ * Records the result of a single expectation, reporting it if it failed.
+ *
+ * @param[in] passed True if the expectation held, false otherwise.
+ * @param[in] expression The text of the expectation.
+ * @param[in] file The file the expectation is in.
+ * @param[in] line The line the expectation is on.
+ */
+void check(bool passed, const char* expression, const char* file, int line);
+} // namespace test
+
+#define TEST_CASE(name)                                                                                                     \
+    static void name();                                                                                                     \
+    static const test::Registration name##_registration(#name, name);                                                       \
+    static void name()
+
+#define EXPECT(condition) test::check((condition), #condition, __FILE__, __LINE__)
@@ -0,0 +1,142 @@
+/*------------------------------------------------------------------------------
+Copyright (c) 2023 Joe Porembski
+SPDX-License-Identifier: BSD-3-Clause
+------------------------------------------------------------------------------*/
+#include "cbor.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+
+
+inline constexpr uint8_t MAJOR_UNSIGNED = 0;
+inline constexpr uint8_t MAJOR_NEGATIVE = 1;
+inline constexpr uint8_t MAJOR_TEXT = 3;
+inline constexpr uint8_t MAJOR_ARRAY = 4;
+inline constexpr uint8_t MAJOR_MAP = 5;
+inline constexpr uint8_t MAJOR_TAG = 6;
+inline constexpr uint8_t MAJOR_SIMPLE = 7;
+inline constexpr uint8_t MAJOR_SHIFT = 5;
+
+/** The largest argument held in the initial byte itself. */
+inline constexpr uint64_t MAXIMUM_IMMEDIATE = 23;
+inline constexpr uint8_t FOLLOWING_1_BYTE = 24;
+inline constexpr uint8_t FOLLOWING_2_BYTES = 25;
+inline constexpr uint8_t FOLLOWING_4_BYTES = 26;
+inline constexpr uint8_t FOLLOWING_8_BYTES = 27;
+
+inline constexpr uint8_t SIMPLE_FALSE = 20;
+inline constexpr uint8_t SIMPLE_TRUE = 21;
+inline constexpr uint8_t SIMPLE_NULL = 22;
+
+inline constexpr uint64_t TAG_DECIMAL_FRACTION = 4;
+inline constexpr int64_t CENTI_EXPONENT = -2;
+
+CBORWriter::CBORWriter(uint8_t* buffer, size_t capacity)
+    : _buffer(buffer),
+      _capacity(capacity),
+      _size(0),
+      _overflowed(false)
+{
+}
+
+size_t CBORWriter::size() const
+{
+    return _size;
+}
+
+bool CBORWriter::overflowed() const
+{
+    return _overflowed;
+}
+
+void CBORWriter::map(uint32_t count)
+{
+    _head(MAJOR_MAP, count);
+}
+
+void CBORWriter::array(uint32_t count)
+{
+    _head(MAJOR_ARRAY, count);
+}
+
+void CBORWriter::integer(int64_t value)
+{
+    if (value >= 0) {
+        _head(MAJOR_UNSIGNED, static_cast<uint64_t>(value));
+    }
+    else {
+        // A negative integer n is encoded as -1 - n, which is the bitwise complement, and cannot overflow.
+        _head(MAJOR_NEGATIVE, ~static_cast<uint64_t>(value));
+    }
+}
+
+void CBORWriter::decimal(int32_t value)
+{
+    _head(MAJOR_TAG, TAG_DECIMAL_FRACTION);
+    array(2);
+    integer(CENTI_EXPONENT);
+    integer(value);
+}
+
+void CBORWriter::text(std::string_view value)
+{
+    _head(MAJOR_TEXT, value.size());
+    _write(reinterpret_cast<const uint8_t*>(value.data()), value.size());
+}
+
+void CBORWriter::boolean(bool value)
+{
+    _head(MAJOR_SIMPLE, value ? SIMPLE_TRUE : SIMPLE_FALSE);
+}
+
+void CBORWriter::null()
+{
+    _head(MAJOR_SIMPLE, SIMPLE_NULL);
+}
+
+void CBORWriter::_head(uint8_t major, uint64_t argument)
+{
+    std::array<uint8_t, 9> head;
+    uint8_t following = 0;
+    uint8_t initial = static_cast<uint8_t>(major << MAJOR_SHIFT);
+    if (argument <= MAXIMUM_IMMEDIATE) {
+        initial |= static_cast<uint8_t>(argument);
+    }
+    else if (argument <= UINT8_MAX) {
+        initial |= FOLLOWING_1_BYTE;
+        following = 1;
+    }
+    else if (argument <= UINT16_MAX) {
+        initial |= FOLLOWING_2_BYTES;
+        following = 2;
+    }
+    else if (argument <= UINT32_MAX) {
+        initial |= FOLLOWING_4_BYTES;
+        following = 4;
+    }
+    else {
+        initial |= FOLLOWING_8_BYTES;
+        following = 8;
+    }
+
+    // The argument follows the initial byte in network byte order.
+    head[0] = initial;
+    for (uint8_t index = 0; index < following; index++) {
+        head[following - index] = static_cast<uint8_t>(argument >> (index * 8));
+    }
+    _write(head.data(), following + 1);
+}
+
+void CBORWriter::_write(const uint8_t* data, size_t size)
+{
+    if (_overflowed || size > _capacity - _size) {
+        _overflowed = true;
+        return;
+    }
+
+    std::memcpy(_buffer + _size, data, size);
+    _size += size;
+}
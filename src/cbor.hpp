@@ -0,0 +1,111 @@
+/*------------------------------------------------------------------------------
+Copyright (c) 2023 Joe Porembski
+SPDX-License-Identifier: BSD-3-Clause
+------------------------------------------------------------------------------*/
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+
+/**
+ * Encodes values as CBOR (RFC 8949) into a buffer supplied by the caller, without allocating.
+ *
+ * Only the definite-length forms are written, so the number of entries in a map or array is given up front and must be
+ * followed by exactly that many items (two per map entry). Values which do not fit are not written, and mark the writer
+ * as overflowed, leaving the encoding incomplete.
+ *
+ * @see https://www.rfc-editor.org/rfc/rfc8949
+ */
+class CBORWriter
+{
+public:
+    /**
+     * Constructor.
+     *
+     * @param[in] buffer The space to encode into.
+     * @param[in] capacity The size of @a buffer in bytes.
+     */
+    CBORWriter(uint8_t* buffer, size_t capacity);
+
+    /**
+     * @return The number of bytes written.
+     */
+    size_t size() const;
+
+    /**
+     * @return True if any value was left out because it did not fit, false otherwise.
+     */
+    bool overflowed() const;
+
+    /**
+     * Starts a map, which must be followed by @a count keys, each followed by its value.
+     *
+     * @param[in] count The number of entries in the map.
+     */
+    void map(uint32_t count);
+
+    /**
+     * Starts an array, which must be followed by @a count items.
+     *
+     * @param[in] count The number of items in the array.
+     */
+    void array(uint32_t count);
+
+    /**
+     * Writes an integer, in the fewest bytes which hold it.
+     *
+     * @param[in] value The value.
+     */
+    void integer(int64_t value);
+
+    /**
+     * Writes a value in hundredths as a decimal fraction (tag 4), so it is decoded as exactly the decimal it represents,
+     * e.g. 4530 as 45.30.
+     *
+     * @param[in] value The value in hundredths.
+     */
+    void decimal(int32_t value);
+
+    /**
+     * Writes a UTF-8 text string.
+     *
+     * @param[in] value The text.
+     */
+    void text(std::string_view value);
+
+    /**
+     * Writes true or false.
+     *
+     * @param[in] value The value.
+     */
+    void boolean(bool value);
+
+    /**
+     * Writes null, for a value which is not available.
+     */
+    void null();
+
+private:
+    /**
+     * Writes the head of a data item: its major type, and its argument in the fewest bytes which hold it.
+     *
+     * @param[in] major The major type.
+     * @param[in] argument The argument, e.g. the value of an integer or the length of a string.
+     */
+    void _head(uint8_t major, uint64_t argument);
+
+    /**
+     * Writes @a size bytes, if they fit.
+     *
+     * @param[in] data The bytes.
+     * @param[in] size The number of bytes.
+     */
+    void _write(const uint8_t* data, size_t size);
+
+    uint8_t* _buffer;
+    size_t _capacity;
+    size_t _size;
+    bool _overflowed;
+};
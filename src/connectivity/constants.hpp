@@ -10,8 +10,6 @@ SPDX-License-Identifier: BSD-3-Clause
 #include <string_view>
 
 
-inline constexpr uint32_t WIFI_TIMEOUT_MS = 30000;
-inline constexpr uint32_t POLL_WAIT_TIME_MS = 2000;
 inline constexpr std::string_view WIFI_STATUS_CONNECTED = "CONNECTED";
 inline constexpr std::string_view WIFI_STATUS_CONNECTING = "CONNECTING";
 inline constexpr std::string_view WIFI_STATUS_CONNECTED_NO_IP = "CONNECTED_NO_IP";
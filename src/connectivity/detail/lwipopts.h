@@ -98,4 +98,7 @@ SPDX-License-Identifier: BSD-3-Clause
 #define MEMP_NUM_SYS_TIMEOUT   (LWIP_NUM_SYS_TIMEOUT_INTERNAL + 1)
 #define MQTT_REQ_MAX_IN_FLIGHT (5)
 
+// History is published in batches, which need more room than the default 256 bytes.
+#define MQTT_OUTPUT_RINGBUF_SIZE (1024)
+
 #endif
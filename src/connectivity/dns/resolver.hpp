@@ -7,17 +7,28 @@ SPDX-License-Identifier: BSD-3-Clause
 #include <lwip/ip_addr.h>
 
 #include <cstdint>
+#include <functional>
 #include <string>
 
 
 namespace dns {
 /**
- * Resolves a FQDN or hostname to an IP address.
+ * Handler for the result of a resolution.
  *
+ * The argument is the resolved IP address, or nullptr if the hostname could not be resolved.
+ */
+using ResolveCallback = std::function<void(const ip_addr_t*)>;
+
+/**
+ * Starts resolving a FQDN or hostname to an IP address, without waiting for the result.
+ *
+ * If @a hostname is an IP address, or its address has been cached, @a callback is invoked before this returns. Otherwise
+ * it is invoked from the lwIP context once the DNS response arrives, or the request times out.
+ *
+ * @note Only one resolution can be in progress at a time.
  * @param[in] hostname The hostname or FQDN to be resolved.
- * @param[in] resolved_address The resolved IP address.
- * @param[in] timeout_ms The timeout for IP address resolution.
- * @return True if @a hostname was resolved, false otherwise.
+ * @param[in] callback The callback to be invoked with the result.
+ * @return True if the resolution was started, false otherwise.
  */
-bool resolve(const std::string& hostname, ip_addr_t& resolved_address, int32_t timeout_ms);
+bool resolve(const std::string& hostname, ResolveCallback callback);
 } // namespace dns
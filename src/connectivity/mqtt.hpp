@@ -11,20 +11,25 @@ SPDX-License-Identifier: BSD-3-Clause
 #include <pico/stdio.h>
 
 #include <cstdio>
+#include <string>
+#include <string_view>
 
 
 namespace mqtt {
+/** The version and UID only change with the firmware, so they are sent reliably and kept for new subscribers. */
+inline constexpr PublishPolicy METADATA_POLICY = {QoS::AT_LEAST_ONCE, true};
+
 static bool initialize(Client& client, const std::string& uid)
 {
     char mqtt_topic[TOPIC_BUFFER_SIZE];
     snprintf(mqtt_topic, TOPIC_BUFFER_SIZE, VERSION_TOPIC_FORMAT.data(), client.deviceName().c_str());
-    if (!client.publish(mqtt_topic, static_cast<const void*>(VERSION.data()), VERSION.size(), mqtt::QoS::EXACTLY_ONCE, true)) {
+    if (!client.publish(mqtt_topic, static_cast<const void*>(VERSION.data()), VERSION.size(), METADATA_POLICY)) {
         printf("Failed to publish %s\n", mqtt_topic);
         return false;
     }
 
     snprintf(mqtt_topic, TOPIC_BUFFER_SIZE, UID_TOPIC_FORMAT.data(), client.deviceName().c_str());
-    if (!client.publish(mqtt_topic, static_cast<const void*>(uid.c_str()), uid.size(), mqtt::QoS::EXACTLY_ONCE, true)) {
+    if (!client.publish(mqtt_topic, static_cast<const void*>(uid.c_str()), uid.size(), METADATA_POLICY)) {
         printf("Failed to publish %s\n", mqtt_topic);
         return false;
     }
@@ -32,19 +37,19 @@ static bool initialize(Client& client, const std::string& uid)
     return true;
 }
 
-static bool publish(Client& client, const char* topic, const std::string& data)
+static bool publish(Client& client, const char* topic, std::string_view data, PublishPolicy policy)
 {
-    if (!client.publish(topic, static_cast<const void*>(data.c_str()), data.size(), mqtt::QoS::EXACTLY_ONCE, true)) {
-        printf("Failed to publish %s on %s\n", data.c_str(), topic);
+    if (!client.publish(topic, static_cast<const void*>(data.data()), data.size(), policy)) {
+        printf("Failed to publish %.*s on %s\n", static_cast<int>(data.size()), data.data(), topic);
         return false;
     }
 
     return true;
 }
 
-static bool publish(Client& client, const char* topic, uint32_t data)
+static bool publish(Client& client, const char* topic, uint32_t data, PublishPolicy policy)
 {
-    if (!client.publish(topic, static_cast<const void*>(&data), sizeof(uint32_t), mqtt::QoS::EXACTLY_ONCE, true)) {
+    if (!client.publish(topic, static_cast<const void*>(&data), sizeof(uint32_t), policy)) {
         printf("Failed to publish %u on %s\n", data, topic);
         return false;
     }
@@ -15,6 +15,8 @@ SPDX-License-Identifier: BSD-3-Clause
 #include <cstdint>
 #include <cstdio>
 #include <functional>
+#include <string_view>
+#include <utility>
 
 
 /**
@@ -66,19 +68,19 @@ static void onTopicUpdated(void* /* unused */, const char* topic, u32_t total_le
  *
  * Called when a subscribe, unsubscribe or publish request has completed
  *
- * @param[in] arg Additional data passed to the callback.
+ * @param[in] arg The mqtt::detail::InFlightRequest tracking the request.
  * @param[in] error The error which occurred, or ERR_OK if no error occurred.
  */
 static void onRequestComplete(void* arg, err_t error)
 {
+    auto* request = static_cast<mqtt::detail::InFlightRequest*>(arg);
     if (error != ERR_OK) {
-        printf("Previous request failed: %s\n", lwip_strerr(error));
+        printf("Request %u failed: %s\n", request->id, lwip_strerr(error));
     }
+    request->window->complete(request);
 }
 
 namespace mqtt {
-inline constexpr uint32_t DNS_TIMEOUT_MS = 10000;
-
 Client::Client(const std::string& broker, uint16_t port, const std::string& client_name, uint8_t led_pin)
     : _mqtt(mqtt_client_new()),
       _led_pin(led_pin),
@@ -88,7 +90,10 @@ Client::Client(const std::string& broker, uint16_t port, const std::string& clie
       _name(client_name),
       _user(),
       _password(),
-      _info()
+      _info(),
+      _status_callback(),
+      _ready_callback(),
+      _window(MQTT_REQ_MAX_IN_FLIGHT)
 {
     _info.client_id = _name.c_str();
     _info.client_pass = NULL;
@@ -119,7 +124,10 @@ Client::Client(const std::string& broker,
       _name(client_name),
       _user(user),
       _password(password),
-      _info()
+      _info(),
+      _status_callback(),
+      _ready_callback(),
+      _window(MQTT_REQ_MAX_IN_FLIGHT)
 {
     _info.client_id = _name.c_str();
     _info.client_pass = _password.c_str();
@@ -156,25 +164,19 @@ bool Client::connected() const
 
 bool Client::connect()
 {
-    if (!dns::resolve(_broker, _broker_address, DNS_TIMEOUT_MS)) {
+    auto resolved_callback = std::bind(&Client::_onBrokerResolved, this, std::placeholders::_1);
+    if (!dns::resolve(_broker, resolved_callback)) {
         printf("Failed to resolve %s when connecting to MQTT\n", _broker.c_str());
         return false;
     }
-
-    printf("Connecting to %s (%s) as %s\n", _broker.c_str(), ip4addr_ntoa(&_broker_address), _info.client_id);
-    mqtt_set_inpub_callback(_mqtt, onTopicUpdated, onDataReceived, LWIP_CONST_CAST(void*, &_info));
-
-    cyw43_arch_lwip_begin();
-    err_t error = mqtt_client_connect(_mqtt, &_broker_address, _port, onConnectionComplete, LWIP_CONST_CAST(void*, &_info), &_info);
-    cyw43_arch_lwip_end();
-
-    if (error != ERR_OK) {
-        printf("Connection to %s unsuccessful: %s\n", _broker.c_str(), lwip_strerr(error));
-        return false;
-    }
     return true;
 }
 
+void Client::setStatusCallback(ConnectionStatusCallback callback)
+{
+    _status_callback = callback;
+}
+
 bool Client::disconnect()
 {
     cyw43_arch_lwip_begin();
@@ -183,35 +185,82 @@ bool Client::disconnect()
     return true;
 }
 
-bool Client::publish(const char* topic, const void* payload, uint16_t size, QoS qos, bool retain)
+void Client::setReadyCallback(std::function<void()> callback)
 {
-    uint8_t qos_value = static_cast<uint8_t>(qos);
-    uint8_t retain_value = static_cast<uint8_t>(retain);
+    _ready_callback = std::move(callback);
+}
 
-    cyw43_arch_lwip_begin();
-    err_t error = mqtt_publish(_mqtt, topic, payload, size, qos_value, retain_value, onRequestComplete, NULL);
-    cyw43_arch_lwip_end();
+bool Client::publish(const char* topic, const void* payload, uint16_t size, PublishPolicy policy)
+{
+    // Anything already queued goes first, so a newer message on a topic is never overtaken by an older one.
+    if (_window.ready() && _send(topic, payload, size, policy)) {
+        return true;
+    }
 
-    if (error != ERR_OK) {
-        printf("Publish of %s unsuccessful: %s\n", topic, lwip_strerr(error));
+    std::string_view data(static_cast<const char*>(payload), size);
+    if (!_window.enqueue(topic, data, policy)) {
+        printf("Publish of %s unsuccessful: %u requests in flight, %u queued\n", topic, _window.inFlight(), _window.queued());
         return false;
     }
     return true;
 }
 
-bool Client::subscribe(const char* topic, TopicCallback callback)
+uint8_t Client::flush()
+{
+    for (const detail::QueuedPublish* next = _window.front(); next != nullptr; next = _window.front()) {
+        std::string_view payload = next->payload();
+        if (!_send(next->topic(), payload.data(), static_cast<uint16_t>(payload.size()), next->policy)) {
+            break;
+        }
+        _window.pop();
+    }
+    return _window.queued();
+}
+
+bool Client::ready() const
+{
+    return _window.ready();
+}
+
+uint8_t Client::inFlight() const
+{
+    return _window.inFlight();
+}
+
+bool Client::subscribe(const char* topic, QoS qos, TopicCallback callback)
 {
-    uint8_t qos_value = static_cast<uint8_t>(QoS::AT_LEAST_ONCE);
-    detail::context().subscribe(topic, callback);
-    err_t error = mqtt_subscribe(_mqtt, topic, qos_value, onRequestComplete, NULL);
-    return error == ERR_OK;
+    detail::InFlightRequest* request = _window.open();
+    if (request == nullptr) {
+        return false;
+    }
+
+    if (!detail::context().subscribe(topic, std::move(callback))) {
+        _window.close(request);
+        return false;
+    }
+
+    err_t error = mqtt_subscribe(_mqtt, topic, static_cast<uint8_t>(qos), onRequestComplete, request);
+    if (error != ERR_OK) {
+        _window.close(request);
+        return false;
+    }
+    return true;
 }
 
 bool Client::unsubscribe(const char* topic)
 {
+    detail::InFlightRequest* request = _window.open();
+    if (request == nullptr) {
+        return false;
+    }
+
     detail::context().unsubscribe(topic);
-    err_t error = mqtt_unsubscribe(_mqtt, topic, onRequestComplete, NULL);
-    return error == ERR_OK;
+    err_t error = mqtt_unsubscribe(_mqtt, topic, onRequestComplete, request);
+    if (error != ERR_OK) {
+        _window.close(request);
+        return false;
+    }
+    return true;
 }
 
 void Client::_init()
@@ -224,21 +273,75 @@ void Client::_init()
 
     auto status_callback = std::bind(&Client::_onConnectionStatusChanged, this, std::placeholders::_1);
     detail::context().setConnectionStatusCallback(status_callback);
+
+    _window.setCompletionCallback([this]() {
+        if (_ready_callback) {
+            _ready_callback();
+        }
+    });
 }
 
 void Client::_onConnectionStatusChanged(mqtt_connection_status_t status)
 {
     printf("Connection Status: %d\n", static_cast<int32_t>(status));
 
-    if (_led_pin >= NUM_BANK0_GPIOS) {
-        return;
+    if (_led_pin < NUM_BANK0_GPIOS) {
+        gpio_put(_led_pin, status == mqtt_connection_status_t::MQTT_CONNECT_ACCEPTED ? ON : OFF);
+    }
+
+    // lwIP discards its requests without completing them when the connection drops. Queued messages are kept, and sent
+    // once it is re-established.
+    if (status != mqtt_connection_status_t::MQTT_CONNECT_ACCEPTED) {
+        _window.reset();
+    }
+
+    if (_status_callback) {
+        _status_callback(status);
+    }
+}
+
+bool Client::_send(const char* topic, const void* payload, uint16_t size, PublishPolicy policy)
+{
+    detail::InFlightRequest* request = _window.open();
+    if (request == nullptr) {
+        return false;
+    }
+
+    uint8_t qos_value = static_cast<uint8_t>(policy.qos);
+    uint8_t retain_value = static_cast<uint8_t>(policy.retain);
+
+    cyw43_arch_lwip_begin();
+    err_t error = mqtt_publish(_mqtt, topic, payload, size, qos_value, retain_value, onRequestComplete, request);
+    cyw43_arch_lwip_end();
+
+    if (error != ERR_OK) {
+        _window.close(request);
+        // ERR_MEM only means lwIP's output buffer is full for now; the message is queued and sent once it drains.
+        if (error != ERR_MEM) {
+            printf("Publish of %s unsuccessful: %s\n", topic, lwip_strerr(error));
+        }
+        return false;
     }
+    return true;
+}
 
-    if (status == mqtt_connection_status_t::MQTT_CONNECT_ACCEPTED) {
-        gpio_put(_led_pin, ON);
+void Client::_onBrokerResolved(const ip_addr_t* address)
+{
+    if (address == nullptr) {
+        printf("Failed to resolve %s when connecting to MQTT\n", _broker.c_str());
+        return;
     }
-    else {
-        gpio_put(_led_pin, OFF);
+
+    _broker_address = *address;
+    printf("Connecting to %s (%s) as %s\n", _broker.c_str(), ip4addr_ntoa(&_broker_address), _info.client_id);
+    mqtt_set_inpub_callback(_mqtt, onTopicUpdated, onDataReceived, LWIP_CONST_CAST(void*, &_info));
+
+    cyw43_arch_lwip_begin();
+    err_t error = mqtt_client_connect(_mqtt, &_broker_address, _port, onConnectionComplete, LWIP_CONST_CAST(void*, &_info), &_info);
+    cyw43_arch_lwip_end();
+
+    if (error != ERR_OK) {
+        printf("Connection to %s unsuccessful: %s\n", _broker.c_str(), lwip_strerr(error));
     }
 }
 } // namespace mqtt
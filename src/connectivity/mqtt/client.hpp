@@ -5,33 +5,18 @@ SPDX-License-Identifier: BSD-3-Clause
 #pragma once
 
 #include "connectivity/mqtt/common.hpp"
+#include "connectivity/mqtt/detail/publish-window.hpp"
 
 #include <lwip/apps/mqtt.h>
 #include <lwip/ip_addr.h>
 
 #include <cstdint>
+#include <functional>
 #include <string>
 #include <string_view>
 
 
 namespace mqtt {
-/**
- * The MQTT QoS values.
- *
- * @see https://www.hivemq.com/blog/mqtt-essentials-part-6-mqtt-quality-of-service-levels/
- */
-enum class QoS : uint8_t
-{
-    /** MQTT will deliver the message at most once. */
-    AT_MOST_ONCE = 0,
-
-    /** MQTT will deliver the message at least once. */
-    AT_LEAST_ONCE = 1,
-
-    /** MQTT will deliver the message exactly once. */
-    EXACTLY_ONCE = 2
-};
-
 class Client
 {
 public:
@@ -71,7 +56,11 @@ public:
     const std::string& deviceName() const;
 
     /**
-     * @return True if this client connected to MQTT, false otherwise.
+     * Starts connecting to the MQTT broker, without waiting for the connection to complete.
+     *
+     * The callback set by setStatusCallback() is invoked once the broker accepts or refuses the connection.
+     *
+     * @return True if the connection was started, false otherwise.
      */
     bool connect();
 
@@ -85,26 +74,60 @@ public:
      */
     bool disconnect();
 
+    /**
+     * Sets the callback invoked from the lwIP context whenever the connection status changes.
+     *
+     * @param[in] callback The callback to use when the connection status changes.
+     */
+    void setStatusCallback(ConnectionStatusCallback callback);
+
+    /**
+     * Sets the callback invoked from the lwIP context whenever a request completes, making room for another.
+     *
+     * @param[in] callback The callback, which should arrange for flush() to be called.
+     */
+    void setReadyCallback(std::function<void()> callback);
+
     /**
      * Publish an MQTT message on @a topic.
      *
+     * If lwIP has no room for another request, or earlier publishes are still queued, the message is queued instead,
+     * replacing any message queued on the same topic, and is sent by a later call to flush().
+     *
      * @param[in] topic The MQTT topic on which to publish the message.
      * @param[in] payload The message payload.
      * @param[in] size The size of @a payload in bytes.
-     * @param[in] qos The QoS to use for this publish.
-     * @param[in] retain True if the broker should retain this message, false otherwise.
-     * @return True if the MQTT message was published, false otherwise.
+     * @param[in] policy The QoS and retain flag to use for this publish.
+     * @return True if the MQTT message was published or queued, false otherwise.
      */
-    bool publish(const char* topic, const void* payload, uint16_t size, QoS qos, bool retain);
+    bool publish(const char* topic, const void* payload, uint16_t size, PublishPolicy policy);
+
+    /**
+     * Sends as many queued messages as there is room for.
+     *
+     * @return The number of messages still queued.
+     */
+    uint8_t flush();
+
+    /**
+     * @return True if a message published now would be sent straight away, false if it would be queued.
+     */
+    bool ready() const;
+
+    /**
+     * @return The number of requests waiting to be completed by the broker.
+     */
+    uint8_t inFlight() const;
 
     /**
      * Subscribes to an MQTT topic, @a topic, using this Client's connection.
      *
      * @param[in] topic The MQTT topic to subscribe to.
+     * @param[in] qos The largest QoS at which the broker should forward messages on @a topic.
      * @param[in] callback The callback to be invoked when data is available on @a topic.
      * @return True if @a topic was subscribed to, false otherwise.
      */
-    bool subscribe(const char* topic, TopicCallback callback);
+    bool subscribe(const char* topic, QoS qos, TopicCallback callback);
 
     /**
      * Unsubscribes from an MQTT topic, @a topic, using this Client's connection.
@@ -127,6 +150,24 @@ private:
      */
     void _onConnectionStatusChanged(mqtt_connection_status_t status);
 
+    /**
+     * Handler for the resolution of the broker's address, which starts the connection.
+     *
+     * @param[in] address The address of the broker, or nullptr if it could not be resolved.
+     */
+    void _onBrokerResolved(const ip_addr_t* address);
+
+    /**
+     * Hands a message to lwIP, if it has room for another request.
+     *
+     * @param[in] topic The MQTT topic on which to publish the message.
+     * @param[in] payload The message payload.
+     * @param[in] size The size of @a payload in bytes.
+     * @param[in] policy The QoS and retain flag to use for this publish.
+     * @return True if lwIP accepted the message, false otherwise.
+     */
+    bool _send(const char* topic, const void* payload, uint16_t size, PublishPolicy policy);
+
     mqtt_client_t* _mqtt;
     uint8_t _led_pin;
     std::string _broker;
@@ -136,5 +177,8 @@ private:
     std::string _user;
     std::string _password;
     mqtt_connect_client_info_t _info;
+    ConnectionStatusCallback _status_callback;
+    std::function<void()> _ready_callback;
+    detail::PublishWindow _window;
 };
 } // namespace mqtt
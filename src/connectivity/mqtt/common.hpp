@@ -6,23 +6,108 @@ SPDX-License-Identifier: BSD-3-Clause
 
 #include <lwip/apps/mqtt.h>
 
+#include <cstddef>
 #include <cstdint>
 #include <functional>
-#include <string>
-#include <vector>
+#include <string_view>
 
 namespace mqtt {
-using Buffer = std::vector<uint8_t>;
-using TopicCallback = std::function<void(const std::string&, const Buffer&)>;
+/**
+ * A read-only view of the payload of a received message, in the style of std::span.
+ *
+ * @note The bytes are owned by the MQTT stack, and are only valid for the duration of the callback given the payload.
+ */
+class Payload
+{
+public:
+    /**
+     * Constructor.
+     *
+     * @param[in] data The first byte of the payload.
+     * @param[in] size The number of bytes in the payload.
+     */
+    constexpr Payload(const uint8_t* data, size_t size)
+        : _data(data),
+          _size(size)
+    {
+    }
+
+    /**
+     * @return The first byte of the payload.
+     */
+    constexpr const uint8_t* data() const
+    {
+        return _data;
+    }
+
+    /**
+     * @return The number of bytes in the payload.
+     */
+    constexpr size_t size() const
+    {
+        return _size;
+    }
+
+    /**
+     * @return True if the payload holds no bytes, false otherwise.
+     */
+    constexpr bool empty() const
+    {
+        return _size == 0;
+    }
+
+    constexpr const uint8_t* begin() const
+    {
+        return _data;
+    }
+
+    constexpr const uint8_t* end() const
+    {
+        return _data + _size;
+    }
+
+private:
+    const uint8_t* _data;
+    size_t _size;
+};
+
+using TopicCallback = std::function<void(std::string_view, Payload)>;
 using ConnectionStatusCallback = std::function<void(mqtt_connection_status_t)>;
 
-static std::string toString(const Buffer& data)
+/**
+ * The MQTT QoS values.
+ *
+ * @see https://www.hivemq.com/blog/mqtt-essentials-part-6-mqtt-quality-of-service-levels/
+ */
+enum class QoS : uint8_t
 {
-    std::string result;
-    result.resize(data.size());
-    for (size_t i = 0; i < data.size(); i++) {
-        result[i] = static_cast<char>(data[i]);
-    }
-    return result;
+    /** MQTT will deliver the message at most once. */
+    AT_MOST_ONCE = 0,
+
+    /** MQTT will deliver the message at least once. */
+    AT_LEAST_ONCE = 1,
+
+    /** MQTT will deliver the message exactly once. */
+    EXACTLY_ONCE = 2
+};
+
+/**
+ * How messages on a topic are published.
+ */
+struct PublishPolicy
+{
+    /** The QoS of each message. */
+    QoS qos;
+
+    /** True if the broker should retain the latest message for new subscribers, false otherwise. */
+    bool retain;
+};
+
+/**
+ * @return The payload @a data as text, without copying it.
+ */
+inline std::string_view toString(Payload data)
+{
+    return std::string_view(reinterpret_cast<const char*>(data.data()), data.size());
 }
 } // namespace mqtt
\ No newline at end of file
@@ -5,11 +5,11 @@ SPDX-License-Identifier: BSD-3-Clause
 
 #include "connectivity/mqtt/detail/context.hpp"
 
+#include <algorithm>
 #include <cstdint>
 #include <cstdio>
-#include <functional>
-#include <string>
-#include <unordered_map>
+#include <string_view>
+#include <utility>
 
 
 namespace mqtt::detail {
@@ -25,69 +25,126 @@ void ContextInterface::onConnectionStatusChanged(mqtt_connection_status_t status
     }
 }
 
-void ContextInterface::subscribe(std::string_view topic, TopicCallback callback)
+bool ContextInterface::subscribe(std::string_view topic, TopicCallback callback)
 {
-    std::string topic_key(topic.data(), topic.size());
-    _callbacks[topic_key] = std::move(callback);
+    Subscription* subscription = _find(topic);
+    if (subscription == nullptr) {
+        if (topic.size() > MAX_TOPIC_SIZE || _subscription_count == _subscriptions.size()) {
+            printf("Context cannot subscribe to %.*s\n", static_cast<int>(topic.size()), topic.data());
+            return false;
+        }
+
+        subscription = &_subscriptions[_subscription_count++];
+        topic.copy(subscription->topic.data(), topic.size());
+        subscription->topic_size = static_cast<uint8_t>(topic.size());
+    }
+
+    subscription->callback = std::move(callback);
+    return true;
 }
 
 void ContextInterface::unsubscribe(std::string_view topic)
 {
-    std::string topic_key(topic.data(), topic.size());
-    auto callback_iteration = _callbacks.find(topic_key);
-    if (callback_iteration != _callbacks.cend()) {
-        _callbacks.erase(callback_iteration);
+    Subscription* subscription = _find(topic);
+    if (subscription == nullptr) {
+        return;
     }
+
+    Subscription& last = _subscriptions[--_subscription_count];
+    if (subscription != &last) {
+        *subscription = std::move(last);
+    }
+    last.callback = nullptr;
 }
 
 void ContextInterface::addPendingData(const uint8_t* data, uint16_t length)
 {
-    size_t desired = _current_index + length;
-    printf("Context receiving %u bytes on %s\n", length, _pending_topic.c_str());
-    if (desired > _buffer.size()) {
-        printf("Context buffer overrun (%u available, %u provided)", _buffer.size(), desired);
+    // lwIP may follow a message with no payload with an empty fragment, which belongs to no message.
+    if (!_receiving) {
         return;
     }
 
-    for (uint16_t i = 0; i < length; _current_index++, i++, _remaining_data--) {
-        _buffer[_current_index] = data[i];
+    uint32_t offset = _received_size;
+    _received_size += length;
+    bool complete = _received_size >= _expected_size;
+    if (!_discarding) {
+        if (offset == 0 && complete) {
+            _receiving = false;
+            _push(Payload(data, length));
+            return;
+        }
+
+        if (_received_size > _payload.size()) {
+            printf("Context discarding %u byte message on %.*s (%u available)\n", _expected_size, _pending_topic_size,
+                   _pending_topic.data(), static_cast<unsigned>(_payload.size()));
+            _discarding = true;
+        }
+        else {
+            std::copy(data, data + length, _payload.data() + offset);
+        }
     }
 
-    if (_remaining_data <= 0) {
-        printf("Context received all data on %s\n", _pending_topic.c_str());
-        _push();
+    if (complete) {
+        _receiving = false;
+        if (!_discarding) {
+            _push(Payload(_payload.data(), _received_size));
+        }
     }
 }
 
-void ContextInterface::setPendingTopic(const std::string& pending_topic, uint32_t pending_data)
+void ContextInterface::setPendingTopic(std::string_view pending_topic, uint32_t pending_data)
 {
-    printf("Context expecting %s (length: %u)\n", pending_topic.c_str(), pending_data);
+    _expected_size = pending_data;
+    _received_size = 0;
+    _discarding = pending_topic.size() > _pending_topic.size();
+    _receiving = pending_data > 0;
+    if (_discarding) {
+        printf("Context discarding message on a %u byte topic (%u available)\n", static_cast<unsigned>(pending_topic.size()),
+               static_cast<unsigned>(_pending_topic.size()));
+        return;
+    }
 
-    _pending_topic = pending_topic;
-    _current_index = 0;
-    _remaining_data = pending_data;
-    _buffer.clear();
+    pending_topic.copy(_pending_topic.data(), pending_topic.size());
+    _pending_topic_size = static_cast<uint8_t>(pending_topic.size());
     if (pending_data == 0) {
-        _push();
+        _push(Payload(_payload.data(), 0));
     }
-
-    _buffer.resize(pending_data);
 }
 
 ContextInterface::ContextInterface()
-    : _pending_topic(), _buffer(), _current_index(0), _remaining_data(0), _callbacks(), _connection_callback()
+    : _pending_topic(),
+      _pending_topic_size(0),
+      _payload(),
+      _expected_size(0),
+      _received_size(0),
+      _receiving(false),
+      _discarding(false),
+      _subscriptions(),
+      _subscription_count(0),
+      _connection_callback()
 {}
 
-void ContextInterface::_push()
+ContextInterface::Subscription* ContextInterface::_find(std::string_view topic)
+{
+    for (size_t index = 0; index < _subscription_count; index++) {
+        Subscription& subscription = _subscriptions[index];
+        if (std::string_view(subscription.topic.data(), subscription.topic_size) == topic) {
+            return &subscription;
+        }
+    }
+    return nullptr;
+}
+
+void ContextInterface::_push(Payload payload)
 {
-    auto callback_iteration = _callbacks.find(_pending_topic);
-    if (callback_iteration == _callbacks.cend() || !(callback_iteration->second)) {
-        printf("No callback registered for %s\n", _pending_topic.c_str());
+    std::string_view topic(_pending_topic.data(), _pending_topic_size);
+    Subscription* subscription = _find(topic);
+    if (subscription == nullptr || !subscription->callback) {
+        printf("No callback registered for %.*s\n", static_cast<int>(topic.size()), topic.data());
         return;
     }
 
-    printf("Executing callback for %s\n", _pending_topic.c_str());
-    callback_iteration->second(_pending_topic, _buffer);
+    subscription->callback(topic, payload);
 }
 
 Context& Context::instance()
@@ -6,20 +6,32 @@ SPDX-License-Identifier: BSD-3-Clause
 
 #include "connectivity/mqtt/common.hpp"
 
+#include <array>
+#include <cstddef>
 #include <cstdint>
-#include <cstdio>
-#include <functional>
-#include <string>
-#include <unordered_map>
+#include <string_view>
 
 
 namespace mqtt::detail {
 /**
  * An interface for modifying the MQTT context.
+ *
+ * Received messages are gathered in a statically sized arena rather than on the heap, so a burst of commands cannot
+ * fragment it. A message which arrives in a single fragment is not copied at all, and is handed to its callback straight
+ * from the MQTT stack's own buffer.
  */
 class ContextInterface
 {
 public:
+    /** The largest topic which can be subscribed to or received, which matches lwIP's default receive header buffer. */
+    static constexpr size_t MAX_TOPIC_SIZE = 128;
+
+    /** The largest payload which can be received in several fragments; larger messages are discarded. */
+    static constexpr size_t PAYLOAD_CAPACITY = 256;
+
+    /** The largest number of topics which can be subscribed to at once. */
+    static constexpr size_t MAX_SUBSCRIPTIONS = 8;
+
     /** Constructor. */
     ContextInterface();
 
@@ -39,12 +51,13 @@ public:
     void onConnectionStatusChanged(mqtt_connection_status_t status);
 
     /**
-     * Subscribes to a MQTT topic.
+     * Subscribes to a MQTT topic, replacing the callback of an existing subscription to it.
      *
      * @param[in] topic The topic to be subscribed to.
      * @param[in] callback The callback to be invoked when a complete message has been received on @a topic.
+     * @return True if the subscription was made, false if @a topic is too long or there are too many subscriptions.
      */
-    void subscribe(std::string_view topic, TopicCallback callback);
+    bool subscribe(std::string_view topic, TopicCallback callback);
 
     /**
      * Unsubscribes from a MQTT topic.
@@ -67,19 +80,40 @@ public:
      * @param[in] pending_topic The topic on which data is about to be received.
      * @param[in] pending_data The amount of data to be received.
      */
-    void setPendingTopic(const std::string& pending_topic, uint32_t pending_data);
+    void setPendingTopic(std::string_view pending_topic, uint32_t pending_data);
 
 private:
     /**
-     * Pushes pending MQTT data to any subscribed clients.
+     * A topic subscribed to, and the callback for the messages received on it.
+     */
+    struct Subscription
+    {
+        std::array<char, MAX_TOPIC_SIZE> topic;
+        uint8_t topic_size;
+        TopicCallback callback;
+    };
+
+    /**
+     * @return The subscription to @a topic, or nullptr if there is none.
      */
-    void _push();
+    Subscription* _find(std::string_view topic);
 
-    std::string _pending_topic;
-    Buffer _buffer;
-    size_t _current_index;
-    ssize_t _remaining_data;
-    std::unordered_map<std::string, TopicCallback> _callbacks;
+    /**
+     * Pushes a complete message on the pending topic to its subscriber.
+     *
+     * @param[in] payload The payload of the message.
+     */
+    void _push(Payload payload);
+
+    std::array<char, MAX_TOPIC_SIZE> _pending_topic;
+    uint8_t _pending_topic_size;
+    std::array<uint8_t, PAYLOAD_CAPACITY> _payload;
+    uint32_t _expected_size;
+    uint32_t _received_size;
+    bool _receiving;
+    bool _discarding;
+    std::array<Subscription, MAX_SUBSCRIPTIONS> _subscriptions;
+    size_t _subscription_count;
     ConnectionStatusCallback _connection_callback;
 };
 
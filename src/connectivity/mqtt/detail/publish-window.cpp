@@ -0,0 +1,146 @@
+/*------------------------------------------------------------------------------
+Copyright (c) 2023 Joe Porembski
+SPDX-License-Identifier: BSD-3-Clause
+------------------------------------------------------------------------------*/
+#include "connectivity/mqtt/detail/publish-window.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string_view>
+#include <utility>
+
+
+namespace mqtt::detail {
+const char* QueuedPublish::topic() const
+{
+    return text.data();
+}
+
+std::string_view QueuedPublish::payload() const
+{
+    return std::string_view(text.data() + topic_size + 1, payload_size);
+}
+
+PublishWindow::PublishWindow(uint8_t limit)
+    : _limit(std::min(limit, MAX_IN_FLIGHT)),
+      _in_flight(0),
+      _next_id(1),
+      _requests(),
+      _queue_start(0),
+      _queue_size(0),
+      _queue(),
+      _completion_callback()
+{
+}
+
+uint8_t PublishWindow::inFlight() const
+{
+    return _in_flight;
+}
+
+uint8_t PublishWindow::queued() const
+{
+    return _queue_size;
+}
+
+bool PublishWindow::ready() const
+{
+    return _in_flight < _limit && _queue_size == 0;
+}
+
+InFlightRequest* PublishWindow::open()
+{
+    if (_in_flight >= _limit) {
+        return nullptr;
+    }
+
+    for (InFlightRequest& request : _requests) {
+        if (request.id == 0) {
+            request.window = this;
+            request.id = _next_id;
+            // Identifiers wrap around like MQTT packet identifiers, skipping 0, which marks a free slot.
+            _next_id = _next_id == UINT16_MAX ? 1 : _next_id + 1;
+            _in_flight++;
+            return &request;
+        }
+    }
+    return nullptr;
+}
+
+void PublishWindow::close(InFlightRequest* request)
+{
+    if (request == nullptr || request->id == 0) {
+        return;
+    }
+
+    request->id = 0;
+    _in_flight--;
+}
+
+void PublishWindow::complete(InFlightRequest* request)
+{
+    close(request);
+    if (_completion_callback) {
+        _completion_callback();
+    }
+}
+
+void PublishWindow::setCompletionCallback(std::function<void()> callback)
+{
+    _completion_callback = std::move(callback);
+}
+
+void PublishWindow::reset()
+{
+    for (InFlightRequest& request : _requests) {
+        request.id = 0;
+    }
+    _in_flight = 0;
+}
+
+bool PublishWindow::enqueue(std::string_view topic, std::string_view payload, PublishPolicy policy)
+{
+    if (topic.size() + 1 + payload.size() > QueuedPublish::CAPACITY) {
+        return false;
+    }
+
+    QueuedPublish* entry = nullptr;
+    for (uint8_t index = 0; index < _queue_size && entry == nullptr; index++) {
+        QueuedPublish& queued = _queue[(_queue_start + index) % QUEUE_CAPACITY];
+        if (std::string_view(queued.topic(), queued.topic_size) == topic) {
+            entry = &queued;
+        }
+    }
+
+    if (entry == nullptr) {
+        if (_queue_size == QUEUE_CAPACITY) {
+            return false;
+        }
+        entry = &_queue[(_queue_start + _queue_size) % QUEUE_CAPACITY];
+        _queue_size++;
+    }
+
+    topic.copy(entry->text.data(), topic.size());
+    entry->text[topic.size()] = '\0';
+    payload.copy(entry->text.data() + topic.size() + 1, payload.size());
+    entry->topic_size = static_cast<uint8_t>(topic.size());
+    entry->payload_size = static_cast<uint8_t>(payload.size());
+    entry->policy = policy;
+    return true;
+}
+
+const QueuedPublish* PublishWindow::front() const
+{
+    return _queue_size > 0 ? &_queue[_queue_start] : nullptr;
+}
+
+void PublishWindow::pop()
+{
+    if (_queue_size > 0) {
+        _queue_start = (_queue_start + 1) % QUEUE_CAPACITY;
+        _queue_size--;
+    }
+}
+} // namespace mqtt::detail
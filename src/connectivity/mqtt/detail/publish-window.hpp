@@ -0,0 +1,172 @@
+/*------------------------------------------------------------------------------
+Copyright (c) 2023 Joe Porembski
+SPDX-License-Identifier: BSD-3-Clause
+------------------------------------------------------------------------------*/
+#pragma once
+
+#include "connectivity/mqtt/common.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string_view>
+
+
+namespace mqtt::detail {
+class PublishWindow;
+
+/**
+ * A request which has been handed to lwIP and not yet completed.
+ */
+struct InFlightRequest
+{
+    /** The window holding this request, so the completion callback can find it from the request alone. */
+    PublishWindow* window;
+
+    /** The identifier of the request, unique among recent requests; 0 while the slot is free. */
+    uint16_t id;
+};
+
+/**
+ * A publish which could not be sent straight away, held until there is room for it in the window.
+ */
+struct QueuedPublish
+{
+    /** The largest topic and payload held, together, including the null after the topic. */
+    static constexpr size_t CAPACITY = 160;
+
+    /** The topic, followed by a null and then the payload. */
+    std::array<char, CAPACITY> text;
+
+    /** The length of the topic. */
+    uint8_t topic_size;
+
+    /** The size of the payload in bytes. */
+    uint8_t payload_size;
+
+    /** How the publish is to be sent. */
+    PublishPolicy policy;
+
+    /**
+     * @return The topic, which is followed by a null.
+     */
+    const char* topic() const;
+
+    /**
+     * @return The payload.
+     */
+    std::string_view payload() const;
+};
+
+/**
+ * Tracks the requests in flight on an MQTT connection, and queues publishes while there is no room for more.
+ *
+ * lwIP holds each request (a publish, subscribe, or unsubscribe) in one of a fixed number of slots until it completes:
+ * once sent for QoS 0, or once acknowledged by the broker for QoS 1 and 2. A request made while every slot is taken is
+ * refused, so each one is opened here first, and publishes which find the window full are queued instead. A queued
+ * publish on a topic which is already queued replaces the earlier one, since only the latest value of a topic matters.
+ *
+ * The queue is statically sized, and holds short publishes only; a longer publish is left to its caller to retry.
+ */
+class PublishWindow
+{
+public:
+    /** The largest number of requests which can be tracked in flight. */
+    static constexpr uint8_t MAX_IN_FLIGHT = 8;
+
+    /** The largest number of publishes queued. */
+    static constexpr uint8_t QUEUE_CAPACITY = 24;
+
+    /**
+     * Constructor.
+     *
+     * @param[in] limit The number of requests lwIP can hold in flight, at most MAX_IN_FLIGHT.
+     */
+    explicit PublishWindow(uint8_t limit);
+
+    PublishWindow(const PublishWindow&) = delete;
+
+    PublishWindow& operator=(const PublishWindow&) = delete;
+
+    /**
+     * @return The number of requests in flight.
+     */
+    uint8_t inFlight() const;
+
+    /**
+     * @return The number of publishes queued.
+     */
+    uint8_t queued() const;
+
+    /**
+     * @return True if a publish made now would be sent straight away, false if it would have to wait.
+     */
+    bool ready() const;
+
+    /**
+     * Reserves a slot for a new request.
+     *
+     * @return The request, which is passed to lwIP as the argument of its completion callback, or nullptr if every
+     * slot is taken.
+     */
+    InFlightRequest* open();
+
+    /**
+     * Frees the slot of a request which completed, or which lwIP refused.
+     *
+     * @param[in] request The request returned by open().
+     */
+    void close(InFlightRequest* request);
+
+    /**
+     * Frees the slot of a request which lwIP completed, and invokes the callback set by setCompletionCallback().
+     *
+     * @param[in] request The request returned by open().
+     */
+    void complete(InFlightRequest* request);
+
+    /**
+     * Sets the callback invoked whenever a request completes, freeing a slot.
+     *
+     * @param[in] callback The callback.
+     */
+    void setCompletionCallback(std::function<void()> callback);
+
+    /**
+     * Frees every slot, for when the connection drops and lwIP discards its requests without completing them. Queued
+     * publishes are kept.
+     */
+    void reset();
+
+    /**
+     * Queues a publish until there is room for it, replacing any publish queued on the same topic.
+     *
+     * @param[in] topic The topic.
+     * @param[in] payload The payload.
+     * @param[in] policy How the publish is to be sent.
+     * @return True if the publish was queued, false if the queue is full or it is too long to queue.
+     */
+    bool enqueue(std::string_view topic, std::string_view payload, PublishPolicy policy);
+
+    /**
+     * @return The oldest queued publish, or nullptr if nothing is queued.
+     */
+    const QueuedPublish* front() const;
+
+    /**
+     * Removes the oldest queued publish, once it has been sent.
+     */
+    void pop();
+
+private:
+    uint8_t _limit;
+    uint8_t _in_flight;
+    uint16_t _next_id;
+    std::array<InFlightRequest, MAX_IN_FLIGHT> _requests;
+    uint8_t _queue_start;
+    uint8_t _queue_size;
+    std::array<QueuedPublish, QUEUE_CAPACITY> _queue;
+    std::function<void()> _completion_callback;
+};
+} // namespace mqtt::detail
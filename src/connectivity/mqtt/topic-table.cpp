@@ -0,0 +1,74 @@
+/*------------------------------------------------------------------------------
+Copyright (c) 2023 Joe Porembski
+SPDX-License-Identifier: BSD-3-Clause
+------------------------------------------------------------------------------*/
+#include "connectivity/mqtt/topic-table.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+
+inline constexpr std::string_view DEVICE_NAME_PLACEHOLDER = "%s";
+
+namespace mqtt {
+TopicTable::TopicTable()
+    : _count(0),
+      _offsets(),
+      _policies(),
+      _text()
+{
+}
+
+bool TopicTable::build(const TopicDefinition* topics, size_t count, std::string_view device_name)
+{
+    _count = 0;
+    if (count > MAX_TOPICS) {
+        return false;
+    }
+
+    size_t size = 0;
+    auto append = [&](std::string_view text) {
+        if (text.size() > CAPACITY - size) {
+            return false;
+        }
+        size += text.copy(_text.data() + size, text.size());
+        return true;
+    };
+
+    for (size_t index = 0; index < count; index++) {
+        _offsets[index] = static_cast<uint16_t>(size);
+        _policies[index] = topics[index].policy;
+        std::string_view format = topics[index].format;
+        for (size_t placeholder = format.find(DEVICE_NAME_PLACEHOLDER); placeholder != std::string_view::npos;
+             placeholder = format.find(DEVICE_NAME_PLACEHOLDER)) {
+            if (!append(format.substr(0, placeholder)) || !append(device_name)) {
+                return false;
+            }
+            format.remove_prefix(placeholder + DEVICE_NAME_PLACEHOLDER.size());
+        }
+
+        if (!append(format) || !append(std::string_view("", 1))) {
+            return false;
+        }
+    }
+
+    _count = count;
+    return true;
+}
+
+size_t TopicTable::size() const
+{
+    return _count;
+}
+
+const char* TopicTable::operator[](size_t index) const
+{
+    return index < _count ? _text.data() + _offsets[index] : "";
+}
+
+PublishPolicy TopicTable::policy(size_t index) const
+{
+    return index < _count ? _policies[index] : PublishPolicy{QoS::AT_MOST_ONCE, false};
+}
+} // namespace mqtt
@@ -0,0 +1,83 @@
+/*------------------------------------------------------------------------------
+Copyright (c) 2023 Joe Porembski
+SPDX-License-Identifier: BSD-3-Clause
+------------------------------------------------------------------------------*/
+#pragma once
+
+#include "connectivity/mqtt/common.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+
+namespace mqtt {
+/**
+ * Describes a topic, before the device name is known.
+ */
+struct TopicDefinition
+{
+    /** The format of the topic, in which "%s" stands for the device name. */
+    std::string_view format;
+
+    /** How messages are published on the topic. */
+    PublishPolicy policy;
+};
+
+/**
+ * Holds the full topic strings for a device, built once from their formats so they do not have to be formatted again
+ * for every publish.
+ *
+ * The topics are packed one after another into a single statically sized block, each followed by a null, so they can
+ * be passed straight to the client.
+ */
+class TopicTable
+{
+public:
+    /** The largest number of characters held across all the topics, including their terminating nulls. */
+    static constexpr size_t CAPACITY = 2048;
+
+    /** The largest number of topics held. */
+    static constexpr size_t MAX_TOPICS = 32;
+
+    TopicTable();
+
+    TopicTable(const TopicTable&) = delete;
+
+    TopicTable& operator=(const TopicTable&) = delete;
+
+    /**
+     * Builds the topics, replacing every "%s" in each format with @a device_name.
+     *
+     * @param[in] topics The topic definitions, in the order the topics are looked up.
+     * @param[in] count The number of definitions.
+     * @param[in] device_name The name of the device.
+     * @return True if the table was built, false if the topics do not fit, which leaves the table empty.
+     */
+    bool build(const TopicDefinition* topics, size_t count, std::string_view device_name);
+
+    /**
+     * @return The number of topics held.
+     */
+    size_t size() const;
+
+    /**
+     * @param[in] index The position of the topic's definition in the definitions passed to build().
+     * @return The topic, or an empty string if there is no topic at @a index.
+     */
+    const char* operator[](size_t index) const;
+
+    /**
+     * @param[in] index The position of the topic's definition in the definitions passed to build().
+     * @return How messages are published on the topic at @a index.
+     */
+    PublishPolicy policy(size_t index) const;
+
+private:
+    size_t _count;
+    std::array<uint16_t, MAX_TOPICS> _offsets;
+    std::array<PublishPolicy, MAX_TOPICS> _policies;
+    std::array<char, CAPACITY> _text;
+};
+} // namespace mqtt
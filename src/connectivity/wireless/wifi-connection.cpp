@@ -18,7 +18,21 @@ SPDX-License-Identifier: BSD-3-Clause
 #include <cstdint>
 #include <string>
 
-inline constexpr uint32_t RECONNECT_TIMEOUT_MS = 60000;
+
+/** The callback for connection changes; there is only one wireless interface, so only one connection. */
+static WifiStatusCallback status_callback;
+
+/**
+ * Handler for link and IP address changes on the wireless interface.
+ *
+ * @param[in] interface The network interface.
+ */
+static void onInterfaceChanged(struct netif* /* unused */)
+{
+    if (status_callback) {
+        status_callback();
+    }
+}
 
 /**
  * A RAII-style locking mechanism for the CYW43 lwIP stack.
@@ -115,11 +129,12 @@ ConnectionStatus WifiConnection::status() const
     }
 }
 
-void WifiConnection::poll()
+void WifiConnection::setStatusCallback(WifiStatusCallback callback)
 {
-    // This call is being used to maximize the windows of time in which this
-    // application is available to do work for the CYW43.
-    cyw43_arch_wait_for_work_until(make_timeout_time_ms(POLL_WAIT_TIME_MS));
+    WifiLock lock;
+    status_callback = callback;
+    netif_set_link_callback(_interface, onInterfaceChanged);
+    netif_set_status_callback(_interface, onInterfaceChanged);
 }
 
 void WifiConnection::reset()
@@ -134,10 +149,10 @@ void WifiConnection::_connectToWireless()
 
     int32_t result = INT32_MIN;
     if (_passphrase.size() == 0) {
-        result = cyw43_arch_wifi_connect_timeout_ms(_ssid.c_str(), NULL, CYW43_AUTH_OPEN, WIFI_TIMEOUT_MS);
+        result = cyw43_arch_wifi_connect_async(_ssid.c_str(), NULL, CYW43_AUTH_OPEN);
     }
     else {
-        result = cyw43_arch_wifi_connect_timeout_ms(_ssid.c_str(), _passphrase.c_str(), CYW43_AUTH_WPA2_AES_PSK, WIFI_TIMEOUT_MS);
+        result = cyw43_arch_wifi_connect_async(_ssid.c_str(), _passphrase.c_str(), CYW43_AUTH_WPA2_AES_PSK);
     }
 
     if (result != PICO_OK) {
@@ -145,7 +160,7 @@ void WifiConnection::_connectToWireless()
         return;
     }
 
-    printf("Connected to %s\n", _ssid.c_str());
+    // The link comes up in the background, which is reported through the status callback.
     netif_set_up(_interface);
 }
 
@@ -10,12 +10,14 @@ SPDX-License-Identifier: BSD-3-Clause
 
 #include <array>
 #include <cstdint>
+#include <functional>
 #include <string>
 
 
 struct WifiState; // Forward declaration of WifiState
 
 using MACAddress = std::array<uint8_t, 6>;
+using WifiStatusCallback = std::function<void()>;
 
 /**
  * An encapsulation of a connection to a wireless network.
@@ -69,20 +71,20 @@ public:
     ConnectionStatus status() const;
 
     /**
-     * Requests this connection to perform any necessary maintenance tasks.
+     * Sets the callback invoked from the lwIP context whenever the link goes up or down, or the IP address changes.
      *
-     * This method should be called periodically from the main thread.
+     * @param[in] callback The callback to use when the connection changes.
      */
-    void poll();
+    void setStatusCallback(WifiStatusCallback callback);
 
     /**
-     * Resets the connection to the SSID.
+     * Restarts connecting to the SSID, without waiting for the connection to complete.
      */
     void reset();
 
 private:
     /**
-     * Helper method to connect to the defined wireless network.
+     * Helper method to start connecting to the defined wireless network.
      */
     void _connectToWireless();
 
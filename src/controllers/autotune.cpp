@@ -0,0 +1,170 @@
+/*------------------------------------------------------------------------------
+Copyright (c) 2023 Joe Porembski
+SPDX-License-Identifier: BSD-3-Clause
+------------------------------------------------------------------------------*/
+#include "controllers/autotune.hpp"
+
+#include "constants.hpp"
+
+#include <pico/stdio.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <string_view>
+
+
+namespace controllers {
+inline constexpr std::string_view AUTOTUNE_STATE_IDLE = "idle";
+inline constexpr std::string_view AUTOTUNE_STATE_RUNNING = "running";
+inline constexpr std::string_view AUTOTUNE_STATE_SUCCEEDED = "succeeded";
+inline constexpr std::string_view AUTOTUNE_STATE_FAILED = "failed";
+
+/** The relay swings the output between 0 and 100%, so its amplitude is half of that. */
+inline constexpr int64_t RELAY_AMPLITUDE = toCenti(100) / 2;
+
+/** 355/113 approximates pi to within 0.00001%. */
+inline constexpr int64_t PI_NUMERATOR = 355;
+inline constexpr int64_t PI_DENOMINATOR = 113;
+
+std::string_view toString(AutotuneState state)
+{
+    switch (state) {
+    case AutotuneState::RUNNING:
+        return AUTOTUNE_STATE_RUNNING;
+    case AutotuneState::SUCCEEDED:
+        return AUTOTUNE_STATE_SUCCEEDED;
+    case AutotuneState::FAILED:
+        return AUTOTUNE_STATE_FAILED;
+    case AutotuneState::IDLE:
+    default:
+        return AUTOTUNE_STATE_IDLE;
+    }
+}
+
+RelayAutotune::RelayAutotune()
+    : _gains(),
+      _state(AutotuneState::IDLE),
+      _setpoint(0),
+      _cycle_maximum(0),
+      _cycle_minimum(0),
+      _heating(false),
+      _cycle_count(0),
+      _amplitude_sum(0),
+      _period_sum(0),
+      _start_timepoint(0),
+      _cycle_timepoint(0)
+{}
+
+AutotuneState RelayAutotune::state() const
+{
+    return _state;
+}
+
+const PIDGains& RelayAutotune::gains() const
+{
+    return _gains;
+}
+
+void RelayAutotune::begin(Centidegrees setpoint, uint64_t timepoint)
+{
+    printf("Starting auto-tune around %sC\n", centiToString(setpoint).c_str());
+    _state = AutotuneState::RUNNING;
+    _setpoint = setpoint;
+    _heating = true;
+    _cycle_count = 0;
+    _amplitude_sum = 0;
+    _period_sum = 0;
+    _start_timepoint = timepoint;
+    _cycle_timepoint = 0;
+}
+
+void RelayAutotune::cancel()
+{
+    if (_state == AutotuneState::RUNNING) {
+        printf("Auto-tune cancelled\n");
+        _state = AutotuneState::FAILED;
+    }
+}
+
+void RelayAutotune::interrupt(std::string_view reason)
+{
+    // Until the first cycle starts the container is only warming up to the setpoint, which is not measured, so a limit
+    // which delays that only delays the auto-tune.
+    if (_state == AutotuneState::RUNNING && _cycle_timepoint != 0) {
+        printf("Auto-tune interrupted after %u of %u cycles: %s\n", _cycle_count, AUTOTUNE_SETTLE_CYCLES + AUTOTUNE_CYCLES, reason.data());
+        _state = AutotuneState::FAILED;
+    }
+}
+
+bool RelayAutotune::update(Centidegrees measurement, uint64_t timepoint)
+{
+    if (_state != AutotuneState::RUNNING) {
+        return false;
+    }
+
+    if (timepoint - _start_timepoint > AUTOTUNE_TIMEOUT_MS) {
+        printf("Auto-tune timed out after %u of %u cycles\n", _cycle_count, AUTOTUNE_SETTLE_CYCLES + AUTOTUNE_CYCLES);
+        _state = AutotuneState::FAILED;
+        return false;
+    }
+
+    _cycle_maximum = std::max(_cycle_maximum, measurement);
+    _cycle_minimum = std::min(_cycle_minimum, measurement);
+
+    bool was_heating = _heating;
+    if (_heating && measurement > _setpoint + AUTOTUNE_NOISE_BAND) {
+        _heating = false;
+    }
+    else if (!_heating && measurement < _setpoint - AUTOTUNE_NOISE_BAND) {
+        _heating = true;
+    }
+
+    // A cycle runs from one time the relay logic switches on to the next. The caller interrupts the auto-tune if a safety
+    // limit stops the relay from following it, so these are also the times the relay switched.
+    if (_heating && !was_heating) {
+        if (_cycle_timepoint != 0) {
+            _cycle_count++;
+            if (_cycle_count > AUTOTUNE_SETTLE_CYCLES) {
+                _amplitude_sum += (_cycle_maximum - _cycle_minimum) / 2;
+                _period_sum += timepoint - _cycle_timepoint;
+            }
+        }
+
+        _cycle_timepoint = timepoint;
+        _cycle_maximum = measurement;
+        _cycle_minimum = measurement;
+    }
+
+    if (_cycle_count >= AUTOTUNE_SETTLE_CYCLES + AUTOTUNE_CYCLES) {
+        _complete();
+        return false;
+    }
+    return _heating;
+}
+
+void RelayAutotune::_complete()
+{
+    int64_t amplitude = _amplitude_sum / AUTOTUNE_CYCLES;
+    uint64_t period_ms = _period_sum / AUTOTUNE_CYCLES;
+    if (amplitude <= 0) {
+        printf("Auto-tune saw no oscillation\n");
+        _state = AutotuneState::FAILED;
+        return;
+    }
+
+    // Ku = 4d / (pi * a), where the amplitude is in hundredths of a degree and the gain is per whole degree.
+    int64_t ultimate_gain = (4 * RELAY_AMPLITUDE * CENTI_PER_UNIT * PI_DENOMINATOR) / (PI_NUMERATOR * amplitude);
+    _gains.proportional = static_cast<int32_t>((ultimate_gain * 6) / 10);
+    _gains.integral_time_ms = static_cast<uint32_t>(period_ms / 2);
+    _gains.derivative_time_ms = static_cast<uint32_t>(period_ms / 8);
+    _state = AutotuneState::SUCCEEDED;
+
+    printf("Auto-tune measured amplitude %sC, period %llums: Kp %s%%/C, Ti %ums, Td %ums\n",
+           centiToString(static_cast<int32_t>(amplitude)).c_str(),
+           static_cast<unsigned long long>(period_ms),
+           centiToString(_gains.proportional).c_str(),
+           _gains.integral_time_ms,
+           _gains.derivative_time_ms);
+}
+} // namespace controllers
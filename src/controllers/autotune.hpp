@@ -0,0 +1,119 @@
+/*------------------------------------------------------------------------------
+Copyright (c) 2023 Joe Porembski
+SPDX-License-Identifier: BSD-3-Clause
+------------------------------------------------------------------------------*/
+#pragma once
+
+#include "controllers/pid.hpp"
+#include "measurement.hpp"
+
+#include <cstdint>
+#include <string_view>
+
+
+namespace controllers {
+/**
+ * Enumerates the states of a relay auto-tune.
+ */
+enum class AutotuneState : uint8_t
+{
+    /** No auto-tune has been run. */
+    IDLE,
+
+    /** The relay is being cycled around the setpoint. */
+    RUNNING,
+
+    /** The auto-tune completed, and its gains are available. */
+    SUCCEEDED,
+
+    /** The auto-tune did not see a steady oscillation before timing out, or a safety limit overrode the relay. */
+    FAILED
+};
+
+/**
+ * Converts @a state to a human readable string.
+ *
+ * @param[in] state The AutotuneState value.
+ * @return A human readable name for @a state.
+ */
+std::string_view toString(AutotuneState state);
+
+/**
+ * Derives PID gains with an Astrom-Hagglund relay experiment.
+ *
+ * The relay switches the heater fully on below the setpoint and fully off above it (with a small noise band), which
+ * drives the container into a steady oscillation. The ultimate gain follows from the relay amplitude d and the
+ * oscillation amplitude a as Ku = 4d / (pi * a), the ultimate period Tu is the oscillation period, and the gains are
+ * given by the classic Ziegler-Nichols rules: Kp = 0.6 Ku, Ti = Tu / 2, Td = Tu / 8.
+ *
+ * This only decides when the relay should be on; the caller switches it, so all of its safety limits still apply. A
+ * limit which overrides the relay ends the auto-tune through interrupt(), since the cycles are timed from this relay
+ * logic and would no longer match the relay.
+ */
+class RelayAutotune
+{
+public:
+    /** Constructor. */
+    RelayAutotune();
+
+    /**
+     * @return The state of the auto-tune.
+     */
+    AutotuneState state() const;
+
+    /**
+     * @note Only valid once state() is AutotuneState::SUCCEEDED.
+     * @return The derived gains.
+     */
+    const PIDGains& gains() const;
+
+    /**
+     * Starts an auto-tune.
+     *
+     * @param[in] setpoint The temperature to oscillate around in hundredths of a degree Celsius.
+     * @param[in] timepoint The current time in milliseconds since boot.
+     */
+    void begin(Centidegrees setpoint, uint64_t timepoint);
+
+    /**
+     * Stops a running auto-tune, marking it as failed.
+     */
+    void cancel();
+
+    /**
+     * Stops a running auto-tune because a safety limit overrode the relay, marking it as failed. The cycles it measured
+     * would otherwise include the limit's timing rather than the container's. Before the first cycle starts, while the
+     * container warms up to the setpoint, nothing is measured, so the auto-tune carries on.
+     *
+     * @param[in] reason The limit which overrode the relay, e.g. "maximum on time reached".
+     */
+    void interrupt(std::string_view reason);
+
+    /**
+     * Updates the auto-tune with a new measurement.
+     *
+     * @param[in] measurement The measured temperature in hundredths of a degree Celsius.
+     * @param[in] timepoint The time of @a measurement in milliseconds since boot.
+     * @return True if the relay should be on, false otherwise.
+     */
+    bool update(Centidegrees measurement, uint64_t timepoint);
+
+private:
+    /**
+     * Completes the auto-tune, deriving the gains from the measured cycles.
+     */
+    void _complete();
+
+    PIDGains _gains;
+    AutotuneState _state;
+    Centidegrees _setpoint;
+    Centidegrees _cycle_maximum;
+    Centidegrees _cycle_minimum;
+    bool _heating;
+    uint8_t _cycle_count;
+    int64_t _amplitude_sum;
+    uint64_t _period_sum;
+    uint64_t _start_timepoint;
+    uint64_t _cycle_timepoint;
+};
+} // namespace controllers
@@ -5,13 +5,30 @@ SPDX-License-Identifier: BSD-3-Clause
 #pragma once
 
 #include "gpio.hpp"
+#include "measurement.hpp"
 
-#include <cfloat>
 #include <climits>
 #include <cstdint>
 
 
-inline constexpr float DEFAULT_TEMPERATURE = FLT_MIN;
-inline constexpr float MINIMUM_TARGET_TEMPERATURE = FLT_MIN;
-inline constexpr float MINIMUM_HYSTERESIS = 1.0f;
+inline constexpr Centidegrees DEFAULT_TEMPERATURE = 0;
+inline constexpr Centidegrees MINIMUM_TARGET_TEMPERATURE = 0;
+inline constexpr Centidegrees MINIMUM_HYSTERESIS = toCenti(1);
 inline constexpr uint32_t MINIMUM_OFF_TIME_MS = 60 * 1000;
+inline constexpr uint32_t MINIMUM_ON_TIME_MS = 5 * 1000;
+inline constexpr int32_t HEATER_GUARD_PERIOD_MS = 100;
+inline constexpr uint32_t HEATER_GUARD_TIMEOUT_MS = 30 * 1000;
+inline constexpr Centidegrees OVER_TEMPERATURE_MARGIN = toCenti(10);
+inline constexpr Centidegrees HEATER_CUTOFF_TEMPERATURE = toCenti(85);
+inline constexpr uint32_t DEFAULT_PID_WINDOW_MS = 300 * 1000;
+inline constexpr uint32_t MINIMUM_PID_WINDOW_MS = 2 * MINIMUM_OFF_TIME_MS;
+inline constexpr int32_t DEFAULT_PID_PROPORTIONAL = toCenti(10);
+inline constexpr uint32_t DEFAULT_PID_INTEGRAL_TIME_MS = 600 * 1000;
+inline constexpr uint32_t DEFAULT_PID_DERIVATIVE_TIME_MS = 60 * 1000;
+inline constexpr Centidegrees AUTOTUNE_NOISE_BAND = 50;
+inline constexpr uint8_t AUTOTUNE_SETTLE_CYCLES = 1;
+inline constexpr uint8_t AUTOTUNE_CYCLES = 3;
+inline constexpr uint64_t AUTOTUNE_TIMEOUT_MS = 4 * 60 * 60 * 1000;
+inline constexpr Centidegrees PROFILE_RAMP_STEP = 50;
+inline constexpr Centidegrees PROFILE_TARGET_BAND = toCenti(1);
+inline constexpr uint32_t PROFILE_DRY_HOLD_MS = 30 * 60 * 1000;
@@ -10,19 +10,72 @@ SPDX-License-Identifier: BSD-3-Clause
 #include <hardware/gpio.h>
 #include <pico/stdio.h>
 
+#include <algorithm>
 #include <cstdint>
 #include <cstdio>
+#include <string_view>
 
 
 namespace controllers {
-Heater::Heater(uint8_t control_pin, uint8_t feedback_pin, float hysteresis, uint64_t max_on_time)
+inline constexpr std::string_view HEATER_MODE_HYSTERESIS = "hysteresis";
+inline constexpr std::string_view HEATER_MODE_PID = "pid";
+inline constexpr std::string_view HEATER_MODE_AUTOTUNE = "autotune";
+inline constexpr PIDGains DEFAULT_PID_GAINS = {DEFAULT_PID_PROPORTIONAL, DEFAULT_PID_INTEGRAL_TIME_MS, DEFAULT_PID_DERIVATIVE_TIME_MS};
+inline constexpr int64_t FULL_DUTY = toCenti(100);
+
+std::string_view toString(HeaterMode mode)
+{
+    switch (mode) {
+    case HeaterMode::PID:
+        return HEATER_MODE_PID;
+    case HeaterMode::AUTOTUNE:
+        return HEATER_MODE_AUTOTUNE;
+    case HeaterMode::HYSTERESIS:
+    default:
+        return HEATER_MODE_HYSTERESIS;
+    }
+}
+
+bool fromString(std::string_view text, HeaterMode& mode)
+{
+    if (text == HEATER_MODE_HYSTERESIS) {
+        mode = HeaterMode::HYSTERESIS;
+        return true;
+    }
+
+    if (text == HEATER_MODE_PID) {
+        mode = HeaterMode::PID;
+        return true;
+    }
+
+    if (text == HEATER_MODE_AUTOTUNE) {
+        mode = HeaterMode::AUTOTUNE;
+        return true;
+    }
+
+    return false;
+}
+
+Heater::Heater(uint8_t control_pin, uint8_t feedback_pin, Centidegrees hysteresis, uint64_t max_on_time)
     : _max_on_time(max_on_time),
       _feedback_pin(feedback_pin),
       _control_pin(control_pin),
       _hysteresis(hysteresis),
       _target_temperature(DEFAULT_TEMPERATURE),
       _on_timepoint(),
-      _off_timepoint()
+      _off_timepoint(),
+      _mode(HeaterMode::HYSTERESIS),
+      _resume_mode(HeaterMode::HYSTERESIS),
+      _pid(DEFAULT_PID_GAINS),
+      _autotune(),
+      _window_ms(DEFAULT_PID_WINDOW_MS),
+      _window_start(),
+      _window_finished(false),
+      _max_on_alarm(0),
+      _guard_timer(),
+      _guard_armed(false),
+      _update_timepoint(0),
+      _cutoff(Cutoff::NONE)
 {
     // Hysteresis must be positive in order to prevent the controller from latching into one state.
     if (_hysteresis < MINIMUM_HYSTERESIS) {
@@ -44,44 +97,230 @@ bool Heater::isOn() const
     return gpio_get(_control_pin);
 }
 
-float Heater::targetTemperature() const
+HeaterMode Heater::mode() const
+{
+    return _mode;
+}
+
+AutotuneState Heater::autotuneState() const
+{
+    return _autotune.state();
+}
+
+const PIDGains& Heater::autotuneGains() const
+{
+    return _autotune.gains();
+}
+
+const PIDGains& Heater::gains() const
+{
+    return _pid.gains();
+}
+
+Centipercent Heater::duty() const
+{
+    return _mode == HeaterMode::PID ? _pid.output() : 0;
+}
+
+uint32_t Heater::window() const
+{
+    return _window_ms;
+}
+
+void Heater::setMode(HeaterMode mode)
+{
+    if (_mode == mode) {
+        printf("Heater already in %s mode\n", toString(mode).data());
+        return;
+    }
+
+    printf("Heater switching to %s mode\n", toString(mode).data());
+    if (_mode == HeaterMode::AUTOTUNE) {
+        _autotune.cancel();
+    }
+    else {
+        _resume_mode = _mode;
+    }
+
+    _mode = mode;
+    _pid.reset();
+    _window_start = milliseconds();
+    _window_finished = false;
+
+    if (_mode == HeaterMode::AUTOTUNE) {
+        _autotune.begin(_target_temperature, _window_start);
+    }
+}
+
+void Heater::setGains(const PIDGains& gains)
+{
+    printf("Heater has new PID gains: Kp %s%%/C, Ti %ums, Td %ums\n",
+           centiToString(gains.proportional).c_str(),
+           gains.integral_time_ms,
+           gains.derivative_time_ms);
+    _pid.setGains(gains);
+}
+
+void Heater::setWindow(uint32_t window_ms)
+{
+    if (window_ms < MINIMUM_PID_WINDOW_MS) {
+        printf("PID window of %ums must be at least %ums\n", window_ms, MINIMUM_PID_WINDOW_MS);
+        return;
+    }
+
+    printf("Heater has new PID window of %ums\n", window_ms);
+    _window_ms = window_ms;
+}
+
+Centidegrees Heater::targetTemperature() const
 {
     return _target_temperature;
 }
 
-void Heater::setTargetTemperature(float target_temperature)
+void Heater::setTargetTemperature(Centidegrees target_temperature)
 {
     if (target_temperature < MINIMUM_TARGET_TEMPERATURE) {
-        printf("Target temperature of %.1fC must be greater than %.1fC\n", target_temperature, MINIMUM_TARGET_TEMPERATURE);
+        printf("Target temperature of %sC must be greater than %sC\n",
+               centiToString(target_temperature).c_str(),
+               centiToString(MINIMUM_TARGET_TEMPERATURE).c_str());
         return;
     }
 
     if (_target_temperature == target_temperature) {
-        printf("Heater already has target temperature of %.1fC\n", target_temperature);
+        printf("Heater already has target temperature of %sC\n", centiToString(target_temperature).c_str());
         return;
     }
 
-    printf("Heater has new target temperature of %.1fC\n", target_temperature);
+    printf("Heater has new target temperature of %sC\n", centiToString(target_temperature).c_str());
     _target_temperature = target_temperature;
 }
 
-void Heater::update(float actual_temperature)
+void Heater::update(const Sample& actual_temperature)
 {
-    float off_threshold = _target_temperature + _hysteresis;
-    float on_threshold = _target_temperature - _hysteresis;
-    bool is_on = isOn();
     uint64_t current_timepoint = milliseconds();
+    _update_timepoint = static_cast<uint32_t>(current_timepoint);
+    _handleCutoff();
 
-    if (is_on && ((actual_temperature > off_threshold) || (current_timepoint - _on_timepoint > _max_on_time))) {
-        _off();
+    Centidegrees cutoff_temperature = std::min<int32_t>(_target_temperature + OVER_TEMPERATURE_MARGIN, HEATER_CUTOFF_TEMPERATURE);
+    if (actual_temperature.quality == SampleQuality::GOOD && actual_temperature.value > cutoff_temperature) {
+        if (isOn()) {
+            printf("Temperature of %sC is above the cut-off of %sC\n",
+                   centiToString(actual_temperature.value).c_str(),
+                   centiToString(cutoff_temperature).c_str());
+            _off();
+            _window_finished = true;
+            _autotune.interrupt("over temperature");
+        }
+        return;
     }
-    else if (!is_on && (actual_temperature < on_threshold)) {
-        _on();
+
+    if (actual_temperature.quality == SampleQuality::INVALID) {
+        if (isOn()) {
+            printf("No valid temperature for %u milliseconds\n", actual_temperature.age_ms);
+            _off();
+            _autotune.interrupt("no valid temperature");
+        }
+        return;
+    }
+
+    switch (_mode) {
+    case HeaterMode::PID:
+        _updatePID(actual_temperature, current_timepoint);
+        break;
+    case HeaterMode::AUTOTUNE:
+        _updateAutotune(actual_temperature, current_timepoint);
+        break;
+    case HeaterMode::HYSTERESIS:
+    default:
+        _updateHysteresis(actual_temperature, current_timepoint);
+        break;
+    }
+}
+
+int64_t Heater::_onMaxOnTime(alarm_id_t /* unused */, void* user_data)
+{
+    Heater* heater = static_cast<Heater*>(user_data);
+    heater->_max_on_alarm = 0;
+    heater->_cutOff(Cutoff::MAX_ON_TIME);
+    return 0;
+}
+
+bool Heater::_onGuard(repeating_timer_t* timer)
+{
+    Heater* heater = static_cast<Heater*>(timer->user_data);
+    if (!heater->isOn()) {
+        heater->_guard_armed = false;
+        return false;
+    }
+
+    // The update timepoint is truncated to 32 bits so that it is written atomically; the difference still holds.
+    uint32_t since_update = static_cast<uint32_t>(milliseconds()) - heater->_update_timepoint;
+    if (since_update > HEATER_GUARD_TIMEOUT_MS) {
+        heater->_cutOff(Cutoff::STALLED);
+        heater->_guard_armed = false;
+        return false;
+    }
+    return true;
+}
+
+bool Heater::_arm()
+{
+    _max_on_alarm = alarm_pool_add_alarm_in_ms(controlAlarmPool(), static_cast<uint32_t>(_max_on_time), _onMaxOnTime, this, true);
+    if (_max_on_alarm <= 0) {
+        _max_on_alarm = 0;
+        return false;
+    }
+
+    _guard_armed = alarm_pool_add_repeating_timer_ms(controlAlarmPool(), HEATER_GUARD_PERIOD_MS, _onGuard, this, &_guard_timer);
+    if (!_guard_armed) {
+        _disarm();
+        return false;
+    }
+    return true;
+}
+
+void Heater::_disarm()
+{
+    if (_max_on_alarm > 0) {
+        alarm_pool_cancel_alarm(controlAlarmPool(), _max_on_alarm);
+        _max_on_alarm = 0;
+    }
+
+    if (_guard_armed) {
+        cancel_repeating_timer(&_guard_timer);
+        _guard_armed = false;
     }
 }
 
+void Heater::_cutOff(Cutoff reason)
+{
+    gpio_put(_control_pin, OFF);
+    if (_feedback_pin < NUM_BANK0_GPIOS) {
+        gpio_put(_feedback_pin, OFF);
+    }
+    _cutoff = reason;
+}
+
+void Heater::_handleCutoff()
+{
+    Cutoff reason = _cutoff;
+    if (reason == Cutoff::NONE) {
+        return;
+    }
+
+    // The cut-off may have been up to a control period ago, so timing the off period from now only lengthens it.
+    _cutoff = Cutoff::NONE;
+    _disarm();
+    _off_timepoint = milliseconds();
+    _window_finished = true;
+    std::string_view description = reason == Cutoff::MAX_ON_TIME ? "maximum on time reached" : "control loop stalled";
+    printf("Heater was cut off: %s\n", description.data());
+    _autotune.interrupt(description);
+}
+
 void Heater::_off()
 {
+    _disarm();
     _off_timepoint = milliseconds();
 
     printf("Turning off Heater...\n");
@@ -92,14 +331,122 @@ void Heater::_off()
     }
 }
 
+uint64_t Heater::_onSlice(Centipercent duty) const
+{
+    uint64_t slice = (static_cast<uint64_t>(_window_ms) * duty) / FULL_DUTY;
+    if (slice < MINIMUM_ON_TIME_MS) {
+        return 0;
+    }
+
+    if (slice >= _window_ms) {
+        return _window_ms;
+    }
+
+    return std::min<uint64_t>(slice, _window_ms - MINIMUM_OFF_TIME_MS);
+}
+
+void Heater::_updateAutotune(const Sample& actual_temperature, uint64_t timepoint)
+{
+    bool is_on = isOn();
+    bool should_be_on = is_on;
+
+    // A STALE sample holds the relay as it is, so the measured cycles only ever see fresh data.
+    if (actual_temperature.quality == SampleQuality::GOOD) {
+        should_be_on = _autotune.update(actual_temperature.value, timepoint);
+    }
+
+    // The cycles are timed from the relay logic, so a safety limit which would stop the relay following it ends the run
+    // instead of letting the limit's own timing pass for the container's.
+    if (is_on && timepoint - _on_timepoint > _max_on_time) {
+        _autotune.interrupt("maximum on time reached");
+    }
+    else if (!is_on && should_be_on && timepoint - _off_timepoint < MINIMUM_OFF_TIME_MS) {
+        _autotune.interrupt("minimum off time not reached");
+    }
+
+    switch (_autotune.state()) {
+    case AutotuneState::SUCCEEDED:
+        setGains(_autotune.gains());
+        setMode(HeaterMode::PID);
+        return;
+    case AutotuneState::FAILED:
+        if (is_on) {
+            _off();
+        }
+        setMode(_resume_mode);
+        return;
+    case AutotuneState::RUNNING:
+    case AutotuneState::IDLE:
+    default:
+        break;
+    }
+
+    if (is_on && !should_be_on) {
+        _off();
+    }
+    else if (!is_on && should_be_on) {
+        _on();
+    }
+}
+
+void Heater::_updateHysteresis(const Sample& actual_temperature, uint64_t timepoint)
+{
+    int32_t off_threshold = _target_temperature + _hysteresis;
+    int32_t on_threshold = _target_temperature - _hysteresis;
+    bool is_on = isOn();
+    bool is_good = actual_temperature.quality == SampleQuality::GOOD;
+
+    if (is_on && ((is_good && actual_temperature.value > off_threshold) || (timepoint - _on_timepoint > _max_on_time))) {
+        _off();
+    }
+    else if (!is_on && is_good && (actual_temperature.value < on_threshold)) {
+        _on();
+    }
+}
+
+void Heater::_updatePID(const Sample& actual_temperature, uint64_t timepoint)
+{
+    // A STALE sample holds the last duty cycle rather than feeding old data into the integral and derivative terms.
+    if (actual_temperature.quality == SampleQuality::GOOD) {
+        _pid.update(_target_temperature, actual_temperature.value, timepoint);
+    }
+
+    if (timepoint - _window_start >= _window_ms) {
+        _window_start = timepoint;
+        _window_finished = false;
+    }
+
+    // The slice follows the latest duty cycle, but once the heater has been switched off it stays off for the rest of the
+    // window, so a rising duty cannot chatter the relay.
+    bool in_slice = (timepoint - _window_start) < _onSlice(_pid.output());
+    bool is_on = isOn();
+
+    if (is_on && (!in_slice || (timepoint - _on_timepoint > _max_on_time))) {
+        _off();
+        _window_finished = true;
+    }
+    else if (!is_on && in_slice && !_window_finished) {
+        _on();
+    }
+}
+
 void Heater::_on()
 {
+    // A cut-off can land after update() handled the last one, and its off period must start before the relay can switch.
+    // The alarms only cut off a heater which is on, so once it is handled no other can land before the relay switches.
+    _handleCutoff();
+
     uint64_t current_timepoint = milliseconds();
     if (current_timepoint - _off_timepoint < MINIMUM_OFF_TIME_MS) {
         printf("Cannot enable heater, has not been off for %u milliseconds\n", MINIMUM_OFF_TIME_MS);
         return;
     }
 
+    if (!_arm()) {
+        printf("Cannot enable heater, no alarm available to enforce its cut-off\n");
+        return;
+    }
+
     printf("Turning on Heater...\n");
     _on_timepoint = current_timepoint;
     gpio_put(_control_pin, ON);
@@ -4,13 +4,65 @@ SPDX-License-Identifier: BSD-3-Clause
 ------------------------------------------------------------------------------*/
 #pragma once
 
+#include "controllers/autotune.hpp"
+#include "controllers/pid.hpp"
+#include "measurement.hpp"
+
+#include <pico/time.h>
+
 #include <cstdint>
 #include <string_view>
 
 
 namespace controllers {
+/**
+ * Enumerates the ways the Heater can be controlled.
+ */
+enum class HeaterMode : uint8_t
+{
+    /** Bang-bang control, switching at the target temperature plus or minus the hysteresis. */
+    HYSTERESIS,
+
+    /** PID control, with the output time-proportioned onto the relay over a fixed window. */
+    PID,
+
+    /** A relay auto-tune around the target temperature, which switches to PID with the derived gains when complete. */
+    AUTOTUNE
+};
+
+/**
+ * Converts @a mode to a human readable string.
+ *
+ * @param[in] mode The HeaterMode value.
+ * @return A human readable name for @a mode.
+ */
+std::string_view toString(HeaterMode mode);
+
+/**
+ * Converts a human readable string to a HeaterMode.
+ *
+ * @param[in] text The name of the mode, as returned by toString().
+ * @param[out] mode The HeaterMode named by @a text.
+ * @return True if @a text names a mode, false otherwise.
+ */
+bool fromString(std::string_view text, HeaterMode& mode);
+
 /**
  * A generic controller for a Heating element.
+ *
+ * Whatever the mode, the heater is never on for longer than the maximum on time, and once off it stays off for at least
+ * MINIMUM_OFF_TIME_MS.
+ *
+ * The heater's safety limits do not depend on the control loop making progress. Turning the heater on arms an alarm
+ * which cuts it off at the maximum on time, and a guard timer which cuts it off if update() is not called for
+ * HEATER_GUARD_TIMEOUT_MS. Both run from the control alarm pool's interrupt, so a cut-off lands within microseconds of
+ * its deadline even if the control loop is blocked. A temperature more than OVER_TEMPERATURE_MARGIN above the target,
+ * or above HEATER_CUTOFF_TEMPERATURE, turns the heater off as soon as it is passed to update(), whatever the mode. That
+ * check stays in update() because it needs a new reading, and readings only arrive through update(); an alarm would only
+ * see the last one again. If update() stops, the guard timer cuts the heater off instead, so it never heats on a reading
+ * older than HEATER_GUARD_TIMEOUT_MS.
+ *
+ * @note The alarms refer back to the heater, so it cannot be copied, and must outlive any time it is on.
  */
 class Heater
 {
@@ -26,10 +78,14 @@ public:
      *
      * @param[in] control_pin The pin assigned to the Heater Relay.
      * @param[in] feedback_pin The pin assigned to the Heater Feedback LED.
-     * @param[in] hysteresis The hysteresis in degrees Celsius.
+     * @param[in] hysteresis The hysteresis in hundredths of a degree Celsius.
      * @param[in] max_on_time The maximum amount of time the heater can be on in milliseconds.
      */
-    Heater(uint8_t control_pin, uint8_t feedback_pin, float hysteresis, uint64_t max_on_time);
+    Heater(uint8_t control_pin, uint8_t feedback_pin, Centidegrees hysteresis, uint64_t max_on_time);
+
+    Heater(const Heater&) = delete;
+
+    Heater& operator=(const Heater&) = delete;
 
     /**
      * @return True if the heater is on, false otherwise.
@@ -37,41 +93,198 @@ public:
     bool isOn() const;
 
     /**
-     * @return The current target temperature in degrees Celsius.
+     * @return The control mode.
+     */
+    HeaterMode mode() const;
+
+    /**
+     * @return The state of the most recent auto-tune.
+     */
+    AutotuneState autotuneState() const;
+
+    /**
+     * @note Only valid once autotuneState() is AutotuneState::SUCCEEDED.
+     * @return The gains derived by the most recent auto-tune, whatever gains have been set since.
+     */
+    const PIDGains& autotuneGains() const;
+
+    /**
+     * @return The PID controller gains.
+     */
+    const PIDGains& gains() const;
+
+    /**
+     * @return The duty cycle requested by the PID controller in hundredths of a percent, or 0 in HeaterMode::HYSTERESIS.
+     */
+    Centipercent duty() const;
+
+    /**
+     * @return The length of the time-proportioning window in milliseconds.
+     */
+    uint32_t window() const;
+
+    /**
+     * Sets the control mode. Switching to HeaterMode::PID starts a fresh window with a reset controller. Switching to
+     * HeaterMode::AUTOTUNE starts an auto-tune, after which the heater returns to the previous mode if it fails.
+     *
+     * @param[in] mode The desired control mode.
+     */
+    void setMode(HeaterMode mode);
+
+    /**
+     * Sets the PID controller gains, resetting the controller.
+     *
+     * @param[in] gains The desired gains.
+     */
+    void setGains(const PIDGains& gains);
+
+    /**
+     * Sets the length of the time-proportioning window.
+     *
+     * @param[in] window_ms The desired window in milliseconds, at least MINIMUM_PID_WINDOW_MS.
+     */
+    void setWindow(uint32_t window_ms);
+
+    /**
+     * @return The current target temperature in hundredths of a degree Celsius.
      */
-    float targetTemperature() const;
+    Centidegrees targetTemperature() const;
 
     /**
      * Sets the target temperature for the heater.
      *
-     * @param[in] target_temperature The desired target temperature in degrees Celsius.
+     * @param[in] target_temperature The desired target temperature in hundredths of a degree Celsius.
      */
-    void setTargetTemperature(float target_temperature);
+    void setTargetTemperature(Centidegrees target_temperature);
 
     /**
      * Updates the Heater's control based on the provided temperature.
      *
-     * @param[in] actual_temperature The actual temperature of the environment in degrees Celsius.
+     * Only GOOD samples are used to switch the heater on or off. A STALE sample leaves the heater as it is (subject to the
+     * maximum on time), and an INVALID sample turns the heater off, since there is no longer any way to know how hot the
+     * container is.
+     *
+     * @param[in] actual_temperature The filtered temperature of the environment in hundredths of a degree Celsius.
      */
-    void update(float actual_temperature);
+    void update(const Sample& actual_temperature);
 
 private:
+    /**
+     * Enumerates the reasons the heater can be cut off from interrupt context.
+     */
+    enum class Cutoff : uint8_t
+    {
+        NONE,
+        MAX_ON_TIME,
+        STALLED
+    };
+
+    /**
+     * Handler for the alarm which enforces the maximum on time.
+     *
+     * @param[in] id The alarm ID.
+     * @param[in] user_data The heater.
+     * @return 0, so the alarm does not fire again.
+     */
+    static int64_t _onMaxOnTime(alarm_id_t id, void* user_data);
+
+    /**
+     * Handler for the guard timer, which cuts the heater off if update() stops being called.
+     *
+     * @param[in] timer The guard timer, whose user data is the heater.
+     * @return True to keep the guard running, false once the heater is off.
+     */
+    static bool _onGuard(repeating_timer_t* timer);
+
+    /**
+     * Arms the maximum on time alarm and the guard timer.
+     *
+     * @return True if both were armed, false otherwise.
+     */
+    bool _arm();
+
+    /**
+     * Cancels the maximum on time alarm and the guard timer.
+     */
+    void _disarm();
+
+    /**
+     * Switches the relay off immediately.
+     *
+     * @note This is called from interrupt context.
+     * @param[in] reason The reason for the cut-off.
+     */
+    void _cutOff(Cutoff reason);
+
+    /**
+     * Completes a cut-off made from interrupt context, logging it and starting the minimum off time.
+     */
+    void _handleCutoff();
+
     /**
      * Turn the Heater off.
      */
     void _off();
 
     /**
-     * Turn the Heater on.
+     * Calculates how long the heater should be on in each window for @a duty.
+     *
+     * Slices too short to be worth switching the relay are dropped, and slices which would leave less than
+     * MINIMUM_OFF_TIME_MS of the window are shortened, unless the heater is to stay on for the whole window.
+     *
+     * @param[in] duty The duty cycle in hundredths of a percent.
+     * @return The time the heater should be on at the start of each window in milliseconds.
+     */
+    uint64_t _onSlice(Centipercent duty) const;
+
+    /**
+     * Updates the Heater in HeaterMode::AUTOTUNE.
+     *
+     * @param[in] actual_temperature The filtered temperature of the environment.
+     * @param[in] timepoint The current time in milliseconds since boot.
+     */
+    void _updateAutotune(const Sample& actual_temperature, uint64_t timepoint);
+
+    /**
+     * Updates the Heater in HeaterMode::HYSTERESIS.
+     *
+     * @param[in] actual_temperature The filtered temperature of the environment.
+     * @param[in] timepoint The current time in milliseconds since boot.
+     */
+    void _updateHysteresis(const Sample& actual_temperature, uint64_t timepoint);
+
+    /**
+     * Updates the Heater in HeaterMode::PID.
+     *
+     * @param[in] actual_temperature The filtered temperature of the environment.
+     * @param[in] timepoint The current time in milliseconds since boot.
+     */
+    void _updatePID(const Sample& actual_temperature, uint64_t timepoint);
+
+    /**
+     * Turn the Heater on, unless it has not been off for MINIMUM_OFF_TIME_MS, including after a cut-off which has not been
+     * handled yet.
      */
     void _on();
 
     const uint64_t _max_on_time;
     uint8_t _feedback_pin;
     uint8_t _control_pin;
-    float _hysteresis;
-    float _target_temperature;
+    Centidegrees _hysteresis;
+    Centidegrees _target_temperature;
     uint64_t _on_timepoint;
     uint64_t _off_timepoint;
+    HeaterMode _mode;
+    HeaterMode _resume_mode;
+    PID _pid;
+    RelayAutotune _autotune;
+    uint32_t _window_ms;
+    uint64_t _window_start;
+    bool _window_finished;
+    volatile alarm_id_t _max_on_alarm;
+    repeating_timer_t _guard_timer;
+    volatile bool _guard_armed;
+    volatile uint32_t _update_timepoint;
+    volatile Cutoff _cutoff;
 };
 } // namespace controllers
@@ -0,0 +1,74 @@
+/*------------------------------------------------------------------------------
+Copyright (c) 2023 Joe Porembski
+SPDX-License-Identifier: BSD-3-Clause
+------------------------------------------------------------------------------*/
+#include "controllers/pid.hpp"
+
+#include <algorithm>
+#include <cstdint>
+
+
+namespace controllers {
+inline constexpr int64_t OUTPUT_MINIMUM = 0;
+inline constexpr int64_t OUTPUT_MAXIMUM = toCenti(100);
+
+/** The integral is accumulated with extra precision, so small errors over short periods are not truncated away. */
+inline constexpr int64_t INTEGRAL_SCALE = 1000;
+
+PID::PID(const PIDGains& gains) : _gains(gains), _integral(0), _last_measurement(0), _last_timepoint(0), _output(0), _primed(false)
+{}
+
+const PIDGains& PID::gains() const
+{
+    return _gains;
+}
+
+Centipercent PID::output() const
+{
+    return _output;
+}
+
+void PID::reset()
+{
+    _integral = 0;
+    _output = 0;
+    _primed = false;
+}
+
+void PID::setGains(const PIDGains& gains)
+{
+    _gains = gains;
+    reset();
+}
+
+Centipercent PID::update(Centidegrees setpoint, Centidegrees measurement, uint64_t timepoint)
+{
+    // The gain is per whole degree, while the error is in hundredths.
+    int64_t error = setpoint - measurement;
+    int64_t proportional = (_gains.proportional * error) / CENTI_PER_UNIT;
+
+    int64_t derivative = 0;
+    if (_primed && timepoint > _last_timepoint) {
+        int64_t elapsed_ms = static_cast<int64_t>(timepoint - _last_timepoint);
+        if (_gains.integral_time_ms > 0) {
+            _integral += (_gains.proportional * error * elapsed_ms * INTEGRAL_SCALE) / (CENTI_PER_UNIT * _gains.integral_time_ms);
+        }
+
+        int64_t change = measurement - _last_measurement;
+        derivative = -(_gains.proportional * change * static_cast<int64_t>(_gains.derivative_time_ms)) / (CENTI_PER_UNIT * elapsed_ms);
+    }
+
+    // Anti-windup: the integral may only take up the room the other terms leave within the output range.
+    int64_t others = proportional + derivative;
+    int64_t integral_maximum = std::max<int64_t>(OUTPUT_MAXIMUM - others, 0) * INTEGRAL_SCALE;
+    int64_t integral_minimum = std::min<int64_t>(OUTPUT_MINIMUM - others, 0) * INTEGRAL_SCALE;
+    _integral = std::clamp(_integral, integral_minimum, integral_maximum);
+
+    int64_t output = others + _integral / INTEGRAL_SCALE;
+    _output = static_cast<Centipercent>(std::clamp(output, OUTPUT_MINIMUM, OUTPUT_MAXIMUM));
+    _last_measurement = measurement;
+    _last_timepoint = timepoint;
+    _primed = true;
+    return _output;
+}
+} // namespace controllers
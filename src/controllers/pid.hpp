@@ -0,0 +1,84 @@
+/*------------------------------------------------------------------------------
+Copyright (c) 2023 Joe Porembski
+SPDX-License-Identifier: BSD-3-Clause
+------------------------------------------------------------------------------*/
+#pragma once
+
+#include "measurement.hpp"
+
+#include <cstdint>
+
+
+namespace controllers {
+/**
+ * The gains of a PID controller, in the ideal (ISA) form: u = Kp * (e + 1/Ti * integral(e) - Td * d(measurement)/dt).
+ */
+struct PIDGains
+{
+    /** Kp, the output in hundredths of a percent per degree Celsius of error. */
+    int32_t proportional;
+
+    /** Ti, the integral time in milliseconds, or 0 to disable the integral term. */
+    uint32_t integral_time_ms;
+
+    /** Td, the derivative time in milliseconds, or 0 to disable the derivative term. */
+    uint32_t derivative_time_ms;
+};
+
+/**
+ * An integer PID controller producing a duty cycle in hundredths of a percent.
+ *
+ * The derivative term acts on the measurement rather than the error, so setpoint changes do not kick the output. The
+ * integral term is clamped so that it can never push the output further into saturation (anti-windup).
+ */
+class PID
+{
+public:
+    /**
+     * Constructor.
+     *
+     * @param[in] gains The controller gains.
+     */
+    explicit PID(const PIDGains& gains);
+
+    /**
+     * @return The controller gains.
+     */
+    const PIDGains& gains() const;
+
+    /**
+     * @return The most recent output in hundredths of a percent.
+     */
+    Centipercent output() const;
+
+    /**
+     * Clears the integral and derivative history, so the next update starts fresh.
+     */
+    void reset();
+
+    /**
+     * Sets the controller gains, resetting the controller.
+     *
+     * @param[in] gains The controller gains.
+     */
+    void setGains(const PIDGains& gains);
+
+    /**
+     * Updates the controller with a new measurement.
+     *
+     * @param[in] setpoint The desired temperature in hundredths of a degree Celsius.
+     * @param[in] measurement The measured temperature in hundredths of a degree Celsius.
+     * @param[in] timepoint The time of @a measurement in milliseconds since boot.
+     * @return The output in hundredths of a percent, between 0 and 100%.
+     */
+    Centipercent update(Centidegrees setpoint, Centidegrees measurement, uint64_t timepoint);
+
+private:
+    PIDGains _gains;
+    int64_t _integral;
+    Centidegrees _last_measurement;
+    uint64_t _last_timepoint;
+    Centipercent _output;
+    bool _primed;
+};
+} // namespace controllers
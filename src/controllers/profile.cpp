@@ -0,0 +1,287 @@
+/*------------------------------------------------------------------------------
+Copyright (c) 2023 Joe Porembski
+SPDX-License-Identifier: BSD-3-Clause
+------------------------------------------------------------------------------*/
+#include "controllers/profile.hpp"
+
+#include "constants.hpp"
+
+#include <pico/stdio.h>
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstdio>
+#include <string_view>
+
+
+namespace controllers {
+inline constexpr std::string_view PROFILE_STATE_IDLE = "idle";
+inline constexpr std::string_view PROFILE_STATE_RUNNING = "running";
+inline constexpr std::string_view PROFILE_STATE_COMPLETE = "complete";
+inline constexpr std::string_view PROFILE_STATE_STOPPED = "stopped";
+inline constexpr const char* CUSTOM_PROFILE_NAME = "custom";
+inline constexpr const char* NO_PROFILE_NAME = "none";
+inline constexpr char SEGMENT_SEPARATOR = ';';
+inline constexpr char FIELD_SEPARATOR = ',';
+inline constexpr uint32_t MS_PER_MINUTE = 60 * 1000;
+inline constexpr uint32_t MS_PER_HOUR = 60 * MS_PER_MINUTE;
+
+/** Every built-in profile ends by holding the heater off while the spool cools in the dry container. */
+inline constexpr ProfileSegment COOL_DOWN = {MINIMUM_TARGET_TEMPERATURE, 0, 0, 30 * MS_PER_MINUTE};
+
+/** The built-in material profiles. These are constant, so they are kept in flash rather than copied into RAM. */
+inline constexpr std::array<Profile, 4> MATERIAL_PROFILES = {{
+    {"pla", {{{toCenti(45), toCenti(10), 15 * MS_PER_MINUTE, 4 * MS_PER_HOUR}, COOL_DOWN}}, 2},
+    {"petg", {{{toCenti(65), toCenti(10), 20 * MS_PER_MINUTE, 4 * MS_PER_HOUR}, COOL_DOWN}}, 2},
+    {"nylon",
+     {{{toCenti(50), 0, 15 * MS_PER_MINUTE, 1 * MS_PER_HOUR},
+       {toCenti(70), toCenti(5), 20 * MS_PER_MINUTE, 12 * MS_PER_HOUR},
+       COOL_DOWN}},
+     3},
+    {"tpu", {{{toCenti(50), toCenti(10), 15 * MS_PER_MINUTE, 5 * MS_PER_HOUR}, COOL_DOWN}}, 2},
+}};
+
+std::string_view toString(ProfileState state)
+{
+    switch (state) {
+    case ProfileState::RUNNING:
+        return PROFILE_STATE_RUNNING;
+    case ProfileState::COMPLETE:
+        return PROFILE_STATE_COMPLETE;
+    case ProfileState::STOPPED:
+        return PROFILE_STATE_STOPPED;
+    case ProfileState::IDLE:
+    default:
+        return PROFILE_STATE_IDLE;
+    }
+}
+
+/**
+ * Parses a segment in the form "target,ramp,soak" or "target,ramp,soak,humidity".
+ *
+ * @return True if @a text is a valid segment, false otherwise.
+ */
+static bool parseSegment(std::string_view text, ProfileSegment& segment)
+{
+    std::array<std::string_view, 4> fields;
+    size_t field_count = 0;
+    while (field_count < fields.size()) {
+        size_t separator = text.find(FIELD_SEPARATOR);
+        fields[field_count++] = text.substr(0, separator);
+        if (separator == std::string_view::npos) {
+            break;
+        }
+        text.remove_prefix(separator + 1);
+        if (field_count == fields.size()) {
+            return false;
+        }
+    }
+
+    int32_t target = 0;
+    int32_t dry_humidity = 0;
+    if (field_count < 3 || !parseCenti(fields[0], target) || target < MINIMUM_TARGET_TEMPERATURE || target > INT16_MAX) {
+        return false;
+    }
+
+    if (field_count == 4 && (!parseCenti(fields[3], dry_humidity) || dry_humidity < 0 || dry_humidity > toCenti(100))) {
+        return false;
+    }
+
+    segment.target = static_cast<Centidegrees>(target);
+    segment.dry_humidity = static_cast<Centipercent>(dry_humidity);
+    return parseSeconds(fields[1], segment.ramp_ms) && parseSeconds(fields[2], segment.soak_ms);
+}
+
+bool fromString(std::string_view text, Profile& profile)
+{
+    for (const Profile& material : MATERIAL_PROFILES) {
+        if (text == material.name) {
+            profile = material;
+            return true;
+        }
+    }
+
+    profile.name = CUSTOM_PROFILE_NAME;
+    profile.segment_count = 0;
+    while (!text.empty()) {
+        size_t separator = text.find(SEGMENT_SEPARATOR);
+        if (profile.segment_count >= profile.segments.size()
+            || !parseSegment(text.substr(0, separator), profile.segments[profile.segment_count])) {
+            return false;
+        }
+
+        profile.segment_count++;
+        text.remove_prefix(separator == std::string_view::npos ? text.size() : separator + 1);
+    }
+    return profile.segment_count > 0;
+}
+
+ProfileRunner::ProfileRunner()
+    : _profile{NO_PROFILE_NAME, {}, 0},
+      _state(ProfileState::IDLE),
+      _segment(0),
+      _changed(false),
+      _dry(false),
+      _setpoint(MINIMUM_TARGET_TEMPERATURE),
+      _ramp_start(MINIMUM_TARGET_TEMPERATURE),
+      _segment_start(0),
+      _segment_elapsed(0),
+      _dry_timepoint(0),
+      _completed_ms(0),
+      _total_ms(0)
+{}
+
+ProfileState ProfileRunner::state() const
+{
+    return _state;
+}
+
+const Profile& ProfileRunner::profile() const
+{
+    return _profile;
+}
+
+uint8_t ProfileRunner::segment() const
+{
+    return _segment;
+}
+
+Centidegrees ProfileRunner::setpoint() const
+{
+    return _setpoint;
+}
+
+Centipercent ProfileRunner::progress() const
+{
+    if (_state == ProfileState::COMPLETE || (_state == ProfileState::RUNNING && _total_ms == 0)) {
+        return toCenti(100);
+    }
+
+    if (_total_ms == 0) {
+        return 0;
+    }
+    return static_cast<Centipercent>(_elapsed() * toCenti(100) / _total_ms);
+}
+
+uint64_t ProfileRunner::remaining() const
+{
+    if (_state != ProfileState::RUNNING) {
+        return 0;
+    }
+    return _total_ms - _elapsed();
+}
+
+bool ProfileRunner::start(const Profile& profile, Centidegrees temperature, uint64_t timepoint)
+{
+    if (profile.segment_count == 0 || profile.segment_count > profile.segments.size()) {
+        printf("Cannot start a profile with %u segments\n", profile.segment_count);
+        return false;
+    }
+
+    _profile = profile;
+    _state = ProfileState::RUNNING;
+    _completed_ms = 0;
+    _total_ms = 0;
+    for (uint8_t index = 0; index < _profile.segment_count; index++) {
+        _total_ms += _duration(index);
+    }
+
+    printf("Starting %s profile (%u segments, at most %u minutes)\n",
+           _profile.name,
+           _profile.segment_count,
+           static_cast<uint32_t>(_total_ms / MS_PER_MINUTE));
+    _setpoint = temperature;
+    _beginSegment(0, timepoint);
+    return true;
+}
+
+void ProfileRunner::stop()
+{
+    if (_state == ProfileState::RUNNING) {
+        printf("Stopping %s profile in segment %u\n", _profile.name, _segment);
+        _state = ProfileState::STOPPED;
+    }
+}
+
+bool ProfileRunner::update(const Sample& temperature, const Sample& humidity, uint64_t timepoint)
+{
+    Centidegrees previous_setpoint = _setpoint;
+    while (_state == ProfileState::RUNNING) {
+        const ProfileSegment& segment = _profile.segments[_segment];
+        _segment_elapsed = timepoint - _segment_start;
+
+        if (_segment_elapsed < segment.ramp_ms) {
+            // The ramp moves in whole steps, so the heater is not handed a new target on every control cycle.
+            int32_t offset = (segment.target - _ramp_start) * static_cast<int64_t>(_segment_elapsed) / segment.ramp_ms;
+            offset -= offset % PROFILE_RAMP_STEP;
+            _setpoint = static_cast<Centidegrees>(_ramp_start + offset);
+            break;
+        }
+
+        _setpoint = segment.target;
+        bool soaked = _segment_elapsed >= static_cast<uint64_t>(segment.ramp_ms) + segment.soak_ms;
+        bool dry = _checkDry(temperature, humidity, timepoint);
+        if (!soaked && !dry) {
+            break;
+        }
+
+        printf("Finished segment %u of %s profile%s\n", _segment, _profile.name, soaked ? "" : " (dry)");
+        _completed_ms += _duration(_segment);
+        if (_segment + 1 >= _profile.segment_count) {
+            printf("Completed %s profile\n", _profile.name);
+            _state = ProfileState::COMPLETE;
+            _setpoint = MINIMUM_TARGET_TEMPERATURE;
+            break;
+        }
+
+        // A segment which ran its full time hands over at its planned end, so a late update does not stretch the profile.
+        _beginSegment(_segment + 1, std::min(timepoint, _segment_start + _duration(_segment)));
+    }
+
+    _changed = _changed || _setpoint != previous_setpoint;
+    bool changed = _changed;
+    _changed = false;
+    return changed;
+}
+
+void ProfileRunner::_beginSegment(uint8_t index, uint64_t timepoint)
+{
+    _segment = index;
+    _segment_start = timepoint;
+    _segment_elapsed = 0;
+    _ramp_start = _setpoint;
+    _changed = true;
+    _dry = false;
+}
+
+bool ProfileRunner::_checkDry(const Sample& temperature, const Sample& humidity, uint64_t timepoint)
+{
+    const ProfileSegment& segment = _profile.segments[_segment];
+    bool at_target = temperature.quality == SampleQuality::GOOD && temperature.value >= segment.target - PROFILE_TARGET_BAND;
+    bool below_humidity = humidity.quality == SampleQuality::GOOD && humidity.value <= segment.dry_humidity;
+    if (segment.dry_humidity == 0 || !at_target || !below_humidity) {
+        _dry = false;
+        return false;
+    }
+
+    if (!_dry) {
+        _dry = true;
+        _dry_timepoint = timepoint;
+    }
+    return timepoint - _dry_timepoint >= PROFILE_DRY_HOLD_MS;
+}
+
+uint64_t ProfileRunner::_duration(uint8_t index) const
+{
+    return static_cast<uint64_t>(_profile.segments[index].ramp_ms) + _profile.segments[index].soak_ms;
+}
+
+uint64_t ProfileRunner::_elapsed() const
+{
+    if (_state != ProfileState::RUNNING) {
+        return _completed_ms;
+    }
+    return _completed_ms + std::min(_segment_elapsed, _duration(_segment));
+}
+} // namespace controllers
@@ -0,0 +1,208 @@
+/*------------------------------------------------------------------------------
+Copyright (c) 2023 Joe Porembski
+SPDX-License-Identifier: BSD-3-Clause
+------------------------------------------------------------------------------*/
+#pragma once
+
+#include "measurement.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+
+namespace controllers {
+inline constexpr size_t MAX_PROFILE_SEGMENTS = 8;
+
+/**
+ * A single step of a drying profile: a linear ramp of the setpoint to a target, followed by a soak at that target.
+ */
+struct ProfileSegment
+{
+    /** The setpoint at the end of the ramp, held for the soak, in hundredths of a degree Celsius. */
+    Centidegrees target;
+
+    /** The soak ends early once the humidity is at or below this, in hundredths of a percent. 0 soaks for the full time. */
+    Centipercent dry_humidity;
+
+    /** The time taken to ramp the setpoint from the previous segment's target, in milliseconds. */
+    uint32_t ramp_ms;
+
+    /** The longest time to hold the target once the ramp is complete, in milliseconds. */
+    uint32_t soak_ms;
+};
+
+/**
+ * A drying profile, made up of segments which are run in order.
+ *
+ * @note This is trivially copyable, so it can be passed between cores through a queue.
+ */
+struct Profile
+{
+    /** The name of the profile. */
+    const char* name;
+
+    /** The segments of the profile, of which the first segment_count are used. */
+    std::array<ProfileSegment, MAX_PROFILE_SEGMENTS> segments;
+
+    /** The number of segments in the profile. */
+    uint8_t segment_count;
+};
+
+/**
+ * Enumerates the states of a drying profile.
+ */
+enum class ProfileState : uint8_t
+{
+    /** No profile has been run. */
+    IDLE,
+
+    /** A profile is stepping through its segments. */
+    RUNNING,
+
+    /** The profile ran through all of its segments. */
+    COMPLETE,
+
+    /** The profile was stopped before it completed. */
+    STOPPED
+};
+
+/**
+ * Converts @a state to a human readable string.
+ *
+ * @param[in] state The ProfileState value.
+ * @return A human readable name for @a state.
+ */
+std::string_view toString(ProfileState state);
+
+/**
+ * Converts @a text into a drying profile.
+ *
+ * @a text is either the name of a built-in material profile ("pla", "petg", "nylon", or "tpu"), or a custom profile of
+ * up to MAX_PROFILE_SEGMENTS segments separated by ';'. Each segment is "target,ramp,soak" or
+ * "target,ramp,soak,humidity", with the target in degrees Celsius, the ramp and soak in seconds, and the humidity in
+ * percent, e.g. "50,900,3600;70,1200,43200,5".
+ *
+ * @param[in] text The text to convert.
+ * @param[out] profile The drying profile.
+ * @return True if @a text names a built-in profile or is a valid custom profile, false otherwise.
+ */
+bool fromString(std::string_view text, Profile& profile);
+
+/**
+ * Steps through the segments of a drying profile, providing the setpoint for the heater.
+ *
+ * Each segment ramps the setpoint linearly from the previous segment's target (or the starting temperature, for the
+ * first segment), then holds it for the soak. A segment with a dry humidity ends its soak early once the humidity has
+ * stayed at or below it, with the container at the target, for PROFILE_DRY_HOLD_MS. Heating alone lowers the relative
+ * humidity, so both conditions are needed to tell dry filament from warm air. Once the last segment ends, the setpoint
+ * drops to the minimum target temperature, leaving the heater off.
+ *
+ * Progress and the remaining time assume every soak runs for its full time, so the remaining time is an upper bound.
+ */
+class ProfileRunner
+{
+public:
+    /** Constructor. */
+    ProfileRunner();
+
+    /**
+     * @return The state of the profile.
+     */
+    ProfileState state() const;
+
+    /**
+     * @return The profile being run, or last run; before any has run, an empty profile named "none".
+     */
+    const Profile& profile() const;
+
+    /**
+     * @return The index of the segment being run.
+     */
+    uint8_t segment() const;
+
+    /**
+     * @return The setpoint in hundredths of a degree Celsius.
+     */
+    Centidegrees setpoint() const;
+
+    /**
+     * @return The share of the profile's planned time which has elapsed, in hundredths of a percent.
+     */
+    Centipercent progress() const;
+
+    /**
+     * @return The longest time until the profile completes, in milliseconds.
+     */
+    uint64_t remaining() const;
+
+    /**
+     * Starts running a profile.
+     *
+     * @param[in] profile The profile to run.
+     * @param[in] temperature The temperature the first segment ramps from, in hundredths of a degree Celsius.
+     * @param[in] timepoint The current time in milliseconds since boot.
+     * @return True if the profile was started, false if it has no segments.
+     */
+    bool start(const Profile& profile, Centidegrees temperature, uint64_t timepoint);
+
+    /**
+     * Stops a running profile, leaving the setpoint where it is.
+     */
+    void stop();
+
+    /**
+     * Advances the profile.
+     *
+     * @param[in] temperature The latest temperature sample.
+     * @param[in] humidity The latest humidity sample.
+     * @param[in] timepoint The current time in milliseconds since boot.
+     * @return True if the setpoint has changed since the last update, false otherwise.
+     */
+    bool update(const Sample& temperature, const Sample& humidity, uint64_t timepoint);
+
+private:
+    /**
+     * Starts a segment, ramping from the current setpoint.
+     *
+     * @param[in] index The index of the segment.
+     * @param[in] timepoint The time the segment starts in milliseconds since boot.
+     */
+    void _beginSegment(uint8_t index, uint64_t timepoint);
+
+    /**
+     * Tracks how long the container has been dry during the soak of the current segment.
+     *
+     * @param[in] temperature The latest temperature sample.
+     * @param[in] humidity The latest humidity sample.
+     * @param[in] timepoint The current time in milliseconds since boot.
+     * @return True if the container has been dry for long enough to end the soak, false otherwise.
+     */
+    bool _checkDry(const Sample& temperature, const Sample& humidity, uint64_t timepoint);
+
+    /**
+     * @param[in] index The index of the segment.
+     * @return The planned duration of the segment in milliseconds.
+     */
+    uint64_t _duration(uint8_t index) const;
+
+    /**
+     * @return The planned time elapsed in the profile in milliseconds.
+     */
+    uint64_t _elapsed() const;
+
+    Profile _profile;
+    ProfileState _state;
+    uint8_t _segment;
+    bool _changed;
+    bool _dry;
+    Centidegrees _setpoint;
+    Centidegrees _ramp_start;
+    uint64_t _segment_start;
+    uint64_t _segment_elapsed;
+    uint64_t _dry_timepoint;
+    uint64_t _completed_ms;
+    uint64_t _total_ms;
+};
+} // namespace controllers
@@ -0,0 +1,79 @@
+/*------------------------------------------------------------------------------
+Copyright (c) 2023 Joe Porembski
+SPDX-License-Identifier: BSD-3-Clause
+------------------------------------------------------------------------------*/
+#include "history.hpp"
+
+#include <atomic>
+#include <cstdint>
+
+
+HistoryRing::HistoryRing()
+    : _end(0),
+      _start(0),
+      _dropped(0),
+      _records()
+{
+}
+
+void HistoryRing::push(const HistoryRecord& record)
+{
+    uint32_t end = _end.load(std::memory_order_relaxed);
+    _records[end % CAPACITY] = record;
+    _end.store(end + 1, std::memory_order_release);
+}
+
+uint32_t HistoryRing::end() const
+{
+    return _end.load(std::memory_order_acquire);
+}
+
+uint32_t HistoryRing::dropped() const
+{
+    return _dropped;
+}
+
+uint32_t HistoryRing::peek(uint32_t end, HistoryRecord* records, uint32_t count)
+{
+    while (true) {
+        _discardOverwritten(_end.load(std::memory_order_acquire));
+        uint32_t available = pending(end);
+        uint32_t copied = 0;
+        for (; copied < count && copied < available; copied++) {
+            records[copied] = _records[(_start + copied) % CAPACITY];
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+
+        // The slot at the write position may be mid-write, so every copied record must be older than it to be whole.
+        if (_end.load(std::memory_order_relaxed) - _start < CAPACITY) {
+            return copied;
+        }
+    }
+}
+
+void HistoryRing::pop(uint32_t count)
+{
+    _start += count;
+}
+
+void HistoryRing::skip(uint32_t end)
+{
+    _discardOverwritten(end);
+    _start += pending(end);
+}
+
+uint32_t HistoryRing::pending(uint32_t end) const
+{
+    // Records before @a end may already have been dropped, leaving the read position beyond it.
+    uint32_t count = end - _start;
+    return count <= CAPACITY ? count : 0;
+}
+
+void HistoryRing::_discardOverwritten(uint32_t end)
+{
+    if (end - _start >= CAPACITY) {
+        uint32_t start = end - CAPACITY + 1;
+        _dropped += start - _start;
+        _start = start;
+    }
+}
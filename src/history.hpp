@@ -0,0 +1,129 @@
+/*------------------------------------------------------------------------------
+Copyright (c) 2023 Joe Porembski
+SPDX-License-Identifier: BSD-3-Clause
+------------------------------------------------------------------------------*/
+#pragma once
+
+#include "measurement.hpp"
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+
+/**
+ * A single timestamped entry in the telemetry history.
+ */
+struct HistoryRecord
+{
+    /** Set in HistoryRecord::flags when the heater was on. */
+    static constexpr uint8_t HEATER_ON = 1 << 0;
+
+    /** Set in HistoryRecord::flags when @a temperature came from a good reading. */
+    static constexpr uint8_t TEMPERATURE_GOOD = 1 << 1;
+
+    /** Set in HistoryRecord::flags when @a humidity came from a good reading. */
+    static constexpr uint8_t HUMIDITY_GOOD = 1 << 2;
+
+    /** The time of the record in milliseconds since boot. */
+    uint32_t timepoint;
+
+    /** The container temperature in hundredths of a degree Celsius. */
+    Centidegrees temperature;
+
+    /** The container humidity in hundredths of a percent. */
+    Centipercent humidity;
+
+    /** The target temperature in hundredths of a degree Celsius. */
+    Centidegrees target_temperature;
+
+    /** A combination of the HEATER_ON, TEMPERATURE_GOOD, and HUMIDITY_GOOD flags. */
+    uint8_t flags;
+};
+
+/**
+ * A statically sized ring of HistoryRecord, written by the control loop and drained by the network loop.
+ *
+ * The writer never waits: once the ring is full, each new record overwrites the oldest. The reader copies records out
+ * before consuming them, so a record is only removed once it has been sent, and any records the writer overwrote while
+ * they were being copied are detected and counted as dropped.
+ *
+ * Records are identified by their position, the number of records written before them, which only ever increases.
+ *
+ * @note There must be a single writer and a single reader.
+ */
+class HistoryRing
+{
+public:
+    /** The number of records held, so the time covered is this multiplied by the period between records. */
+    static constexpr uint32_t CAPACITY = 2048;
+
+    HistoryRing();
+
+    HistoryRing(const HistoryRing&) = delete;
+
+    HistoryRing& operator=(const HistoryRing&) = delete;
+
+    /**
+     * Adds a record, overwriting the oldest if the ring is full. This never waits.
+     *
+     * @note This must only be called by the writer.
+     * @param[in] record The record to add.
+     */
+    void push(const HistoryRecord& record);
+
+    /**
+     * @return The position after the newest record, i.e. the number of records ever written.
+     */
+    uint32_t end() const;
+
+    /**
+     * @return The number of records overwritten before they could be read.
+     */
+    uint32_t dropped() const;
+
+    /**
+     * Copies the oldest unread records before @a end, without consuming them.
+     *
+     * @note This must only be called by the reader.
+     * @param[in] end The position to stop at, as returned by end().
+     * @param[out] records The records, oldest first.
+     * @param[in] count The largest number of records to copy.
+     * @return The number of records copied.
+     */
+    uint32_t peek(uint32_t end, HistoryRecord* records, uint32_t count);
+
+    /**
+     * Consumes the oldest @a count unread records, which must have been returned by the last call to peek().
+     *
+     * @note This must only be called by the reader.
+     * @param[in] count The number of records to consume.
+     */
+    void pop(uint32_t count);
+
+    /**
+     * Consumes every unread record before @a end, without reading it.
+     *
+     * @note This must only be called by the reader.
+     * @param[in] end The position to skip to, as returned by end().
+     */
+    void skip(uint32_t end);
+
+    /**
+     * @return The number of unread records before @a end.
+     */
+    uint32_t pending(uint32_t end) const;
+
+private:
+    /**
+     * Moves the read position past any records the writer has overwritten, counting them as dropped.
+     *
+     * @param[in] end The current write position.
+     */
+    void _discardOverwritten(uint32_t end);
+
+    std::atomic<uint32_t> _end;
+    uint32_t _start;
+    uint32_t _dropped;
+    std::array<HistoryRecord, CAPACITY> _records;
+};
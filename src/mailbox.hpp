@@ -0,0 +1,102 @@
+/*------------------------------------------------------------------------------
+Copyright (c) 2023 Joe Porembski
+SPDX-License-Identifier: BSD-3-Clause
+------------------------------------------------------------------------------*/
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+
+/**
+ * Holds the latest value written by one core for another core to read, without either side ever waiting on the other.
+ *
+ * Values are written alternately into two slots, each guarded by its own sequence number: odd while the slot is being
+ * written, and twice the write number once it is complete. A reader copies the slot holding the latest complete write,
+ * then checks its sequence number did not change during the copy. The writer never waits, and a reader only retries if
+ * the writer lapped it, writing twice during a single copy, after which the other slot is complete.
+ *
+ * Only plain atomic loads and stores are used, since the RP2040's cores have no atomic read-modify-write instructions.
+ *
+ * @note There must be a single writer, but there may be any number of readers.
+ * @tparam T The type of value, which must be trivially copyable.
+ */
+template <typename T>
+class Mailbox
+{
+    static_assert(std::is_trivially_copyable_v<T>, "Mailbox values are copied byte by byte");
+
+public:
+    Mailbox()
+        : _latest(0),
+          _sequences(),
+          _slots()
+    {
+    }
+
+    Mailbox(const Mailbox&) = delete;
+
+    Mailbox& operator=(const Mailbox&) = delete;
+
+    /**
+     * @return The number of values written, which changes whenever a new value is available.
+     */
+    uint32_t version() const
+    {
+        return _latest.load(std::memory_order_acquire);
+    }
+
+    /**
+     * Replaces the latest value. This never waits.
+     *
+     * @note This must only be called by the single writer.
+     * @param[in] value The new value.
+     */
+    void write(const T& value)
+    {
+        uint32_t version = _latest.load(std::memory_order_relaxed) + 1;
+        uint8_t slot = version & 1;
+
+        _sequences[slot].store(version * 2 - 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        std::memcpy(&_slots[slot], &value, sizeof(T));
+        _sequences[slot].store(version * 2, std::memory_order_release);
+        _latest.store(version, std::memory_order_release);
+    }
+
+    /**
+     * Copies the latest value.
+     *
+     * @param[out] value The latest value, unchanged if no value has been written.
+     * @return The version of @a value, as returned by version(), or 0 if no value has been written.
+     */
+    uint32_t read(T& value) const
+    {
+        while (true) {
+            uint32_t version = _latest.load(std::memory_order_acquire);
+            if (version == 0) {
+                return 0;
+            }
+
+            uint8_t slot = version & 1;
+            uint32_t sequence = _sequences[slot].load(std::memory_order_acquire);
+            T copy;
+            std::memcpy(&copy, &_slots[slot], sizeof(T));
+            std::atomic_thread_fence(std::memory_order_acquire);
+
+            // An odd or changed sequence number means the writer reused the slot during the copy.
+            if ((sequence & 1) == 0 && sequence == _sequences[slot].load(std::memory_order_relaxed)) {
+                value = copy;
+                return sequence / 2;
+            }
+        }
+    }
+
+private:
+    std::atomic<uint32_t> _latest;
+    std::array<std::atomic<uint32_t>, 2> _sequences;
+    std::array<T, 2> _slots;
+};
@@ -2,120 +2,959 @@
 Copyright (c) 2023 Joe Porembski
 SPDX-License-Identifier: BSD-3-Clause
 ------------------------------------------------------------------------------*/
+#include "cbor.hpp"
 #include "connectivity/mqtt.hpp"
+#include "connectivity/mqtt/topic-table.hpp"
 #include "connectivity/wireless.hpp"
 #include "controllers/heater.hpp"
+#include "controllers/profile.hpp"
 #include "generated/configuration.hpp"
+#include "history.hpp"
+#include "mailbox.hpp"
+#include "measurement.hpp"
+#include "report-filter.hpp"
+#include "scheduler.hpp"
+#include "sensors/bme280.hpp"
 #include "sensors/board.hpp"
 #include "sensors/constants.hpp"
+#include "sensors/dht-array.hpp"
 #include "sensors/dht.hpp"
+#include "sensors/environment-sensor.hpp"
+#include "sensors/filter.hpp"
+#include "sensors/i2c-sensor.hpp"
+#include "sensors/sht3x.hpp"
+#include "supervisor.hpp"
+#include "text-buffer.hpp"
 #include "utilities.hpp"
 
 #include <hardware/adc.h>
+#include <hardware/clocks.h>
 #include <hardware/gpio.h>
+#include <pico/async_context.h>
+#include <pico/cyw43_arch.h>
 #include <pico/multicore.h>
 #include <pico/stdio.h>
+#include <pico/stdio_usb.h>
 #include <pico/stdlib.h>
 #include <pico/unique_id.h>
 #include <pico/util/queue.h>
 
-#include <cerrno>
+#include <algorithm>
+#include <array>
+#include <atomic>
 #include <cstdint>
 #include <cstdio>
 #include <functional>
+#include <string>
 #include <string_view>
+#include <utility>
+#include <vector>
 
 
-inline constexpr float HEATER_HYSTERESIS = 2.5f;
+inline constexpr Centidegrees HEATER_HYSTERESIS = 250;
+inline constexpr Centidegrees IDLE_TARGET_TEMPERATURE = 0;
 inline constexpr uint64_t HEATER_MAX_ON_TIME_MS = 10 * 60 * 1000;
-inline constexpr uint32_t DATA_PERIOD_MS = 10000;
+/**
+ * The control loop runs at the longest minimum read period of its sensors, but at least this: 2 s with a DHT21/22, and
+ * 1 s with the others. The sample filters count readings, so their time constants follow the period (see SampleFilter).
+ */
+inline constexpr uint32_t MINIMUM_CONTROL_PERIOD_MS = 1000;
+inline constexpr uint32_t SENSOR_POLL_PERIOD_MS = 1;
 inline constexpr uint32_t COMMUNICATION_PERIOD_MS = 10000;
 inline constexpr uint32_t MQTT_CONNECTION_WAIT_MS = 17500;
+inline constexpr uint32_t WIFI_CONNECTION_WAIT_MS = 60000;
+inline constexpr uint32_t NETWORK_IDLE_PERIOD_MS = 5000;
 inline constexpr uint8_t QUEUE_SIZE = 5;
-inline constexpr uint8_t WIFI_NOT_CONNECTED_THRESHOLD = 6;
+inline constexpr uint32_t HISTORY_PERIOD_MS = 10000;
+inline constexpr uint32_t HISTORY_BATCH_SIZE = 20;
+inline constexpr size_t HISTORY_PAYLOAD_SIZE = 1024;
+inline constexpr size_t SHORT_PAYLOAD_SIZE = 64;
+inline constexpr size_t TELEMETRY_PAYLOAD_SIZE = 512;
+inline constexpr uint32_t REPORT_HEARTBEAT_MS = REPORT_HEARTBEAT_S * 1000;
+inline constexpr uint32_t STATUS_PERIOD_MS = STATUS_PERIOD_S * 1000;
+inline constexpr Centidegrees BOARD_TEMPERATURE_DEADBAND = 50;
+inline constexpr Centipercent BATTERY_DEADBAND = 100;
+inline constexpr Centipercent PROFILE_PROGRESS_DEADBAND = 100;
+inline constexpr int32_t PROFILE_ETA_DEADBAND_S = 60;
+inline constexpr int32_t CONTROL_JITTER_DEADBAND_US = 1000;
+inline constexpr uint32_t BENCHMARK_CONSOLE_POLL_MS = 100;
+inline constexpr uint32_t HZ_PER_MHZ = 1000000;
+
+/** The bays use the container's DHT type, or DHT22s alongside an I2C sensor. */
+inline constexpr DHTType BAY_SENSOR_TYPE = ENVIRONMENT_SENSOR == "DHT11"   ? DHTType::DHT11
+                                           : ENVIRONMENT_SENSOR == "DHT21" ? DHTType::DHT21
+                                                                           : DHTType::DHT22;
+inline constexpr size_t BAY_COUNT = DHT_BAY_PINS.size();
+inline constexpr uint8_t BAY_FEEDBACK_PIN = 254;
+
+static_assert(BAY_COUNT <= DHTArray::MAX_SENSORS, "DHT_BAY_PINS lists more bays than there are free PIO state machines");
+static_assert(TELEMETRY_FORMAT == "TOPICS" || TELEMETRY_FORMAT == "CBOR" || TELEMETRY_FORMAT == "BOTH",
+              "TELEMETRY_FORMAT must be TOPICS, CBOR, or BOTH");
 
 typedef struct
 {
-    float board_temperature;
-    float container_temperature;
-    float container_humidity;
-    float target_temperature;
+    Centidegrees board_temperature;
+    Centipercent battery_level;
+    bool battery_monitored;
+    Sample container_temperature;
+    Sample container_humidity;
+    std::array<Centidegrees, BAY_COUNT> bay_temperatures;
+    std::array<Centipercent, BAY_COUNT> bay_humidities;
+    std::array<bool, BAY_COUNT> bay_valid;
+    Centidegrees target_temperature;
     bool heater_on;
+    controllers::HeaterMode heater_mode;
+    Centipercent heater_duty;
+    controllers::AutotuneState autotune_state;
+    controllers::PIDGains autotune_gains;
+    controllers::ProfileState profile_state;
+    const char* profile_name;
+    uint8_t profile_segment;
+    Centipercent profile_progress;
+    uint64_t profile_remaining_ms;
+    PeriodStatistics control_timing;
+    uint32_t requests_handled;
+    uint32_t first_sample_ms;
+    uint32_t timepoint_ms;
 } feedback_entry;
 
+/**
+ * Enumerates the requests which can be sent to the control loop.
+ */
+enum class RequestType : uint8_t
+{
+    TARGET_TEMPERATURE,
+    HEATER_MODE,
+    PID_GAINS,
+    PID_WINDOW,
+    START_PROFILE,
+    STOP_PROFILE
+};
+
 typedef struct
 {
-    float target_temperature;
+    RequestType type;
+    union
+    {
+        Centidegrees target_temperature;
+        controllers::HeaterMode heater_mode;
+        controllers::PIDGains pid_gains;
+        uint32_t pid_window_ms;
+        controllers::Profile profile;
+    };
 } request_entry;
 
-queue_t feedback_queue;
+/**
+ * Enumerates the states of the connection to the MQTT broker.
+ */
+enum class NetworkState : uint8_t
+{
+    /** Waiting for the wireless network to connect. */
+    WIFI_CONNECTING,
+
+    /** Waiting for the MQTT broker to accept the connection. */
+    MQTT_CONNECTING,
+
+    /** Connected, subscribed, and publishing. */
+    ONLINE
+};
+
+/**
+ * Enumerates the MQTT topics, in the order of TOPICS.
+ */
+enum class Topic : uint8_t
+{
+    BOARD_TEMPERATURE,
+    BATTERY,
+    BOARD_RESET,
+    BOOT_FIRST_SAMPLE,
+    BOOT_FIRST_PUBLISH,
+    CONTROL_JITTER,
+    CONTROL_OVERRUNS,
+    REPORTS_SENT,
+    REPORTS_SUPPRESSED,
+    BAY_TEMPERATURES,
+    BAY_HUMIDITIES,
+    HUMIDITY,
+    TEMPERATURE,
+    TARGET_TEMPERATURE,
+    SET_TARGET_TEMPERATURE,
+    HEATER,
+    HEATER_MODE,
+    HEATER_DUTY,
+    AUTOTUNE,
+    AUTOTUNE_RESULT,
+    SET_HEATER_MODE,
+    SET_PID_GAINS,
+    SET_PID_WINDOW,
+    HISTORY,
+    SENSOR_QUALITY,
+    PROFILE,
+    PROFILE_STATE,
+    PROFILE_SEGMENT,
+    PROFILE_PROGRESS,
+    PROFILE_ETA,
+    SET_PROFILE,
+    TELEMETRY,
+    COUNT
+};
+
+/** Measurements are republished at least with every heartbeat, so one which is lost is soon replaced. */
+inline constexpr mqtt::PublishPolicy MEASUREMENT_POLICY = {mqtt::QoS::AT_MOST_ONCE, true};
+
+/** State only changes with a command or a step of the controller, so every change is delivered. */
+inline constexpr mqtt::PublishPolicy STATE_POLICY = {mqtt::QoS::AT_LEAST_ONCE, true};
+
+/** History is only sent once, and is not a latest value to keep for new subscribers. */
+inline constexpr mqtt::PublishPolicy HISTORY_POLICY = {mqtt::QoS::AT_LEAST_ONCE, false};
+
+/** The single telemetry message carries the state as well as the measurements. */
+inline constexpr mqtt::PublishPolicy TELEMETRY_POLICY = {mqtt::QoS::AT_LEAST_ONCE, true};
+
+/** Commands are subscribed to rather than published; the QoS is the largest the broker forwards them at. */
+inline constexpr mqtt::PublishPolicy COMMAND_POLICY = {mqtt::QoS::AT_LEAST_ONCE, false};
+
+inline constexpr std::array<mqtt::TopicDefinition, static_cast<size_t>(Topic::COUNT)> TOPICS = {{
+    {BOARD_TEMPERATURE_TOPIC_FORMAT, MEASUREMENT_POLICY},
+    {BATTERY_TOPIC_FORMAT, MEASUREMENT_POLICY},
+    {BOARD_RESET_TOPIC_FORMAT, STATE_POLICY},
+    {BOOT_FIRST_SAMPLE_TOPIC_FORMAT, STATE_POLICY},
+    {BOOT_FIRST_PUBLISH_TOPIC_FORMAT, STATE_POLICY},
+    {CONTROL_JITTER_TOPIC_FORMAT, MEASUREMENT_POLICY},
+    {CONTROL_OVERRUNS_TOPIC_FORMAT, MEASUREMENT_POLICY},
+    {REPORTS_SENT_TOPIC_FORMAT, MEASUREMENT_POLICY},
+    {REPORTS_SUPPRESSED_TOPIC_FORMAT, MEASUREMENT_POLICY},
+    {BAY_TEMPERATURES_TOPIC_FORMAT, MEASUREMENT_POLICY},
+    {BAY_HUMIDITIES_TOPIC_FORMAT, MEASUREMENT_POLICY},
+    {HUMIDITY_TOPIC_FORMAT, MEASUREMENT_POLICY},
+    {TEMPERATURE_TOPIC_FORMAT, MEASUREMENT_POLICY},
+    {TARGET_TEMPERATURE_TOPIC_FORMAT, STATE_POLICY},
+    {SET_TARGET_TEMPERATURE_TOPIC_FORMAT, COMMAND_POLICY},
+    {HEATER_TOPIC_FORMAT, STATE_POLICY},
+    {HEATER_MODE_TOPIC_FORMAT, STATE_POLICY},
+    {HEATER_DUTY_TOPIC_FORMAT, MEASUREMENT_POLICY},
+    {AUTOTUNE_TOPIC_FORMAT, STATE_POLICY},
+    {AUTOTUNE_RESULT_TOPIC_FORMAT, STATE_POLICY},
+    {SET_HEATER_MODE_TOPIC_FORMAT, COMMAND_POLICY},
+    {SET_PID_GAINS_TOPIC_FORMAT, COMMAND_POLICY},
+    {SET_PID_WINDOW_TOPIC_FORMAT, COMMAND_POLICY},
+    {HISTORY_TOPIC_FORMAT, HISTORY_POLICY},
+    {SENSOR_QUALITY_TOPIC_FORMAT, MEASUREMENT_POLICY},
+    {PROFILE_TOPIC_FORMAT, STATE_POLICY},
+    {PROFILE_STATE_TOPIC_FORMAT, STATE_POLICY},
+    {PROFILE_SEGMENT_TOPIC_FORMAT, STATE_POLICY},
+    {PROFILE_PROGRESS_TOPIC_FORMAT, MEASUREMENT_POLICY},
+    {PROFILE_ETA_TOPIC_FORMAT, MEASUREMENT_POLICY},
+    {SET_PROFILE_TOPIC_FORMAT, COMMAND_POLICY},
+    {TELEMETRY_TOPIC_FORMAT, TELEMETRY_POLICY},
+}};
+
+/**
+ * Enumerates the fields of the telemetry message, in the order of TELEMETRY_KEYS.
+ */
+enum class TelemetryField : uint8_t
+{
+    SEQUENCE,
+    TIMESTAMP,
+    BOARD_TEMPERATURE,
+    BATTERY,
+    TEMPERATURE,
+    HUMIDITY,
+    SENSOR_QUALITY,
+    TARGET_TEMPERATURE,
+    BAY_TEMPERATURES,
+    BAY_HUMIDITIES,
+    HEATER,
+    HEATER_MODE,
+    HEATER_DUTY,
+    AUTOTUNE,
+    AUTOTUNE_RESULT,
+    PROFILE,
+    PROFILE_STATE,
+    PROFILE_SEGMENT,
+    PROFILE_PROGRESS,
+    PROFILE_ETA,
+    CONTROL_JITTER,
+    CONTROL_OVERRUNS,
+    COUNT
+};
+
+inline constexpr std::array<std::string_view, static_cast<size_t>(TelemetryField::COUNT)> TELEMETRY_KEYS = {{
+    "sequence",
+    "timestamp",
+    "board_temperature",
+    "battery",
+    "temperature",
+    "humidity",
+    "sensor_quality",
+    "target_temperature",
+    "bay_temperatures",
+    "bay_humidities",
+    "heater",
+    "heater_mode",
+    "heater_duty",
+    "autotune",
+    "autotune_result",
+    "profile",
+    "profile_state",
+    "profile_segment",
+    "profile_progress",
+    "profile_eta",
+    "control_jitter",
+    "control_overruns",
+}};
+static_assert(!TELEMETRY_KEYS.back().empty(), "TELEMETRY_KEYS is missing the key of a TelemetryField");
+
+/**
+ * The state of the network side, which runs as workers on the wireless driver's async context.
+ */
+typedef struct
+{
+    WifiConnection* wifi;
+    mqtt::Client* client;
+    const std::string* board_id;
+    NetworkState state;
+    absolute_time_t attempt_deadline;
+    absolute_time_t publish_time;
+    absolute_time_t status_time;
+    uint32_t published_version;
+    uint32_t published_requests;
+    uint32_t history_backlog_end;
+    uint32_t count;
+    uint32_t first_publish_ms;
+    bool boot_metrics_published;
+    std::array<ReportFilter, static_cast<size_t>(Topic::COUNT)> reports;
+} network_state;
+
+Mailbox<feedback_entry> feedback_mailbox;
+HistoryRing history;
+network_state network;
+mqtt::TopicTable topics;
+std::atomic<async_context_t*> network_context(nullptr);
+async_when_pending_worker_t network_event_worker;
+async_at_time_worker_t network_timer_worker;
 queue_t request_queue;
 
+/**
+ * @return The sensor selected by the ENVIRONMENT_SENSOR build option.
+ */
+static sensors::EnvironmentSensor& environmentSensor()
+{
+    if constexpr (ENVIRONMENT_SENSOR == "SHT3X") {
+        static sensors::I2CSensor<sensors::SHT3x> sensor(SENSOR_I2C_SDA_PIN, SENSOR_I2C_SCL_PIN);
+        return sensor;
+    }
+    else if constexpr (ENVIRONMENT_SENSOR == "BME280") {
+        static sensors::I2CSensor<sensors::BME280> sensor(SENSOR_I2C_SDA_PIN, SENSOR_I2C_SCL_PIN);
+        return sensor;
+    }
+    else if constexpr (ENVIRONMENT_SENSOR == "DHT11") {
+        static DHTSensor<DHTType::DHT11> sensor(DHT_DATA_PIN, DHT_FEEDBACK_PIN, DHTCapture::PIO);
+        return sensor;
+    }
+    else if constexpr (ENVIRONMENT_SENSOR == "DHT21") {
+        static DHTSensor<DHTType::DHT21> sensor(DHT_DATA_PIN, DHT_FEEDBACK_PIN, DHTCapture::PIO);
+        return sensor;
+    }
+    else {
+        static DHTSensor<DHTType::DHT22> sensor(DHT_DATA_PIN, DHT_FEEDBACK_PIN, DHTCapture::PIO);
+        return sensor;
+    }
+}
+
+/**
+ * @return The sensors of the bays selected by the DHT_BAY_PINS build option.
+ */
+static DHTArray& bayArray()
+{
+    static DHTArray bays(BAY_SENSOR_TYPE, std::vector<uint8_t>(DHT_BAY_PINS.cbegin(), DHT_BAY_PINS.cend()), BAY_FEEDBACK_PIN);
+    return bays;
+}
+
+/**
+ * Applies a request received over MQTT to the heater and drying profile.
+ *
+ * @param[in] heater The heater.
+ * @param[in] profile The drying profile.
+ * @param[in] temperature The latest container temperature, which a new profile ramps from.
+ * @param[in] request The request.
+ */
+static void handleRequest(controllers::Heater& heater,
+                          controllers::ProfileRunner& profile,
+                          Centidegrees temperature,
+                          const request_entry& request)
+{
+    switch (request.type) {
+    case RequestType::TARGET_TEMPERATURE:
+        // A manual target takes over from a running profile.
+        profile.stop();
+        heater.setTargetTemperature(request.target_temperature);
+        break;
+    case RequestType::HEATER_MODE:
+        heater.setMode(request.heater_mode);
+        break;
+    case RequestType::PID_GAINS:
+        heater.setGains(request.pid_gains);
+        break;
+    case RequestType::PID_WINDOW:
+        heater.setWindow(request.pid_window_ms);
+        break;
+    case RequestType::START_PROFILE:
+        profile.start(request.profile, temperature, milliseconds());
+        break;
+    case RequestType::STOP_PROFILE:
+        profile.stop();
+        heater.setTargetTemperature(IDLE_TARGET_TEMPERATURE);
+        break;
+    default:
+        break;
+    }
+}
+
 void controlLoop()
 {
-    DHT sensor(DHTType::DHT22, DHT_DATA_PIN, DHT_FEEDBACK_PIN);
-    sensors::Board board;
+    sensors::EnvironmentSensor& sensor = environmentSensor();
+    uint32_t control_period_ms = std::max(sensor.minimumReadPeriod(), MINIMUM_CONTROL_PERIOD_MS);
+    if (BAY_COUNT > 0) {
+        control_period_ms = std::max(control_period_ms, DHTFormat<BAY_SENSOR_TYPE>::MINIMUM_READ_PERIOD_MS);
+    }
+    PeriodicSchedule schedule(control_period_ms);
+    sensors::Board board(BATTERY_ADC_PIN);
     controllers::Heater heater(HEATER_CONTROL_PIN, HEATER_FEEDBACK_PIN, HEATER_HYSTERESIS, HEATER_MAX_ON_TIME_MS);
+    sensors::SampleFilter temperature_filter(TEMPERATURE_MAX_RATE, SAMPLE_EWMA_SHIFT, SAMPLE_MAX_AGE_MS);
+    sensors::SampleFilter humidity_filter(HUMIDITY_MAX_RATE, SAMPLE_EWMA_SHIFT, SAMPLE_MAX_AGE_MS);
+    controllers::ProfileRunner profile;
+    Centidegrees last_temperature = heater.targetTemperature();
+    uint64_t history_timepoint = 0;
+    bool history_started = false;
+    uint32_t requests_handled = 0;
+    uint32_t first_sample_ms = 0;
 
+    schedule.start();
     while (true) {
-        if (!queue_is_empty(&request_queue)) {
-            request_entry request;
-            queue_remove_blocking(&request_queue, &request);
-            heater.setTargetTemperature(request.target_temperature);
+        supervisor::checkIn(supervisor::Checkpoint::SENSOR_READ);
+
+        // The sensor read runs in the background, so the rest of the cycle's work is done while it completes.
+        sensor.beginRead();
+        // The bays are read at the same time, each on its own state machine, so they do not lengthen the cycle.
+        if (BAY_COUNT > 0) {
+            bayArray().beginRead();
+        }
+
+        request_entry request;
+        while (queue_try_remove(&request_queue, &request)) {
+            handleRequest(heater, profile, last_temperature, request);
+            requests_handled++;
+        }
+
+        Centidegrees board_temperature = board.temperature();
+
+        while (!sensor.poll()) {
+            sleep_ms(SENSOR_POLL_PERIOD_MS);
+        }
+        while (BAY_COUNT > 0 && !bayArray().poll()) {
+            sleep_ms(SENSOR_POLL_PERIOD_MS);
         }
 
-        sensor.read();
-        heater.update(sensor.temperature());
+        uint64_t read_timepoint = milliseconds();
+        const Sample& temperature = temperature_filter.update(sensor.temperature(), sensor.valid(), read_timepoint);
+        const Sample& humidity = humidity_filter.update(sensor.humidity(), sensor.valid(), read_timepoint);
+        if (temperature.quality == SampleQuality::GOOD) {
+            last_temperature = temperature.value;
+            if (first_sample_ms == 0) {
+                first_sample_ms = static_cast<uint32_t>(read_timepoint);
+                printf("First good sample %ums after boot\n", first_sample_ms);
+            }
+        }
+
+        if (profile.update(temperature, humidity, read_timepoint)) {
+            heater.setTargetTemperature(profile.setpoint());
+        }
+        supervisor::checkIn(supervisor::Checkpoint::HEATER_UPDATE);
+        heater.update(temperature);
 
         feedback_entry new_data_point;
-        new_data_point.board_temperature = board.temperature();
-        new_data_point.container_humidity = sensor.humidity();
-        new_data_point.container_temperature = sensor.temperature();
+        new_data_point.board_temperature = board_temperature;
+        new_data_point.battery_level = board.batteryLevel();
+        new_data_point.battery_monitored = board.hasBattery();
+        new_data_point.container_humidity = humidity;
+        new_data_point.container_temperature = temperature;
+        for (size_t bay = 0; bay < BAY_COUNT; bay++) {
+            new_data_point.bay_temperatures[bay] = bayArray().temperature(bay);
+            new_data_point.bay_humidities[bay] = bayArray().humidity(bay);
+            new_data_point.bay_valid[bay] = bayArray().status(bay) == DHTStatus::OK;
+        }
         new_data_point.target_temperature = heater.targetTemperature();
         new_data_point.heater_on = heater.isOn();
+        new_data_point.heater_mode = heater.mode();
+        new_data_point.heater_duty = heater.duty();
+        new_data_point.autotune_state = heater.autotuneState();
+        new_data_point.autotune_gains = heater.autotuneGains();
+        new_data_point.profile_state = profile.state();
+        new_data_point.profile_name = profile.profile().name;
+        new_data_point.profile_segment = profile.segment();
+        new_data_point.profile_progress = profile.progress();
+        new_data_point.profile_remaining_ms = profile.remaining();
+        new_data_point.control_timing = schedule.statistics();
+        new_data_point.requests_handled = requests_handled;
+        new_data_point.first_sample_ms = first_sample_ms;
+        new_data_point.timepoint_ms = static_cast<uint32_t>(read_timepoint);
+
+        // Only the most recent data point is published, so it simply replaces the last one, whether or not that was read.
+        feedback_mailbox.write(new_data_point);
+        // The network may not be started yet, since the control loop starts first.
+        async_context_t* context = network_context.load();
+        if (context != nullptr) {
+            async_context_set_work_pending(context, &network_event_worker);
+        }
 
-        queue_add_blocking(&feedback_queue, &new_data_point);
-        sleep_ms(DATA_PERIOD_MS);
+        if (!history_started || read_timepoint - history_timepoint >= HISTORY_PERIOD_MS) {
+            HistoryRecord record;
+            record.timepoint = static_cast<uint32_t>(read_timepoint);
+            record.temperature = temperature.value;
+            record.humidity = humidity.value;
+            record.target_temperature = heater.targetTemperature();
+            record.flags = (heater.isOn() ? HistoryRecord::HEATER_ON : 0)
+                           | (temperature.quality == SampleQuality::GOOD ? HistoryRecord::TEMPERATURE_GOOD : 0)
+                           | (humidity.quality == SampleQuality::GOOD ? HistoryRecord::HUMIDITY_GOOD : 0);
+            history.push(record);
+            history_timepoint = read_timepoint;
+            history_started = true;
+        }
+        supervisor::checkIn(supervisor::Checkpoint::CONTROL_IDLE);
+        schedule.wait();
     }
 }
 
-feedback_entry getMostRecentData()
+/**
+ * @return The full name of @a topic for this device.
+ */
+static const char* topicName(Topic topic)
 {
-    feedback_entry data;
-    queue_remove_blocking(&feedback_queue, &data);
-    while (!queue_is_empty(&feedback_queue)) {
-        queue_remove_blocking(&feedback_queue, &data);
+    return topics[static_cast<size_t>(topic)];
+}
+
+/**
+ * @return How messages are published on @a topic.
+ */
+static mqtt::PublishPolicy topicPolicy(Topic topic)
+{
+    return topics.policy(static_cast<size_t>(topic));
+}
+
+/**
+ * Publishes @a payload on @a topic, according to the topic's policy.
+ *
+ * @param[in] client The MQTT client.
+ * @param[in] topic The topic.
+ * @param[in] payload The payload.
+ * @return True if the payload was published or queued, false otherwise.
+ */
+static bool publishTopic(mqtt::Client& client, Topic topic, std::string_view payload)
+{
+    return mqtt::publish(client, topicName(topic), payload, topicPolicy(topic));
+}
+
+/**
+ * @return The change in the value published on @a topic which is not worth publishing before the heartbeat.
+ */
+static int32_t reportDeadband(Topic topic)
+{
+    switch (topic) {
+    case Topic::BOARD_TEMPERATURE:
+        return BOARD_TEMPERATURE_DEADBAND;
+    case Topic::BATTERY:
+        return BATTERY_DEADBAND;
+    case Topic::CONTROL_JITTER:
+        return CONTROL_JITTER_DEADBAND_US;
+    case Topic::REPORTS_SENT:
+    case Topic::REPORTS_SUPPRESSED:
+        return ReportFilter::HEARTBEAT_ONLY;
+    case Topic::HUMIDITY:
+        return HUMIDITY_DEADBAND;
+    case Topic::TEMPERATURE:
+        return TEMPERATURE_DEADBAND;
+    case Topic::HEATER_DUTY:
+        return HEATER_DUTY_DEADBAND;
+    case Topic::PROFILE_PROGRESS:
+        return PROFILE_PROGRESS_DEADBAND;
+    case Topic::PROFILE_ETA:
+        return PROFILE_ETA_DEADBAND_S;
+    default:
+        return 0;
+    }
+}
+
+/**
+ * Publishes @a payload on @a topic if @a value has moved beyond the topic's deadband since it was last published, or the
+ * heartbeat interval has passed.
+ *
+ * @param[in] client The MQTT client.
+ * @param[in] topic The topic.
+ * @param[in] value The value @a payload represents, to compare with the last one published.
+ * @param[in] payload The payload.
+ * @param[in] now_ms The current time in milliseconds since boot.
+ * @return True if the payload was published or queued, false if it was not due or could not be published.
+ */
+static bool reportTopic(mqtt::Client& client, Topic topic, int32_t value, std::string_view payload, uint32_t now_ms)
+{
+    ReportFilter& filter = network.reports[static_cast<size_t>(topic)];
+    if (!filter.due(value, reportDeadband(topic), now_ms, REPORT_HEARTBEAT_MS) || !publishTopic(client, topic, payload)) {
+        return false;
     }
-    return data;
+
+    filter.reported(value, now_ms);
+    return true;
+}
+
+/**
+ * Publishes @a payload on @a topic if it differs from the payload last published there, or the heartbeat interval has
+ * passed.
+ *
+ * @return True if the payload was published or queued, false if it was not due or could not be published.
+ */
+static bool reportTopic(mqtt::Client& client, Topic topic, std::string_view payload, uint32_t now_ms)
+{
+    return reportTopic(client, topic, textKey(payload), payload, now_ms);
 }
 
 static void publish(mqtt::Client& client, const feedback_entry& data)
 {
-    std::string board_temperature = std::to_string(data.board_temperature);
-    std::string container_temperature = std::to_string(data.container_temperature);
-    std::string container_humidity = std::to_string(data.container_humidity);
-    std::string target_temperature = std::to_string(data.target_temperature);
+    // Everything here is formatted into buffers on the stack, since this runs for every publish.
+    NumberBuffer number;
+    uint32_t now_ms = to_ms_since_boot(get_absolute_time());
+    reportTopic(client, Topic::BOARD_TEMPERATURE, data.board_temperature, formatCenti(data.board_temperature, number), now_ms);
+
+    if (data.battery_monitored) {
+        reportTopic(client, Topic::BATTERY, data.battery_level, formatCenti(data.battery_level, number), now_ms);
+    }
 
-    char mqtt_topic[TOPIC_BUFFER_SIZE];
-    snprintf(mqtt_topic, TOPIC_BUFFER_SIZE, BOARD_TEMPERATURE_TOPIC_FORMAT.data(), client.deviceName().c_str());
-    mqtt::publish(client, mqtt_topic, board_temperature);
+    // Only values backed by a good reading are published, so subscribers never record held or invalid data as new data.
+    if (data.container_humidity.quality == SampleQuality::GOOD) {
+        Centipercent humidity = data.container_humidity.value;
+        reportTopic(client, Topic::HUMIDITY, humidity, formatCenti(humidity, number), now_ms);
+    }
 
-    snprintf(mqtt_topic, TOPIC_BUFFER_SIZE, HUMIDITY_TOPIC_FORMAT.data(), client.deviceName().c_str());
-    mqtt::publish(client, mqtt_topic, container_humidity);
+    if (data.container_temperature.quality == SampleQuality::GOOD) {
+        Centidegrees temperature = data.container_temperature.value;
+        reportTopic(client, Topic::TEMPERATURE, temperature, formatCenti(temperature, number), now_ms);
+    }
 
-    snprintf(mqtt_topic, TOPIC_BUFFER_SIZE, TEMPERATURE_TOPIC_FORMAT.data(), client.deviceName().c_str());
-    mqtt::publish(client, mqtt_topic, container_temperature);
+    reportTopic(client, Topic::SENSOR_QUALITY, toString(data.container_temperature.quality), now_ms);
+
+    if (BAY_COUNT > 0) {
+        // A value per bay in pin order, left empty for a bay whose read failed, so the position always names the bay.
+        TextBuffer<SHORT_PAYLOAD_SIZE> bay_temperatures;
+        TextBuffer<SHORT_PAYLOAD_SIZE> bay_humidities;
+        for (size_t bay = 0; bay < BAY_COUNT; bay++) {
+            if (bay > 0) {
+                bay_temperatures.append(",");
+                bay_humidities.append(",");
+            }
+            if (data.bay_valid[bay]) {
+                bay_temperatures.appendCenti(data.bay_temperatures[bay]);
+                bay_humidities.appendCenti(data.bay_humidities[bay]);
+            }
+        }
+        reportTopic(client, Topic::BAY_TEMPERATURES, bay_temperatures.view(), now_ms);
+        reportTopic(client, Topic::BAY_HUMIDITIES, bay_humidities.view(), now_ms);
+    }
 
-    snprintf(mqtt_topic, TOPIC_BUFFER_SIZE, HEATER_TOPIC_FORMAT.data(), client.deviceName().c_str());
     if (data.heater_on) {
-        mqtt::publish(client, mqtt_topic, controllers::Heater::STATUS_ON.data());
+        reportTopic(client, Topic::HEATER, controllers::Heater::STATUS_ON, now_ms);
     }
     else {
-        mqtt::publish(client, mqtt_topic, controllers::Heater::STATUS_OFF.data());
+        reportTopic(client, Topic::HEATER, controllers::Heater::STATUS_OFF, now_ms);
+    }
+
+    reportTopic(client, Topic::HEATER_MODE, controllers::toString(data.heater_mode), now_ms);
+
+    if (data.heater_mode == controllers::HeaterMode::PID) {
+        reportTopic(client, Topic::HEATER_DUTY, data.heater_duty, formatCenti(data.heater_duty, number), now_ms);
+    }
+
+    if (data.autotune_state != controllers::AutotuneState::IDLE) {
+        reportTopic(client, Topic::AUTOTUNE, controllers::toString(data.autotune_state), now_ms);
+    }
+
+    if (data.autotune_state == controllers::AutotuneState::SUCCEEDED) {
+        constexpr uint32_t MS_PER_CENTISECOND = 10;
+        TextBuffer<SHORT_PAYLOAD_SIZE> gains;
+        gains.appendCenti(data.autotune_gains.proportional);
+        gains.append(",");
+        gains.appendCenti(static_cast<int32_t>(data.autotune_gains.integral_time_ms / MS_PER_CENTISECOND));
+        gains.append(",");
+        gains.appendCenti(static_cast<int32_t>(data.autotune_gains.derivative_time_ms / MS_PER_CENTISECOND));
+        reportTopic(client, Topic::AUTOTUNE_RESULT, gains.view(), now_ms);
+    }
+
+    if (data.profile_state != controllers::ProfileState::IDLE) {
+        reportTopic(client, Topic::PROFILE, data.profile_name, now_ms);
+        reportTopic(client, Topic::PROFILE_STATE, controllers::toString(data.profile_state), now_ms);
+        reportTopic(client, Topic::PROFILE_PROGRESS, data.profile_progress, formatCenti(data.profile_progress, number), now_ms);
+    }
+
+    if (data.profile_state == controllers::ProfileState::RUNNING) {
+        constexpr uint64_t MS_PER_SECOND = 1000;
+        int32_t remaining_s = static_cast<int32_t>(data.profile_remaining_ms / MS_PER_SECOND);
+        reportTopic(client, Topic::PROFILE_SEGMENT, data.profile_segment, formatInteger(data.profile_segment, number), now_ms);
+        reportTopic(client, Topic::PROFILE_ETA, remaining_s, formatInteger(remaining_s, number), now_ms);
     }
 
-    snprintf(mqtt_topic, TOPIC_BUFFER_SIZE, TARGET_TEMPERATURE_TOPIC_FORMAT.data(), client.deviceName().c_str());
-    mqtt::publish(client, mqtt_topic, target_temperature);
+    reportTopic(client, Topic::TARGET_TEMPERATURE, data.target_temperature, formatCenti(data.target_temperature, number), now_ms);
+
+    if (data.control_timing.cycles > 0) {
+        TextBuffer<SHORT_PAYLOAD_SIZE> jitter;
+        jitter.appendInteger(data.control_timing.min_jitter_us);
+        jitter.append(",");
+        jitter.appendInteger(data.control_timing.mean_jitter_us);
+        jitter.append(",");
+        jitter.appendInteger(data.control_timing.max_jitter_us);
+        // The mean moves a little every cycle, so the jitter is only published when the worst case moves.
+        reportTopic(client, Topic::CONTROL_JITTER, data.control_timing.max_jitter_us, jitter.view(), now_ms);
+        int32_t overruns = static_cast<int32_t>(data.control_timing.overruns);
+        reportTopic(client, Topic::CONTROL_OVERRUNS, overruns, formatInteger(overruns, number), now_ms);
+    }
+
+    // The counters themselves change every cycle, so they only go out with the heartbeat.
+    uint32_t sent = 0;
+    uint32_t suppressed = 0;
+    for (const ReportFilter& filter : network.reports) {
+        sent += filter.sent();
+        suppressed += filter.suppressed();
+    }
+    reportTopic(client, Topic::REPORTS_SENT, static_cast<int32_t>(sent), formatInteger(sent, number), now_ms);
+    reportTopic(client, Topic::REPORTS_SUPPRESSED, static_cast<int32_t>(suppressed), formatInteger(suppressed, number), now_ms);
+}
+
+/**
+ * Encodes @a data as a single CBOR map, holding every value published on the individual topics.
+ *
+ * Every key is always present, so the layout is the same in every message; a value which is not available, such as the
+ * container temperature without a good reading, is null. Measurements are decimal fractions, so they decode exactly.
+ *
+ * @param[in] data The data to encode.
+ * @param[in] sequence The number of messages published before this one since boot.
+ * @param[out] writer The writer to encode into.
+ */
+static void encodeTelemetry(const feedback_entry& data, uint32_t sequence, CBORWriter& writer)
+{
+    constexpr uint32_t MS_PER_CENTISECOND = 10;
+    constexpr uint64_t MS_PER_SECOND = 1000;
+    bool autotuning = data.autotune_state != controllers::AutotuneState::IDLE;
+    bool profiling = data.profile_state != controllers::ProfileState::IDLE;
+    bool running = data.profile_state == controllers::ProfileState::RUNNING;
+    auto decimalOrNull = [&writer](bool available, int32_t value) {
+        if (available) {
+            writer.decimal(value);
+        }
+        else {
+            writer.null();
+        }
+    };
+    auto integerOrNull = [&writer](bool available, int64_t value) {
+        if (available) {
+            writer.integer(value);
+        }
+        else {
+            writer.null();
+        }
+    };
+    auto textOrNull = [&writer](bool available, std::string_view value) {
+        if (available) {
+            writer.text(value);
+        }
+        else {
+            writer.null();
+        }
+    };
+
+    // Every key in TELEMETRY_KEYS is written, so the map size always matches, and the switch has no default so the
+    // compiler rejects a TelemetryField without a value.
+    writer.map(TELEMETRY_KEYS.size());
+    for (size_t index = 0; index < TELEMETRY_KEYS.size(); index++) {
+        writer.text(TELEMETRY_KEYS[index]);
+        switch (static_cast<TelemetryField>(index)) {
+        case TelemetryField::SEQUENCE:
+            writer.integer(sequence);
+            break;
+        case TelemetryField::TIMESTAMP:
+            writer.integer(data.timepoint_ms);
+            break;
+        case TelemetryField::BOARD_TEMPERATURE:
+            writer.decimal(data.board_temperature);
+            break;
+        case TelemetryField::BATTERY:
+            decimalOrNull(data.battery_monitored, data.battery_level);
+            break;
+        case TelemetryField::TEMPERATURE:
+            decimalOrNull(data.container_temperature.quality == SampleQuality::GOOD, data.container_temperature.value);
+            break;
+        case TelemetryField::HUMIDITY:
+            decimalOrNull(data.container_humidity.quality == SampleQuality::GOOD, data.container_humidity.value);
+            break;
+        case TelemetryField::SENSOR_QUALITY:
+            writer.text(toString(data.container_temperature.quality));
+            break;
+        case TelemetryField::TARGET_TEMPERATURE:
+            writer.decimal(data.target_temperature);
+            break;
+        case TelemetryField::BAY_TEMPERATURES:
+            writer.array(BAY_COUNT);
+            for (size_t bay = 0; bay < BAY_COUNT; bay++) {
+                decimalOrNull(data.bay_valid[bay], data.bay_temperatures[bay]);
+            }
+            break;
+        case TelemetryField::BAY_HUMIDITIES:
+            writer.array(BAY_COUNT);
+            for (size_t bay = 0; bay < BAY_COUNT; bay++) {
+                decimalOrNull(data.bay_valid[bay], data.bay_humidities[bay]);
+            }
+            break;
+        case TelemetryField::HEATER:
+            writer.boolean(data.heater_on);
+            break;
+        case TelemetryField::HEATER_MODE:
+            writer.text(controllers::toString(data.heater_mode));
+            break;
+        case TelemetryField::HEATER_DUTY:
+            decimalOrNull(data.heater_mode == controllers::HeaterMode::PID, data.heater_duty);
+            break;
+        case TelemetryField::AUTOTUNE:
+            textOrNull(autotuning, controllers::toString(data.autotune_state));
+            break;
+        case TelemetryField::AUTOTUNE_RESULT:
+            if (data.autotune_state == controllers::AutotuneState::SUCCEEDED) {
+                writer.array(3);
+                writer.decimal(data.autotune_gains.proportional);
+                writer.decimal(static_cast<int32_t>(data.autotune_gains.integral_time_ms / MS_PER_CENTISECOND));
+                writer.decimal(static_cast<int32_t>(data.autotune_gains.derivative_time_ms / MS_PER_CENTISECOND));
+            }
+            else {
+                writer.null();
+            }
+            break;
+        case TelemetryField::PROFILE:
+            textOrNull(profiling, data.profile_name);
+            break;
+        case TelemetryField::PROFILE_STATE:
+            textOrNull(profiling, controllers::toString(data.profile_state));
+            break;
+        case TelemetryField::PROFILE_SEGMENT:
+            integerOrNull(running, data.profile_segment);
+            break;
+        case TelemetryField::PROFILE_PROGRESS:
+            decimalOrNull(profiling, data.profile_progress);
+            break;
+        case TelemetryField::PROFILE_ETA:
+            integerOrNull(running, static_cast<int64_t>(data.profile_remaining_ms / MS_PER_SECOND));
+            break;
+        case TelemetryField::CONTROL_JITTER:
+            if (data.control_timing.cycles > 0) {
+                writer.array(3);
+                writer.integer(data.control_timing.min_jitter_us);
+                writer.integer(data.control_timing.mean_jitter_us);
+                writer.integer(data.control_timing.max_jitter_us);
+            }
+            else {
+                writer.null();
+            }
+            break;
+        case TelemetryField::CONTROL_OVERRUNS:
+            writer.integer(data.control_timing.overruns);
+            break;
+        case TelemetryField::COUNT:
+            break;
+        }
+    }
+}
+
+/**
+ * Publishes @a data as a single CBOR message on the telemetry topic, in place of a message per value.
+ *
+ * @param[in] client The MQTT client.
+ * @param[in] data The data to publish.
+ * @param[in] sequence The number of messages published before this one since boot.
+ */
+static void publishTelemetry(mqtt::Client& client, const feedback_entry& data, uint32_t sequence)
+{
+    // Static rather than on the stack, since this runs on the wireless driver's context.
+    static std::array<uint8_t, TELEMETRY_PAYLOAD_SIZE> payload;
+    CBORWriter writer(payload.data(), payload.size());
+    encodeTelemetry(data, sequence, writer);
+    if (writer.overflowed()) {
+        printf("Failed to publish telemetry, it does not fit in %u bytes\n", payload.size());
+        return;
+    }
+
+    if (!client.publish(topicName(Topic::TELEMETRY), payload.data(), static_cast<uint16_t>(writer.size()), topicPolicy(Topic::TELEMETRY))) {
+        printf("Failed to publish telemetry\n");
+    }
+}
+
+/**
+ * Publishes the next batch of history recorded before @a backlog_end, which is the history the broker missed while the
+ * connection was down. Once that has all been sent, history is discarded as it is recorded, since the live topics cover it.
+ *
+ * Each record is a line of `age,temperature,humidity,target_temperature,heater`, where the age is in seconds before the
+ * publish, and the temperature or humidity is left empty if it was not backed by a good reading.
+ *
+ * @param[in] client The MQTT client.
+ * @param[in] backlog_end The history position when the connection was last established.
+ */
+static void publishHistory(mqtt::Client& client, uint32_t backlog_end)
+{
+    constexpr uint32_t MS_PER_SECOND = 1000;
+    std::array<HistoryRecord, HISTORY_BATCH_SIZE> records;
+    uint32_t count = history.peek(backlog_end, records.data(), records.size());
+    if (count == 0) {
+        history.skip(history.end());
+        return;
+    }
+
+    // A batch is too long to queue, so it waits for the next cycle rather than pushing out the latest values.
+    if (!client.ready()) {
+        return;
+    }
+
+    // Static rather than on the stack, since this runs on the wireless driver's context.
+    static TextBuffer<HISTORY_PAYLOAD_SIZE> payload;
+    payload.clear();
+    // Record times are truncated to 32 bits, so the age is taken in 32 bits too, where it survives the wrap after 49 days.
+    uint32_t now_ms = static_cast<uint32_t>(milliseconds());
+    uint32_t written = 0;
+    for (; written < count; written++) {
+        const HistoryRecord& record = records[written];
+        TextBuffer<SHORT_PAYLOAD_SIZE> line;
+        line.appendInteger((now_ms - record.timepoint) / MS_PER_SECOND);
+        line.append(",");
+        if (record.flags & HistoryRecord::TEMPERATURE_GOOD) {
+            line.appendCenti(record.temperature);
+        }
+        line.append(",");
+        if (record.flags & HistoryRecord::HUMIDITY_GOOD) {
+            line.appendCenti(record.humidity);
+        }
+        line.append(",");
+        line.appendCenti(record.target_temperature);
+        line.append(",");
+        line.append((record.flags & HistoryRecord::HEATER_ON) ? controllers::Heater::STATUS_ON : controllers::Heater::STATUS_OFF);
+        line.append("\n");
+
+        // Records which do not fit are left for the next batch.
+        if (!payload.append(line.view())) {
+            break;
+        }
+    }
+
+    std::string_view text = payload.view();
+    if (!client.publish(topicName(Topic::HISTORY), text.data(), static_cast<uint16_t>(text.size()), topicPolicy(Topic::HISTORY))) {
+        printf("Failed to publish history, %u records pending\n", history.pending(backlog_end));
+        return;
+    }
+
+    history.pop(written);
+    printf("Published %u history records, %u pending, %u dropped\n", written, history.pending(backlog_end), history.dropped());
 }
 
 static void initialize()
@@ -123,7 +962,6 @@ static void initialize()
     stdio_init_all();
     adc_init();
 
-    queue_init(&feedback_queue, sizeof(feedback_entry), QUEUE_SIZE);
     queue_init(&request_queue, sizeof(request_entry), QUEUE_SIZE);
 
     gpio_init(SYSTEM_LED_PIN);
@@ -131,107 +969,510 @@ static void initialize()
     gpio_put(SYSTEM_LED_PIN, ON);
 }
 
-static void onSetTargetTemperatureReceived(const std::string& topic, const mqtt::Buffer& data)
+/** Consumes the results of each benchmark run, so the compiler cannot discard the work that produced them. */
+static volatile uint32_t benchmark_sink;
+
+/**
+ * @return A raw DHT22 temperature, in tenths of a degree, swept across the benchmark target as @a i increases.
+ */
+static int16_t benchmarkReading(uint32_t i)
+{
+    return static_cast<int16_t>(400 + (i % 200));
+}
+
+/**
+ * Takes @a iterations readings through the fixed point path: scaled, compared with a target, and formatted.
+ *
+ * @return A value derived from the results, so the compiler cannot discard the work.
+ */
+static uint32_t benchmarkFixed(uint32_t iterations)
+{
+    constexpr Centidegrees TARGET = toCenti(50);
+    NumberBuffer number;
+    uint32_t result = 0;
+    for (uint32_t i = 0; i < iterations; i++) {
+        Centidegrees temperature = static_cast<Centidegrees>(benchmarkReading(i) * DHTFormat<DHTType::DHT22>::DATA_FACTOR);
+        result += (temperature < TARGET) + static_cast<uint32_t>(formatCenti(temperature, number).size());
+    }
+    return result;
+}
+
+/**
+ * Takes @a iterations readings the way the firmware did before measurements were fixed point: divided in float,
+ * compared in float, and formatted with std::to_string, which are all soft-float library calls on the RP2040.
+ *
+ * @return A value derived from the results, so the compiler cannot discard the work.
+ */
+static uint32_t benchmarkFloat(uint32_t iterations)
+{
+    constexpr float TARGET = 50.0f;
+    constexpr float DATA_FACTOR = 10.0f;
+    uint32_t result = 0;
+    for (uint32_t i = 0; i < iterations; i++) {
+        float temperature = benchmarkReading(i) / DATA_FACTOR;
+        result += (temperature < TARGET) + static_cast<uint32_t>(std::to_string(temperature).size());
+    }
+    return result;
+}
+
+/**
+ * Prints the processor cycles taken per reading by the fixed point and float measurement paths, timed on the Pico.
+ *
+ * Runs before anything else is started, so nothing else competes for the core, and waits for the USB console first so
+ * the results are not lost.
+ *
+ * @param[in] iterations The number of readings to time through each path, which must not be 0.
+ */
+static void benchmarkMeasurements(uint32_t iterations)
+{
+    while (!stdio_usb_connected()) {
+        sleep_ms(BENCHMARK_CONSOLE_POLL_MS);
+    }
+
+    uint64_t cycles_per_us = clock_get_hz(clk_sys) / HZ_PER_MHZ;
+    const std::pair<const char*, uint32_t (*)(uint32_t)> paths[] = {
+        {"fixed", benchmarkFixed},
+        {"float", benchmarkFloat},
+    };
+    for (const auto& [name, run] : paths) {
+        uint32_t start_us = time_us_32();
+        benchmark_sink = run(iterations);
+        uint64_t elapsed_us = time_us_32() - start_us;
+        printf("Measurement benchmark, %s: %llu cycles per reading over %u readings\n", name, (elapsed_us * cycles_per_us) / iterations,
+               iterations);
+    }
+}
+
+/**
+ * Logs that the command @a value received on @a topic was rejected.
+ *
+ * @param[in] topic The topic the command was received on.
+ * @param[in] value The command.
+ * @param[in] expected What the command should have been, e.g. "a valid temperature".
+ */
+static void printRejected(std::string_view topic, std::string_view value, const char* expected)
+{
+    printf("Failed to handle %.*s: '%.*s' is not %s\n", static_cast<int>(topic.size()), topic.data(), static_cast<int>(value.size()),
+           value.data(), expected);
+}
+
+/**
+ * Passes @a request to the control loop. This runs on the wireless driver's async context, where waiting for the control
+ * loop to make room would hold up all network processing, so a request which does not fit is dropped instead.
+ *
+ * @param[in] topic The topic the request was received on.
+ * @param[in] request The request.
+ */
+static void submitRequest(std::string_view topic, const request_entry& request)
+{
+    if (!queue_try_add(&request_queue, &request)) {
+        printf("Failed to handle %.*s: %u requests are already waiting for the control loop\n",
+               static_cast<int>(topic.size()),
+               topic.data(),
+               QUEUE_SIZE);
+    }
+}
+
+static void onSetTargetTemperatureReceived(std::string_view topic, mqtt::Payload data)
+{
+    request_entry set_request;
+    std::string_view value = mqtt::toString(data);
+    int32_t target_temperature = 0;
+
+    if (!parseCenti(value, target_temperature) || target_temperature > INT16_MAX || target_temperature < INT16_MIN) {
+        printRejected(topic, value, "a valid temperature");
+        return;
+    }
+
+    set_request.type = RequestType::TARGET_TEMPERATURE;
+    set_request.target_temperature = static_cast<Centidegrees>(target_temperature);
+    printf("Received request to set target temperature to %.*sC\n", static_cast<int>(value.size()), value.data());
+    submitRequest(topic, set_request);
+}
+
+static void onSetHeaterModeReceived(std::string_view topic, mqtt::Payload data)
 {
-    errno = 0;
     request_entry set_request;
-    std::string value = mqtt::toString(data);
-    set_request.target_temperature = strtof(value.c_str(), NULL);
+    std::string_view value = mqtt::toString(data);
 
-    if (errno) {
-        printf("Failed to handle %s: %u\n", topic.c_str(), errno);
+    set_request.type = RequestType::HEATER_MODE;
+    if (!controllers::fromString(value, set_request.heater_mode)) {
+        printRejected(topic, value, "a valid heater mode");
         return;
     }
 
-    printf("Received request to set target temperature to %.1fC\n", set_request.target_temperature);
-    queue_add_blocking(&request_queue, &set_request);
+    printf("Received request to set heater mode to %.*s\n", static_cast<int>(value.size()), value.data());
+    submitRequest(topic, set_request);
+}
+
+/**
+ * Parses PID gains in the form "Kp,Ti,Td", with Kp in percent per degree Celsius and Ti and Td in seconds.
+ *
+ * @param[in] text The gains.
+ * @param[out] gains The parsed gains.
+ * @return True if @a text holds three valid, non-negative gains, false otherwise.
+ */
+static bool parseGains(std::string_view text, controllers::PIDGains& gains)
+{
+    size_t first = text.find(',');
+    size_t second = first == std::string_view::npos ? first : text.find(',', first + 1);
+    if (second == std::string_view::npos) {
+        return false;
+    }
+
+    int32_t proportional = 0;
+    if (!parseCenti(text.substr(0, first), proportional) || proportional < 0) {
+        return false;
+    }
+
+    gains.proportional = proportional;
+    return parseSeconds(text.substr(first + 1, second - first - 1), gains.integral_time_ms)
+           && parseSeconds(text.substr(second + 1), gains.derivative_time_ms);
+}
+
+static void onSetPIDGainsReceived(std::string_view topic, mqtt::Payload data)
+{
+    request_entry set_request;
+    std::string_view value = mqtt::toString(data);
+
+    set_request.type = RequestType::PID_GAINS;
+    if (!parseGains(value, set_request.pid_gains)) {
+        printRejected(topic, value, "a valid set of gains (Kp,Ti,Td)");
+        return;
+    }
+
+    printf("Received request to set PID gains to %.*s\n", static_cast<int>(value.size()), value.data());
+    submitRequest(topic, set_request);
+}
+
+static void onSetPIDWindowReceived(std::string_view topic, mqtt::Payload data)
+{
+    request_entry set_request;
+    std::string_view value = mqtt::toString(data);
+
+    set_request.type = RequestType::PID_WINDOW;
+    if (!parseSeconds(value, set_request.pid_window_ms)) {
+        printRejected(topic, value, "a valid window");
+        return;
+    }
+
+    printf("Received request to set PID window to %.*ss\n", static_cast<int>(value.size()), value.data());
+    submitRequest(topic, set_request);
+}
+
+static void onSetProfileReceived(std::string_view topic, mqtt::Payload data)
+{
+    constexpr std::string_view STOP_PROFILE = "stop";
+    request_entry set_request;
+    std::string_view value = mqtt::toString(data);
+
+    if (value == STOP_PROFILE) {
+        set_request.type = RequestType::STOP_PROFILE;
+        printf("Received request to stop the drying profile\n");
+        submitRequest(topic, set_request);
+        return;
+    }
+
+    set_request.type = RequestType::START_PROFILE;
+    if (!controllers::fromString(value, set_request.profile)) {
+        printRejected(topic, value, "a valid profile");
+        return;
+    }
+
+    printf("Received request to run the %s drying profile\n", set_request.profile.name);
+    submitRequest(topic, set_request);
 }
 
 static bool initializeMQTT(mqtt::Client& client, const std::string& board_id)
 {
+    const std::pair<Topic, mqtt::TopicCallback> subscriptions[] = {
+        {Topic::SET_TARGET_TEMPERATURE, onSetTargetTemperatureReceived},
+        {Topic::SET_HEATER_MODE, onSetHeaterModeReceived},
+        {Topic::SET_PID_GAINS, onSetPIDGainsReceived},
+        {Topic::SET_PID_WINDOW, onSetPIDWindowReceived},
+        {Topic::SET_PROFILE, onSetProfileReceived},
+    };
+
+    // Subscriptions cannot be queued, so they are made first, while every request slot is free; the publishes after them
+    // queue until the broker has acknowledged the subscriptions.
+    for (const auto& [subscription, callback] : subscriptions) {
+        if (!client.subscribe(topicName(subscription), topicPolicy(subscription).qos, callback)) {
+            printf("Failed to subscribe to %s\n", topicName(subscription));
+            return false;
+        }
+    }
+
     if (!mqtt::initialize(client, board_id)) {
         printf("Failed to initialize MQTT\n");
         return false;
     }
 
-    char mqtt_topic[TOPIC_BUFFER_SIZE];
-    snprintf(mqtt_topic, TOPIC_BUFFER_SIZE, SET_TARGET_TEMPERATURE_TOPIC_FORMAT.data(), client.deviceName().c_str());
-    if (!client.subscribe(mqtt_topic, onSetTargetTemperatureReceived)) {
-        printf("Failed to subscribe to %s\n", mqtt_topic);
-        return false;
-    }
+    publishTopic(client, Topic::BOARD_RESET, supervisor::lastReset());
 
     printf("Successfully initialized MQTT\n");
     return true;
 }
 
-int main(int argc, char** argv)
+/**
+ * Prints a summary of the latest data and the connection.
+ *
+ * @param[in] data The latest data.
+ */
+static void printStatus(const feedback_entry& data)
 {
-    initialize();
-    std::string board_id = systemIdentifier();
-    uint32_t count = 0;
-    uint32_t wifi_count = 0;
-    bool mqtt_initialized = false;
+    NumberBuffer temperature;
+    NumberBuffer humidity;
+    NumberBuffer number;
+    printf("\n----------------- [%u]\n", network.count);
+    printf("Temperature: %sC, Humidity: %s%% (%s, %ums old)\n",
+           formatCenti(data.container_temperature.value, temperature).data(),
+           formatCenti(data.container_humidity.value, humidity).data(),
+           toString(data.container_temperature.quality).data(),
+           data.container_temperature.age_ms);
+    printf("Wifi Connection Status: %s (%s)\n", toString(network.wifi->status()).data(), network.wifi->ipAddress().c_str());
+    printf("CPU Temperature: %sC\n", formatCenti(data.board_temperature, number).data());
+    if (data.battery_monitored) {
+        printf("Battery: %s%%\n", formatCenti(data.battery_level, number).data());
+    }
+    printf("MQTT Status: %s\n", network.client->connected() ? "true" : "false");
+    printf("-----------------\n");
+}
 
-    sleep_ms(5000);
-    SystemConfiguration cfg;
-    if (!read(cfg)) {
-        printf("Failed to read system configuration\n");
-        return EXIT_FAILURE;
+/**
+ * Publishes how long after boot the first good sample was read, and the first data was published.
+ *
+ * @param[in] client The MQTT client.
+ * @param[in] data The data which was just published.
+ * @return True once both metrics have been published, false if the first good sample has not been read yet.
+ */
+static bool publishBootMetrics(mqtt::Client& client, const feedback_entry& data)
+{
+    if (data.first_sample_ms == 0) {
+        return false;
     }
 
-    WifiConnection wifi(cfg.deviceName(), cfg.ssid(), cfg.passphrase());
-    mqtt::Client mqtt(cfg.mqttBroker(), CONFIGURED_MQTT_PORT, cfg.deviceName(), MQTT_FEEDBACK_PIN);
-    sleep_ms(COMMUNICATION_PERIOD_MS);
+    NumberBuffer number;
+    publishTopic(client, Topic::BOOT_FIRST_SAMPLE, formatInteger(data.first_sample_ms, number));
+    publishTopic(client, Topic::BOOT_FIRST_PUBLISH, formatInteger(network.first_publish_ms, number));
+    return true;
+}
 
-    multicore_launch_core1(controlLoop);
+/**
+ * @return The earlier of @a first and @a second.
+ */
+static absolute_time_t earliest(absolute_time_t first, absolute_time_t second)
+{
+    return absolute_time_diff_us(first, second) > 0 ? first : second;
+}
 
-    while (true) {
-        if (wifi.status() != ConnectionStatus::CONNECTED) {
-            printf("Wifi status: %s\n", toString(wifi.status()).data());
-            if (wifi_count > WIFI_NOT_CONNECTED_THRESHOLD) {
-                printf("Attempting reconnect of wifi...\n");
-                wifi.reset();
-                wifi_count = 0;
-            }
-            else {
-                wifi_count++;
-            }
-            sleep_ms(COMMUNICATION_PERIOD_MS);
-            continue;
+/**
+ * Advances the connection to the broker as far as it can without waiting, and publishes new data once connected.
+ *
+ * Runs whenever the wireless link or the MQTT connection changes, the control loop has new data, or a deadline passes.
+ * Nothing here blocks: connection attempts complete in the background and report back as events.
+ *
+ * @return The time by which this should next run, even if no event arrives.
+ */
+static absolute_time_t runNetwork()
+{
+    absolute_time_t now = get_absolute_time();
+    absolute_time_t idle_time = delayed_by_ms(now, NETWORK_IDLE_PERIOD_MS);
+
+    if (network.wifi->status() != ConnectionStatus::CONNECTED) {
+        supervisor::checkIn(supervisor::Checkpoint::WIFI_CONNECT);
+        if (network.state != NetworkState::WIFI_CONNECTING) {
+            printf("Wifi status: %s\n", toString(network.wifi->status()).data());
+            network.state = NetworkState::WIFI_CONNECTING;
+            network.attempt_deadline = delayed_by_ms(now, WIFI_CONNECTION_WAIT_MS);
         }
+        else if (time_reached(network.attempt_deadline)) {
+            printf("Attempting reconnect of wifi...\n");
+            network.wifi->reset();
+            network.attempt_deadline = delayed_by_ms(now, WIFI_CONNECTION_WAIT_MS);
+        }
+        return earliest(network.attempt_deadline, idle_time);
+    }
 
-        if (!mqtt.connected()) {
+    if (!network.client->connected()) {
+        supervisor::checkIn(supervisor::Checkpoint::MQTT_CONNECT);
+        if (network.state != NetworkState::MQTT_CONNECTING || time_reached(network.attempt_deadline)) {
             printf("Connecting MQTT...\n");
-            mqtt_initialized = false;
-            mqtt.connect();
-            sleep_ms(MQTT_CONNECTION_WAIT_MS);
-            continue;
+            network.state = NetworkState::MQTT_CONNECTING;
+            network.attempt_deadline = delayed_by_ms(now, MQTT_CONNECTION_WAIT_MS);
+            network.client->connect();
         }
+        return earliest(network.attempt_deadline, idle_time);
+    }
 
-        if (!mqtt_initialized) {
-            printf("Initializing MQTT...\n");
-            mqtt_initialized = initializeMQTT(mqtt, board_id);
-            sleep_ms(COMMUNICATION_PERIOD_MS);
-            continue;
+    if (network.state != NetworkState::ONLINE) {
+        supervisor::checkIn(supervisor::Checkpoint::MQTT_SUBSCRIBE);
+        printf("Initializing MQTT...\n");
+        if (!initializeMQTT(*network.client, *network.board_id)) {
+            return idle_time;
         }
 
-        feedback_entry data = getMostRecentData();
-        publish(mqtt, data);
+        network.state = NetworkState::ONLINE;
+        network.history_backlog_end = history.end();
+        network.boot_metrics_published = false;
+        network.publish_time = now;
 
-        printf("\n----------------- [%u]\n", count);
+        // The broker may not have kept what was published before, so everything goes out again on a new connection.
+        for (ReportFilter& filter : network.reports) {
+            filter.reset();
+        }
+    }
 
-        wifi.poll();
+    supervisor::checkIn(supervisor::Checkpoint::COMMUNICATION_IDLE);
+    network.client->flush();
+
+    feedback_entry data;
+    uint32_t version = feedback_mailbox.read(data);
+    if (version == network.published_version) {
+        return earliest(network.publish_time, idle_time);
+    }
 
-        printf("Temperature: %.1fC, Humidity: %.1f%%\n", data.container_temperature, data.container_humidity);
-        printf("Wifi Connection Status: %s (%s)\n", toString(wifi.status()).data(), wifi.ipAddress().c_str());
-        printf("CPU Temperature: %.1fC\n", data.board_temperature);
-        printf("MQTT Status: %s\n", mqtt.connected() ? "true" : "false");
+    // Data which reflects a request received over MQTT is published straight away, rather than with the next period.
+    if (!time_reached(network.publish_time) && data.requests_handled == network.published_requests) {
+        return earliest(network.publish_time, idle_time);
+    }
 
-        printf("-----------------\n");
+    supervisor::checkIn(supervisor::Checkpoint::MQTT_PUBLISH);
+    // History goes first, since it can only be sent while there is room for it.
+    publishHistory(*network.client, network.history_backlog_end);
+    if constexpr (TELEMETRY_FORMAT != "CBOR") {
+        publish(*network.client, data);
+    }
+    if constexpr (TELEMETRY_FORMAT != "TOPICS") {
+        publishTelemetry(*network.client, data, network.count);
+    }
+    // The summary is for debugging over USB; it takes several printf calls and a heap string, so it is off by default.
+    if (STATUS_PERIOD_MS > 0 && time_reached(network.status_time)) {
+        printStatus(data);
+        network.status_time = delayed_by_ms(now, STATUS_PERIOD_MS);
+    }
 
+    if (network.first_publish_ms == 0) {
+        network.first_publish_ms = to_ms_since_boot(now);
+        printf("First publish %ums after boot\n", network.first_publish_ms);
+    }
+    if (!network.boot_metrics_published) {
+        network.boot_metrics_published = publishBootMetrics(*network.client, data);
+    }
+
+    network.published_version = version;
+    network.published_requests = data.requests_handled;
+    network.publish_time = delayed_by_ms(now, COMMUNICATION_PERIOD_MS);
+    network.count++;
+    supervisor::checkIn(supervisor::Checkpoint::COMMUNICATION_IDLE);
+    return earliest(network.publish_time, idle_time);
+}
+
+/**
+ * Reschedules the network timer for @a timepoint.
+ *
+ * @param[in] context The async context.
+ * @param[in] timepoint The time at which the timer should run.
+ */
+static void scheduleNetwork(async_context_t* context, absolute_time_t timepoint)
+{
+    async_context_remove_at_time_worker(context, &network_timer_worker);
+    async_context_add_at_time_worker_at(context, &network_timer_worker, timepoint);
+}
+
+static void onNetworkEvent(async_context_t* context, async_when_pending_worker_t* /* unused */)
+{
+    scheduleNetwork(context, runNetwork());
+}
+
+static void onNetworkTimer(async_context_t* context, async_at_time_worker_t* /* unused */)
+{
+    scheduleNetwork(context, runNetwork());
+}
+
+/**
+ * Starts running the network side on the wireless driver's async context, woken by connection changes and new data.
+ *
+ * @param[in] wifi The wireless connection.
+ * @param[in] client The MQTT client.
+ * @param[in] board_id The identifier of the board.
+ */
+static void startNetwork(WifiConnection& wifi, mqtt::Client& client, const std::string& board_id)
+{
+    network.wifi = &wifi;
+    network.client = &client;
+    network.board_id = &board_id;
+    network.state = NetworkState::WIFI_CONNECTING;
+    network.attempt_deadline = make_timeout_time_ms(WIFI_CONNECTION_WAIT_MS);
+    network.publish_time = get_absolute_time();
+    network.status_time = get_absolute_time();
+    network.published_version = 0;
+    network.published_requests = 0;
+    network.history_backlog_end = 0;
+    network.count = 0;
+    network.first_publish_ms = 0;
+    network.boot_metrics_published = false;
+
+    // The device name never changes, so every topic is formatted once here rather than for each publish.
+    if (!topics.build(TOPICS.data(), TOPICS.size(), client.deviceName())) {
+        printf("Failed to start the network, the topics for %s do not fit\n", client.deviceName().c_str());
+        return;
+    }
+
+    async_context_t* context = cyw43_arch_async_context();
+    if (context == nullptr) {
+        printf("Failed to start the network, the wireless driver is not initialized\n");
+        return;
+    }
+
+    network_event_worker.do_work = onNetworkEvent;
+    network_timer_worker.do_work = onNetworkTimer;
+
+    async_context_acquire_lock_blocking(context);
+    async_context_add_when_pending_worker(context, &network_event_worker);
+    async_context_add_at_time_worker_in_ms(context, &network_timer_worker, 0);
+    async_context_release_lock(context);
+
+    auto wake = [context]() { async_context_set_work_pending(context, &network_event_worker); };
+    wifi.setStatusCallback(wake);
+    client.setStatusCallback([wake](mqtt_connection_status_t /* unused */) { wake(); });
+    client.setReadyCallback(wake);
+    network_context = context;
+}
+
+int main(int argc, char** argv)
+{
+    initialize();
+    if constexpr (BENCHMARK_ITERATIONS > 0) {
+        benchmarkMeasurements(BENCHMARK_ITERATIONS);
+    }
+    supervisor::start();
+    std::string board_id = systemIdentifier();
+
+    SystemConfiguration cfg;
+    if (!read(cfg)) {
+        printf("Failed to read system configuration\n");
+        return EXIT_FAILURE;
+    }
+
+    // The sensors claim their PIO state machines and load their programs here, before the wireless driver does the same
+    // for its SPI bus. Neither claim is atomic, so they must not run on both cores at once.
+    environmentSensor();
+    if (BAY_COUNT > 0) {
+        bayArray();
+    }
+
+    // The heater is controlled from the moment the configuration is known; connecting only affects monitoring, so it
+    // happens alongside. The control loop wakes the network once it is started.
+    multicore_launch_core1(controlLoop);
+
+    supervisor::checkIn(supervisor::Checkpoint::WIFI_CONNECT);
+    WifiConnection wifi(cfg.deviceName(), cfg.ssid(), cfg.passphrase());
+    mqtt::Client mqtt(cfg.mqttBroker(), CONFIGURED_MQTT_PORT, cfg.deviceName(), MQTT_FEEDBACK_PIN);
+    startNetwork(wifi, mqtt, board_id);
+
+    // Everything from here on runs on the async context, so this thread only has to keep the connection objects alive.
+    while (true) {
         sleep_ms(COMMUNICATION_PERIOD_MS);
-        count++;
     }
 
     return EXIT_SUCCESS;
@@ -0,0 +1,162 @@
+/*------------------------------------------------------------------------------
+Copyright (c) 2023 Joe Porembski
+SPDX-License-Identifier: BSD-3-Clause
+------------------------------------------------------------------------------*/
+#include "measurement.hpp"
+
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+#include <string_view>
+
+
+inline constexpr uint8_t DECIMAL_PLACES = 2;
+inline constexpr int32_t DECIMAL_BASE = 10;
+inline constexpr int32_t MAXIMUM_WHOLE_VALUE = INT32_MAX / CENTI_PER_UNIT;
+inline constexpr int32_t MAXIMUM_FRACTION_AT_LIMIT = INT32_MAX % CENTI_PER_UNIT;
+inline constexpr int32_t MS_PER_CENTISECOND = 10;
+inline constexpr std::string_view SAMPLE_QUALITY_GOOD = "good";
+inline constexpr std::string_view SAMPLE_QUALITY_STALE = "stale";
+inline constexpr std::string_view SAMPLE_QUALITY_INVALID = "invalid";
+
+std::string_view toString(SampleQuality quality)
+{
+    switch (quality) {
+    case SampleQuality::GOOD:
+        return SAMPLE_QUALITY_GOOD;
+    case SampleQuality::STALE:
+        return SAMPLE_QUALITY_STALE;
+    case SampleQuality::INVALID:
+    default:
+        return SAMPLE_QUALITY_INVALID;
+    }
+}
+
+bool parseCenti(std::string_view text, int32_t& value)
+{
+    bool negative = false;
+    if (!text.empty() && (text.front() == '-' || text.front() == '+')) {
+        negative = text.front() == '-';
+        text.remove_prefix(1);
+    }
+
+    int32_t whole = 0;
+    int32_t fraction = 0;
+    uint8_t fraction_digits = 0;
+    bool seen_digit = false;
+    bool seen_point = false;
+    for (char character : text) {
+        if (character == '.' && !seen_point) {
+            seen_point = true;
+            continue;
+        }
+
+        if (character < '0' || character > '9') {
+            return false;
+        }
+
+        seen_digit = true;
+        int32_t digit = character - '0';
+        if (!seen_point) {
+            if (whole > (MAXIMUM_WHOLE_VALUE - digit) / DECIMAL_BASE) {
+                return false;
+            }
+            whole = (whole * DECIMAL_BASE) + digit;
+        }
+        else if (fraction_digits < DECIMAL_PLACES) {
+            fraction = (fraction * DECIMAL_BASE) + digit;
+            fraction_digits++;
+        }
+    }
+
+    if (!seen_digit) {
+        return false;
+    }
+
+    for (; fraction_digits < DECIMAL_PLACES; fraction_digits++) {
+        fraction *= DECIMAL_BASE;
+    }
+
+    // The whole part alone fits, but with the fraction the largest whole value can still pass INT32_MAX.
+    if (whole == MAXIMUM_WHOLE_VALUE && fraction > MAXIMUM_FRACTION_AT_LIMIT) {
+        return false;
+    }
+
+    value = toCenti(whole) + fraction;
+    if (negative) {
+        value = -value;
+    }
+    return true;
+}
+
+bool parseSeconds(std::string_view text, uint32_t& milliseconds)
+{
+    int32_t centiseconds = 0;
+    if (!parseCenti(text, centiseconds) || centiseconds < 0 || centiseconds > INT32_MAX / MS_PER_CENTISECOND) {
+        return false;
+    }
+
+    milliseconds = static_cast<uint32_t>(centiseconds * MS_PER_CENTISECOND);
+    return true;
+}
+
+/**
+ * Writes the decimal digits of @a magnitude backwards from @a end.
+ *
+ * @param[in] magnitude The value to write.
+ * @param[in] end The position after the last digit.
+ * @return The position of the first digit.
+ */
+static char* writeDigits(uint64_t magnitude, char* end)
+{
+    // 64-bit division is a library call on the RP2040, so it is only used for the digits a 32-bit value cannot hold.
+    while (magnitude > UINT32_MAX) {
+        *--end = static_cast<char>('0' + magnitude % DECIMAL_BASE);
+        magnitude /= DECIMAL_BASE;
+    }
+
+    uint32_t remainder = static_cast<uint32_t>(magnitude);
+    do {
+        *--end = static_cast<char>('0' + remainder % DECIMAL_BASE);
+        remainder /= DECIMAL_BASE;
+    } while (remainder != 0);
+    return end;
+}
+
+std::string centiToString(int32_t value)
+{
+    NumberBuffer buffer;
+    return std::string(formatCenti(value, buffer));
+}
+
+std::string_view formatInteger(int64_t value, NumberBuffer& buffer)
+{
+    char* end = buffer.data() + buffer.size() - 1;
+    *end = '\0';
+
+    // Work with the magnitude as unsigned, so INT64_MIN does not overflow.
+    uint64_t magnitude = value < 0 ? 0u - static_cast<uint64_t>(value) : static_cast<uint64_t>(value);
+    char* start = writeDigits(magnitude, end);
+    if (value < 0) {
+        *--start = '-';
+    }
+    return std::string_view(start, static_cast<size_t>(end - start));
+}
+
+std::string_view formatCenti(int32_t value, NumberBuffer& buffer)
+{
+    char* end = buffer.data() + buffer.size() - 1;
+    *end = '\0';
+
+    uint32_t magnitude = value < 0 ? 0u - static_cast<uint32_t>(value) : static_cast<uint32_t>(value);
+    uint32_t fraction = magnitude % CENTI_PER_UNIT;
+    char* start = end;
+    *--start = static_cast<char>('0' + fraction % DECIMAL_BASE);
+    *--start = static_cast<char>('0' + fraction / DECIMAL_BASE);
+    *--start = '.';
+    start = writeDigits(magnitude / CENTI_PER_UNIT, start);
+    if (value < 0) {
+        *--start = '-';
+    }
+    return std::string_view(start, static_cast<size_t>(end - start));
+}
@@ -0,0 +1,127 @@
+/*------------------------------------------------------------------------------
+Copyright (c) 2023 Joe Porembski
+SPDX-License-Identifier: BSD-3-Clause
+------------------------------------------------------------------------------*/
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+
+/*
+ * Measurements are carried as integers in hundredths of their unit, since the RP2040 has no FPU and every float
+ * operation is a call into the soft-float library. Values are only converted to and from text at the edges.
+ */
+
+/** A temperature in hundredths of a degree Celsius. */
+using Centidegrees = int16_t;
+
+/** A relative humidity in hundredths of a percent. */
+using Centipercent = int16_t;
+
+/**
+ * Enumerates the quality of a filtered sample.
+ */
+enum class SampleQuality : uint8_t
+{
+    /** The sample was updated from a fresh, accepted reading. */
+    GOOD,
+
+    /** The latest reading failed or was rejected, the sample holds the last good value (see Sample::age_ms). */
+    STALE,
+
+    /** There is no good value recent enough to be used. */
+    INVALID
+};
+
+/**
+ * A filtered measurement, tagged with its quality and age.
+ */
+struct Sample
+{
+    /** The filtered value in hundredths of its unit. */
+    int16_t value;
+
+    /** The quality of @a value. */
+    SampleQuality quality;
+
+    /** The time since @a value was last updated from a good reading, in milliseconds. */
+    uint32_t age_ms;
+};
+
+/** The number of hundredths in a whole unit. */
+inline constexpr int32_t CENTI_PER_UNIT = 100;
+
+/** The size of a NumberBuffer, enough for any int64_t in decimal, with its sign and a terminating null. */
+inline constexpr size_t NUMBER_BUFFER_SIZE = 24;
+
+/** Space for a number formatted by formatInteger() or formatCenti(), so the text can be kept on the stack. */
+using NumberBuffer = std::array<char, NUMBER_BUFFER_SIZE>;
+
+/**
+ * Converts a whole number of units into hundredths.
+ *
+ * @param[in] value The value in whole units.
+ * @return @a value in hundredths.
+ */
+constexpr int32_t toCenti(int32_t value)
+{
+    return value * CENTI_PER_UNIT;
+}
+
+/**
+ * Converts @a quality to a human readable string.
+ *
+ * @param[in] quality The SampleQuality value.
+ * @return A human readable name for @a quality.
+ */
+std::string_view toString(SampleQuality quality);
+
+/**
+ * Parses a decimal number, such as "45", "-3.5" or "45.25", into hundredths.
+ *
+ * @note Digits beyond the second decimal place are truncated.
+ * @param[in] text The text to parse.
+ * @param[out] value The parsed value in hundredths.
+ * @return True if @a text was a valid decimal number whose hundredths fit in an int32_t, of either sign, false otherwise.
+ */
+bool parseCenti(std::string_view text, int32_t& value);
+
+/**
+ * Parses a duration in seconds, such as "300" or "2.5", into milliseconds.
+ *
+ * @note Digits beyond the second decimal place are truncated.
+ * @param[in] text The duration in seconds.
+ * @param[out] milliseconds The duration in milliseconds.
+ * @return True if @a text is a valid, non-negative duration of at most INT32_MAX milliseconds, false otherwise.
+ */
+bool parseSeconds(std::string_view text, uint32_t& milliseconds);
+
+/**
+ * Converts a value in hundredths into a decimal string, such as "45.30".
+ *
+ * @param[in] value The value in hundredths.
+ * @return @a value as a decimal string with two decimal places.
+ */
+std::string centiToString(int32_t value);
+
+/**
+ * Formats an integer into @a buffer as decimal text, without allocating.
+ *
+ * @param[in] value The value.
+ * @param[out] buffer The space to format into.
+ * @return The text of @a value, which lies within @a buffer and is followed by a null.
+ */
+std::string_view formatInteger(int64_t value, NumberBuffer& buffer);
+
+/**
+ * Formats a value in hundredths into @a buffer as a decimal with two decimal places, such as "45.30", without allocating.
+ *
+ * @param[in] value The value in hundredths.
+ * @param[out] buffer The space to format into.
+ * @return The text of @a value, which lies within @a buffer and is followed by a null.
+ */
+std::string_view formatCenti(int32_t value, NumberBuffer& buffer);
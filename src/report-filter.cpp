@@ -0,0 +1,69 @@
+/*------------------------------------------------------------------------------
+Copyright (c) 2023 Joe Porembski
+SPDX-License-Identifier: BSD-3-Clause
+------------------------------------------------------------------------------*/
+#include "report-filter.hpp"
+
+#include <cstdint>
+#include <string_view>
+
+
+inline constexpr uint32_t FNV_OFFSET_BASIS = 2166136261u;
+inline constexpr uint32_t FNV_PRIME = 16777619u;
+
+ReportFilter::ReportFilter()
+    : _value(0),
+      _time_ms(0),
+      _reported(false),
+      _sent(0),
+      _suppressed(0)
+{
+}
+
+uint32_t ReportFilter::sent() const
+{
+    return _sent;
+}
+
+uint32_t ReportFilter::suppressed() const
+{
+    return _suppressed;
+}
+
+bool ReportFilter::due(int32_t value, int32_t deadband, uint32_t now_ms, uint32_t heartbeat_ms)
+{
+    if (!_reported || heartbeat_ms == 0 || now_ms - _time_ms >= heartbeat_ms) {
+        return true;
+    }
+
+    // The difference is taken in 64 bits, since that of two extreme values does not fit in 32.
+    int64_t change = static_cast<int64_t>(value) - _value;
+    if (change > deadband || -change > deadband) {
+        return true;
+    }
+
+    _suppressed++;
+    return false;
+}
+
+void ReportFilter::reported(int32_t value, uint32_t now_ms)
+{
+    _value = value;
+    _time_ms = now_ms;
+    _reported = true;
+    _sent++;
+}
+
+void ReportFilter::reset()
+{
+    _reported = false;
+}
+
+int32_t textKey(std::string_view text)
+{
+    uint32_t hash = FNV_OFFSET_BASIS;
+    for (char character : text) {
+        hash = (hash ^ static_cast<uint8_t>(character)) * FNV_PRIME;
+    }
+    return static_cast<int32_t>(hash);
+}
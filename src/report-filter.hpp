@@ -0,0 +1,73 @@
+/*------------------------------------------------------------------------------
+Copyright (c) 2023 Joe Porembski
+SPDX-License-Identifier: BSD-3-Clause
+------------------------------------------------------------------------------*/
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+
+
+/**
+ * Decides when a value is worth reporting, so that one which holds steady is not sent again every cycle.
+ *
+ * A value is due when it has moved beyond a deadband from the value last reported, or when the heartbeat interval has
+ * passed since then, so that a retained value is refreshed even while it does not change. The first value, and the
+ * first after reset(), is always due.
+ *
+ * Values are integers, such as hundredths of a degree or an enumeration; text is compared through textKey().
+ */
+class ReportFilter
+{
+public:
+    /** A deadband no change can move beyond, so the value is only reported with the heartbeat. */
+    static constexpr int32_t HEARTBEAT_ONLY = INT32_MAX;
+
+    ReportFilter();
+
+    /**
+     * @return The number of values reported.
+     */
+    uint32_t sent() const;
+
+    /**
+     * @return The number of values which were not due, and so were not reported.
+     */
+    uint32_t suppressed() const;
+
+    /**
+     * Checks whether @a value should be reported, counting it as suppressed if not.
+     *
+     * @param[in] value The current value.
+     * @param[in] deadband The largest change from the last reported value which is not reported; 0 reports any change.
+     * @param[in] now_ms The current time in milliseconds.
+     * @param[in] heartbeat_ms The longest time between reports; 0 makes every value due.
+     * @return True if @a value should be reported, false otherwise.
+     */
+    bool due(int32_t value, int32_t deadband, uint32_t now_ms, uint32_t heartbeat_ms);
+
+    /**
+     * Records that @a value was reported, which should follow a call to due() which returned true.
+     *
+     * @param[in] value The value reported.
+     * @param[in] now_ms The time it was reported in milliseconds.
+     */
+    void reported(int32_t value, uint32_t now_ms);
+
+    /**
+     * Forgets the last reported value, so the next is due whatever it is. The counters are kept.
+     */
+    void reset();
+
+private:
+    int32_t _value;
+    uint32_t _time_ms;
+    bool _reported;
+    uint32_t _sent;
+    uint32_t _suppressed;
+};
+
+/**
+ * @return A value which changes whenever @a text does, for reporting text through ReportFilter with a deadband of 0.
+ */
+int32_t textKey(std::string_view text);
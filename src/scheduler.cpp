@@ -0,0 +1,89 @@
+/*------------------------------------------------------------------------------
+Copyright (c) 2023 Joe Porembski
+SPDX-License-Identifier: BSD-3-Clause
+------------------------------------------------------------------------------*/
+#include "scheduler.hpp"
+
+#include <pico/stdio.h>
+#include <pico/time.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+
+
+inline constexpr int64_t US_PER_MS = 1000;
+
+PeriodicSchedule::PeriodicSchedule(uint32_t period_ms)
+    : _period_ms(period_ms),
+      _deadline(nil_time),
+      _cycle_start(nil_time),
+      _started(false),
+      _statistics(),
+      _jitter_sum_us(0)
+{
+}
+
+uint32_t PeriodicSchedule::period() const
+{
+    return _period_ms;
+}
+
+PeriodStatistics PeriodicSchedule::statistics() const
+{
+    PeriodStatistics statistics = _statistics;
+    if (statistics.cycles > 0) {
+        statistics.mean_jitter_us = static_cast<int32_t>(_jitter_sum_us / statistics.cycles);
+    }
+    return statistics;
+}
+
+void PeriodicSchedule::start()
+{
+    _cycle_start = get_absolute_time();
+    _deadline = _cycle_start;
+    _started = true;
+}
+
+bool PeriodicSchedule::wait()
+{
+    if (!_started) {
+        start();
+    }
+
+    _deadline = delayed_by_ms(_deadline, _period_ms);
+    absolute_time_t now = get_absolute_time();
+    int64_t late_us = absolute_time_diff_us(_deadline, now);
+    if (late_us <= 0) {
+        sleep_until(_deadline);
+        _measure(get_absolute_time());
+        return true;
+    }
+
+    // Run the next cycle straight away, but on the next deadline of the original grid, not one period from now.
+    uint32_t missed = static_cast<uint32_t>(late_us / (_period_ms * US_PER_MS));
+    _deadline = delayed_by_ms(_deadline, missed * _period_ms);
+    _statistics.overruns++;
+    _statistics.skipped += missed;
+    printf("Periodic cycle overran its deadline by %lldus, skipping %u periods\n", static_cast<long long>(late_us), missed);
+    _measure(now);
+    return false;
+}
+
+void PeriodicSchedule::_measure(absolute_time_t timepoint)
+{
+    int64_t period_us = absolute_time_diff_us(_cycle_start, timepoint);
+    int32_t jitter_us = static_cast<int32_t>(period_us - _period_ms * US_PER_MS);
+    _cycle_start = timepoint;
+
+    if (_statistics.cycles == 0) {
+        _statistics.min_jitter_us = jitter_us;
+        _statistics.max_jitter_us = jitter_us;
+    }
+    else {
+        _statistics.min_jitter_us = std::min(_statistics.min_jitter_us, jitter_us);
+        _statistics.max_jitter_us = std::max(_statistics.max_jitter_us, jitter_us);
+    }
+    _jitter_sum_us += jitter_us;
+    _statistics.cycles++;
+}
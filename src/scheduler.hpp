@@ -0,0 +1,89 @@
+/*------------------------------------------------------------------------------
+Copyright (c) 2023 Joe Porembski
+SPDX-License-Identifier: BSD-3-Clause
+------------------------------------------------------------------------------*/
+#pragma once
+
+#include <pico/time.h>
+
+#include <cstdint>
+
+
+/**
+ * The timing of a periodic loop, as measured by PeriodicSchedule.
+ */
+struct PeriodStatistics
+{
+    /** The number of periods measured. */
+    uint32_t cycles;
+
+    /** The number of times the work of a cycle ran past its deadline. */
+    uint32_t overruns;
+
+    /** The number of deadlines skipped because of overruns. */
+    uint32_t skipped;
+
+    /** The smallest difference between a measured period and the nominal period, in microseconds. */
+    int32_t min_jitter_us;
+
+    /** The largest difference between a measured period and the nominal period, in microseconds. */
+    int32_t max_jitter_us;
+
+    /** The mean difference between the measured periods and the nominal period, in microseconds. */
+    int32_t mean_jitter_us;
+};
+
+/**
+ * Runs a loop at a fixed period, against absolute deadlines rather than a sleep after the work is done.
+ *
+ * Each deadline is the previous deadline plus the period, so the time spent on the work of a cycle does not add up into
+ * drift. If the work of a cycle runs past its next deadline, that is counted as an overrun, and the deadlines which were
+ * missed are skipped rather than run back to back, keeping later cycles on the original grid.
+ */
+class PeriodicSchedule
+{
+public:
+    /**
+     * Constructor.
+     *
+     * @param[in] period_ms The period in milliseconds.
+     */
+    explicit PeriodicSchedule(uint32_t period_ms);
+
+    /**
+     * @return The period in milliseconds.
+     */
+    uint32_t period() const;
+
+    /**
+     * @return The timing measured since the schedule started.
+     */
+    PeriodStatistics statistics() const;
+
+    /**
+     * Starts the schedule, with the first cycle beginning now.
+     */
+    void start();
+
+    /**
+     * Sleeps until the start of the next cycle.
+     *
+     * @return True if the next deadline was met, false if the cycle overran it.
+     */
+    bool wait();
+
+private:
+    /**
+     * Records the time the current cycle started.
+     *
+     * @param[in] timepoint The start of the cycle.
+     */
+    void _measure(absolute_time_t timepoint);
+
+    uint32_t _period_ms;
+    absolute_time_t _deadline;
+    absolute_time_t _cycle_start;
+    bool _started;
+    PeriodStatistics _statistics;
+    int64_t _jitter_sum_us;
+};
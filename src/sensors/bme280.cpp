@@ -0,0 +1,103 @@
+/*------------------------------------------------------------------------------
+Copyright (c) 2023 Joe Porembski
+SPDX-License-Identifier: BSD-3-Clause
+------------------------------------------------------------------------------*/
+#include "sensors/bme280.hpp"
+
+#include "gpio.hpp"
+
+#include <pico/stdio.h>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+
+
+namespace sensors {
+inline constexpr uint8_t CHIP_ID_REGISTER = 0xD0;
+inline constexpr uint8_t CHIP_ID = 0x60;
+inline constexpr uint8_t TEMPERATURE_CALIBRATION_REGISTER = 0x88;
+inline constexpr size_t TEMPERATURE_CALIBRATION_SIZE = 26;
+inline constexpr size_t DIG_H1_INDEX = 25;
+inline constexpr uint8_t HUMIDITY_CALIBRATION_REGISTER = 0xE1;
+inline constexpr size_t HUMIDITY_CALIBRATION_SIZE = 7;
+inline constexpr std::array<uint8_t, 2> HUMIDITY_OVERSAMPLING_COMMAND = {0xF2, 0x01};
+inline constexpr int32_t SKIPPED_TEMPERATURE = 0x80000;
+inline constexpr int32_t SKIPPED_HUMIDITY = 0x8000;
+inline constexpr int32_t MAXIMUM_HUMIDITY_Q22_10 = 419430400;
+inline constexpr uint8_t HUMIDITY_FRACTION_BITS = 10;
+inline constexpr uint8_t NIBBLE_BITS = 4;
+inline constexpr uint8_t LOW_NIBBLE = 0x0F;
+
+/**
+ * @param[in] data The two bytes of a little-endian word.
+ * @return The word.
+ */
+static uint16_t littleEndian(const uint8_t* data)
+{
+    return static_cast<uint16_t>(data[0] | (data[1] << BITS_IN_BYTE));
+}
+
+bool BME280::initialize(detail::I2CTransfer& transfer, uint8_t address, Calibration& calibration)
+{
+    if (!transfer.run(address, &CHIP_ID_REGISTER, 1, 1) || transfer.response()[0] != CHIP_ID) {
+        printf("No BME280 found at address 0x%02x\n", address);
+        return false;
+    }
+
+    if (!transfer.run(address, &TEMPERATURE_CALIBRATION_REGISTER, 1, TEMPERATURE_CALIBRATION_SIZE)) {
+        return false;
+    }
+
+    const uint8_t* data = transfer.response();
+    calibration.dig_T1 = littleEndian(&data[0]);
+    calibration.dig_T2 = static_cast<int16_t>(littleEndian(&data[2]));
+    calibration.dig_T3 = static_cast<int16_t>(littleEndian(&data[4]));
+    calibration.dig_H1 = data[DIG_H1_INDEX];
+
+    if (!transfer.run(address, &HUMIDITY_CALIBRATION_REGISTER, 1, HUMIDITY_CALIBRATION_SIZE)) {
+        return false;
+    }
+
+    // H4 and H5 are 12-bit values which share the nibbles of the byte between them.
+    data = transfer.response();
+    calibration.dig_H2 = static_cast<int16_t>(littleEndian(&data[0]));
+    calibration.dig_H3 = data[2];
+    calibration.dig_H4 = static_cast<int16_t>((static_cast<int8_t>(data[3]) * (1 << NIBBLE_BITS)) | (data[4] & LOW_NIBBLE));
+    calibration.dig_H5 = static_cast<int16_t>((static_cast<int8_t>(data[5]) * (1 << NIBBLE_BITS)) | (data[4] >> NIBBLE_BITS));
+    calibration.dig_H6 = static_cast<int8_t>(data[6]);
+
+    // Humidity oversampling only takes effect on the next write to ctrl_meas, which every measurement does.
+    return transfer.run(address, HUMIDITY_OVERSAMPLING_COMMAND.data(), HUMIDITY_OVERSAMPLING_COMMAND.size(), 0);
+}
+
+bool BME280::decode(const uint8_t* data, const Calibration& calibration, Centidegrees& temperature, Centipercent& humidity)
+{
+    int32_t adc_T = (data[0] << 12) | (data[1] << NIBBLE_BITS) | (data[2] >> NIBBLE_BITS);
+    int32_t adc_H = (data[3] << BITS_IN_BYTE) | data[4];
+    if (adc_T == SKIPPED_TEMPERATURE || adc_H == SKIPPED_HUMIDITY) {
+        return false;
+    }
+
+    // The compensation below follows section 4.2.3 of the datasheet, and yields the temperature in hundredths directly.
+    int32_t var1 = ((((adc_T >> 3) - (static_cast<int32_t>(calibration.dig_T1) << 1))) * calibration.dig_T2) >> 11;
+    int32_t var2 = (((((adc_T >> 4) - calibration.dig_T1) * ((adc_T >> 4) - calibration.dig_T1)) >> 12) * calibration.dig_T3) >> 14;
+    int32_t t_fine = var1 + var2;
+    temperature = static_cast<Centidegrees>((t_fine * 5 + 128) >> 8);
+
+    int32_t h = t_fine - 76800;
+    h = (((((adc_H << 14) - (static_cast<int32_t>(calibration.dig_H4) << 20) - (calibration.dig_H5 * h)) + 16384) >> 15)
+         * (((((((h * calibration.dig_H6) >> 10) * (((h * calibration.dig_H3) >> 11) + 32768)) >> 10) + 2097152) * calibration.dig_H2
+             + 8192)
+            >> 14));
+    h = h - (((((h >> 15) * (h >> 15)) >> 7) * calibration.dig_H1) >> 4);
+    h = h < 0 ? 0 : h;
+    h = h > MAXIMUM_HUMIDITY_Q22_10 ? MAXIMUM_HUMIDITY_Q22_10 : h;
+
+    // h is now the humidity in Q22.10 format, scaled up by 2^12.
+    uint32_t humidity_q22_10 = static_cast<uint32_t>(h) >> 12;
+    humidity = static_cast<Centipercent>((humidity_q22_10 * CENTI_PER_UNIT) >> HUMIDITY_FRACTION_BITS);
+    return true;
+}
+} // namespace sensors
@@ -0,0 +1,82 @@
+/*------------------------------------------------------------------------------
+Copyright (c) 2023 Joe Porembski
+SPDX-License-Identifier: BSD-3-Clause
+------------------------------------------------------------------------------*/
+#pragma once
+
+#include "sensors/detail/i2c-transfer.hpp"
+#include "measurement.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+
+namespace sensors {
+/**
+ * Describes the Bosch BME280 environmental sensor, for use with I2CSensor.
+ *
+ * Each read is a forced mode measurement of temperature and humidity with 1x oversampling. Pressure is not measured.
+ *
+ * @note See https://www.bosch-sensortec.com/media/boschsensortec/downloads/datasheets/bst-bme280-ds002.pdf
+ */
+struct BME280
+{
+    /** Human readable name of the sensor. */
+    static constexpr std::string_view NAME = "BME280";
+
+    /** The I2C address of the sensor with its SDO pin pulled low. */
+    static constexpr uint8_t DEFAULT_ADDRESS = 0x76;
+
+    /** Writes ctrl_meas to start a forced mode measurement of temperature, skipping pressure. */
+    static constexpr std::array<uint8_t, 2> TRIGGER_COMMAND = {0xF4, 0x21};
+
+    /** Selects the first temperature data register. */
+    static constexpr std::array<uint8_t, 1> FETCH_COMMAND = {0xFA};
+
+    /** The number of bytes in a measurement: temperature (3), humidity (2). */
+    static constexpr size_t RESPONSE_SIZE = 5;
+
+    /** The longest time a measurement can take at the configured oversampling, in milliseconds. */
+    static constexpr uint32_t CONVERSION_TIME_MS = 10;
+
+    /** The shortest time between reads which avoids heating the sensor, in milliseconds. */
+    static constexpr uint32_t MINIMUM_READ_PERIOD_MS = 1000;
+
+    /** The factory trimming parameters used to compensate each measurement. */
+    struct Calibration
+    {
+        uint16_t dig_T1;
+        int16_t dig_T2;
+        int16_t dig_T3;
+        uint8_t dig_H1;
+        int16_t dig_H2;
+        uint8_t dig_H3;
+        int16_t dig_H4;
+        int16_t dig_H5;
+        int8_t dig_H6;
+    };
+
+    /**
+     * Verifies the sensor's identity, reads its calibration and configures humidity oversampling.
+     *
+     * @param[in] transfer The I2C bus the sensor is on.
+     * @param[in] address The I2C address of the sensor.
+     * @param[out] calibration The calibration read from the sensor.
+     * @return True if the sensor was set up, false otherwise.
+     */
+    static bool initialize(detail::I2CTransfer& transfer, uint8_t address, Calibration& calibration);
+
+    /**
+     * Decodes and compensates a measurement, using the integer compensation formulas from the datasheet.
+     *
+     * @param[in] data The RESPONSE_SIZE bytes read from the sensor.
+     * @param[in] calibration The calibration read from the sensor.
+     * @param[out] temperature The temperature in hundredths of a degree Celsius.
+     * @param[out] humidity The humidity in hundredths of a percent.
+     * @return True if the measurement is valid, false if the sensor skipped it.
+     */
+    static bool decode(const uint8_t* data, const Calibration& calibration, Centidegrees& temperature, Centipercent& humidity);
+};
+} // namespace sensors
@@ -7,22 +7,96 @@ SPDX-License-Identifier: BSD-3-Clause
 #include "sensors/constants.hpp"
 
 #include <hardware/adc.h>
+#include <pico/stdio.h>
 
+#include <algorithm>
 #include <cstddef>
 #include <cstdint>
+#include <cstdio>
 
 
 namespace sensors {
-inline constexpr uint8_t CPU_TEMP_ADC_PIN = 4;
+inline constexpr uint8_t CPU_TEMP_ADC_INPUT = 4;
+inline constexpr uint8_t ADC_PIN_COUNT = 4;
+inline constexpr int64_t ADC_VREF_10UV = 330000;
+inline constexpr int64_t ADC_VREF_MV = 3300;
+inline constexpr uint8_t AVERAGE_RESOLUTION = ADC_RESOLUTION + detail::ADCSampler::OVERSAMPLE_BITS;
+inline constexpr int32_t TEMP_SENSOR_REFERENCE = toCenti(27);
+inline constexpr int32_t TEMP_SENSOR_REFERENCE_10UV = 70600;
+inline constexpr int32_t TEMP_SENSOR_SLOPE_UV = 1721;
+inline constexpr int32_t UV_PER_10UV = 10;
 
-Board::Board()
-{}
+/**
+ * @param[in] adc_pin A GPIO pin.
+ * @return True if @a adc_pin is wired to the ADC, false otherwise.
+ */
+static bool isADCPin(uint8_t adc_pin)
+{
+    return adc_pin >= GPIO_PIN_OFFSET && adc_pin < GPIO_PIN_OFFSET + ADC_PIN_COUNT;
+}
+
+Board::Board(uint8_t battery_adc_pin) : _sampler(), _battery_adc_pin(battery_adc_pin)
+{
+    uint8_t input_mask = 1 << CPU_TEMP_ADC_INPUT;
+    if (isADCPin(_battery_adc_pin)) {
+        adc_gpio_init(_battery_adc_pin);
+        input_mask |= 1 << (_battery_adc_pin - GPIO_PIN_OFFSET);
+    }
+    else {
+        printf("Battery monitoring disabled, ADC PIN %u is invalid\n", _battery_adc_pin);
+    }
+
+    if (!_sampler.start(input_mask)) {
+        printf("Failed to start ADC sampling\n");
+    }
+}
 
-float Board::temperature() const
+Centidegrees Board::temperature() const
 {
-    adc_set_temp_sensor_enabled(true);
-    adc_select_input(CPU_TEMP_ADC_PIN);
-    float adc = adc_read() * ADC_CONVERSION_FACTOR;
-    return 27.0f - (adc - 0.706f) / 0.001721f;
+    uint32_t average = 0;
+    if (!_sampler.average(CPU_TEMP_ADC_INPUT, average)) {
+        return DEFAULT_TEMPERATURE;
+    }
+
+    // See section 4.9.5 of the RP2040 datasheet: T = 27 - (V - 0.706) / 0.001721
+    // Voltages are kept in units of 10 uV, which keeps full precision while fitting in 32 bits.
+    int32_t voltage = static_cast<int32_t>((average * ADC_VREF_10UV) >> AVERAGE_RESOLUTION);
+    int32_t offset = (voltage - TEMP_SENSOR_REFERENCE_10UV) * UV_PER_10UV;
+    return static_cast<Centidegrees>(TEMP_SENSOR_REFERENCE - (offset * CENTI_PER_UNIT) / TEMP_SENSOR_SLOPE_UV);
+}
+
+bool Board::hasBattery() const
+{
+    return isADCPin(_battery_adc_pin);
+}
+
+int32_t Board::batteryVoltage() const
+{
+    int32_t pin_voltage = 0;
+    if (!voltage(_battery_adc_pin, pin_voltage)) {
+        return 0;
+    }
+    return pin_voltage * BATTERY_DIVIDER_RATIO;
+}
+
+Centipercent Board::batteryLevel() const
+{
+    if (!hasBattery()) {
+        return 0;
+    }
+
+    int32_t charge = std::clamp(batteryVoltage(), EMPTY_BATTERY_VOLTAGE_MV, FULL_BATTERY_VOLTAGE_MV) - EMPTY_BATTERY_VOLTAGE_MV;
+    return static_cast<Centipercent>((charge * toCenti(PERCENT_FACTOR)) / (FULL_BATTERY_VOLTAGE_MV - EMPTY_BATTERY_VOLTAGE_MV));
+}
+
+bool Board::voltage(uint8_t adc_pin, int32_t& voltage) const
+{
+    uint32_t average = 0;
+    if (!isADCPin(adc_pin) || !_sampler.average(adc_pin - GPIO_PIN_OFFSET, average)) {
+        return false;
+    }
+
+    voltage = static_cast<int32_t>((average * ADC_VREF_MV) >> AVERAGE_RESOLUTION);
+    return true;
 }
 } // namespace sensors
@@ -4,6 +4,9 @@ SPDX-License-Identifier: BSD-3-Clause
 ------------------------------------------------------------------------------*/
 #pragma once
 
+#include "sensors/detail/adc-sampler.hpp"
+#include "measurement.hpp"
+
 #include <cstddef>
 #include <cstdint>
 
@@ -11,16 +14,53 @@ SPDX-License-Identifier: BSD-3-Clause
 namespace sensors {
 /**
  * Internal sensors provided by the Pico Hardware.
+ *
+ * The ADC inputs are sampled continuously in the background (see detail::ADCSampler), so every reading is the latest
+ * filtered value and returns without touching the ADC.
  */
 class Board
 {
 public:
-    /** Constructor. */
-    Board();
+    /**
+     * Constructor.
+     *
+     * @note adc_init() must have been called.
+     * @param[in] battery_adc_pin The ADC pin (26-29) wired to the battery through a divider of BATTERY_DIVIDER_RATIO. A
+     * value outside of that range disables battery monitoring.
+     */
+    explicit Board(uint8_t battery_adc_pin);
+
+    /**
+     * @return The board temperature in hundredths of a degree Celsius.
+     */
+    Centidegrees temperature() const;
+
+    /**
+     * @return True if the battery is monitored, false otherwise.
+     */
+    bool hasBattery() const;
+
+    /**
+     * @return The battery voltage in millivolts, or 0 if the battery is not monitored.
+     */
+    int32_t batteryVoltage() const;
 
     /**
-     * @return The board temperature in degrees Celsius.
+     * @return The remaining battery charge in hundredths of a percent, or 0 if the battery is not monitored.
      */
-    float temperature() const;
+    Centipercent batteryLevel() const;
+
+    /**
+     * Gets the voltage on an ADC pin.
+     *
+     * @param[in] adc_pin The ADC pin (26-29).
+     * @param[out] voltage The voltage in millivolts.
+     * @return True if @a adc_pin is sampled and has a value, false otherwise.
+     */
+    bool voltage(uint8_t adc_pin, int32_t& voltage) const;
+
+private:
+    detail::ADCSampler _sampler;
+    uint8_t _battery_adc_pin;
 };
 } // namespace sensors
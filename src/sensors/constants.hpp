@@ -5,14 +5,26 @@ SPDX-License-Identifier: BSD-3-Clause
 #pragma once
 
 #include "gpio.hpp"
+#include "measurement.hpp"
 
-#include <cfloat>
 #include <climits>
 #include <cstdint>
 
 
-inline constexpr float DEFAULT_HUMIDITY = FLT_MIN;
-inline constexpr float DEFAULT_TEMPERATURE = FLT_MIN;
-inline constexpr float FULL_BATTERY_VOLTAGE = 4.2f;
-inline constexpr float EMPTY_BATTERY_VOLTAGE = 2.8f;
+inline constexpr Centipercent DEFAULT_HUMIDITY = 0;
+inline constexpr Centidegrees DEFAULT_TEMPERATURE = 0;
+inline constexpr int32_t FULL_BATTERY_VOLTAGE_MV = 4200;
+inline constexpr int32_t EMPTY_BATTERY_VOLTAGE_MV = 2800;
+inline constexpr int32_t BATTERY_DIVIDER_RATIO = 3;
 inline constexpr uint8_t PERCENT_FACTOR = 100;
+inline constexpr uint32_t DHT_START_PULSE_US = 20000;
+inline constexpr uint32_t DHT_PIO_CAPTURE_WINDOW_MS = (DHT_START_PULSE_US / 1000) + 10;
+inline constexpr uint32_t SENSOR_I2C_BAUDRATE = 100 * 1000;
+inline constexpr int32_t TEMPERATURE_MAX_RATE = toCenti(1);
+inline constexpr int32_t HUMIDITY_MAX_RATE = toCenti(2);
+/**
+ * The weight of each reading in the moving average, 1/2. As the average steps once per reading, it settles to 63% of a
+ * step in about 1.4 control periods: 3 s with a DHT22, read every 2 s.
+ */
+inline constexpr uint8_t SAMPLE_EWMA_SHIFT = 1;
+inline constexpr uint32_t SAMPLE_MAX_AGE_MS = 60 * 1000;
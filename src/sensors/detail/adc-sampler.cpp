@@ -0,0 +1,158 @@
+/*------------------------------------------------------------------------------
+Copyright (c) 2023 Joe Porembski
+SPDX-License-Identifier: BSD-3-Clause
+------------------------------------------------------------------------------*/
+#include "sensors/detail/adc-sampler.hpp"
+
+#include <hardware/adc.h>
+#include <hardware/dma.h>
+#include <hardware/irq.h>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+
+namespace sensors::detail {
+inline constexpr int NO_CHANNEL = -1;
+inline constexpr uint8_t TEMPERATURE_SENSOR_INPUT = 4;
+inline constexpr float ADC_CLOCK_HZ = 48000000.0f;
+inline constexpr float SAMPLE_RATE_HZ = 10000.0f;
+inline constexpr uint8_t CYCLES_PER_SAMPLE = 1;
+
+static ADCSampler* active_sampler = nullptr;
+
+ADCSampler::ADCSampler()
+    : _buffers(),
+      _averages(),
+      _inputs(),
+      _channels({NO_CHANNEL, NO_CHANNEL}),
+      _input_count(0),
+      _sample_count(0),
+      _input_mask(0),
+      _ready_mask(0)
+{}
+
+ADCSampler::~ADCSampler()
+{
+    if (!running()) {
+        return;
+    }
+
+    adc_run(false);
+    for (int channel : _channels) {
+        dma_channel_set_irq1_enabled(channel, false);
+        dma_channel_abort(channel);
+        dma_channel_unclaim(channel);
+    }
+    irq_remove_handler(DMA_IRQ_1, _onBufferFull);
+    adc_fifo_drain();
+    active_sampler = nullptr;
+}
+
+bool ADCSampler::start(uint8_t input_mask)
+{
+    if (active_sampler != nullptr || input_mask == 0) {
+        return false;
+    }
+
+    _channels[0] = dma_claim_unused_channel(false);
+    _channels[1] = dma_claim_unused_channel(false);
+    if (_channels[0] == NO_CHANNEL || _channels[1] == NO_CHANNEL) {
+        if (_channels[0] != NO_CHANNEL) {
+            dma_channel_unclaim(_channels[0]);
+        }
+        _channels = {NO_CHANNEL, NO_CHANNEL};
+        return false;
+    }
+
+    // Round-robin mode visits the inputs in ascending order, starting at the selected one, so starting at the lowest
+    // input puts every sample at a known position in each buffer.
+    _input_mask = input_mask;
+    _input_count = 0;
+    for (uint8_t input = 0; input < INPUT_COUNT; input++) {
+        if (_input_mask & (1 << input)) {
+            _inputs[_input_count++] = input;
+        }
+    }
+    _sample_count = SAMPLES_PER_AVERAGE * _input_count;
+    active_sampler = this;
+
+    if (_input_mask & (1 << TEMPERATURE_SENSOR_INPUT)) {
+        adc_set_temp_sensor_enabled(true);
+    }
+    adc_select_input(_inputs[0]);
+    adc_set_round_robin(_input_mask);
+    adc_fifo_setup(true, true, 1, false, false);
+    adc_set_clkdiv(ADC_CLOCK_HZ / SAMPLE_RATE_HZ - CYCLES_PER_SAMPLE);
+
+    for (size_t index = 0; index < _channels.size(); index++) {
+        dma_channel_config config = dma_channel_get_default_config(_channels[index]);
+        channel_config_set_transfer_data_size(&config, DMA_SIZE_16);
+        channel_config_set_read_increment(&config, false);
+        channel_config_set_write_increment(&config, true);
+        channel_config_set_dreq(&config, DREQ_ADC);
+        channel_config_set_chain_to(&config, _channels[(index + 1) % _channels.size()]);
+        dma_channel_configure(_channels[index], &config, _buffers[index].data(), &adc_hw->fifo, _sample_count, false);
+        dma_channel_set_irq1_enabled(_channels[index], true);
+    }
+
+    irq_add_shared_handler(DMA_IRQ_1, _onBufferFull, PICO_SHARED_IRQ_HANDLER_DEFAULT_ORDER_PRIORITY);
+    irq_set_enabled(DMA_IRQ_1, true);
+
+    adc_fifo_drain();
+    dma_channel_start(_channels[0]);
+    adc_run(true);
+    return true;
+}
+
+bool ADCSampler::running() const
+{
+    return active_sampler == this;
+}
+
+bool ADCSampler::average(uint8_t input, uint32_t& average) const
+{
+    if (input >= INPUT_COUNT || !(_ready_mask & (1 << input))) {
+        return false;
+    }
+
+    average = _averages[input];
+    return true;
+}
+
+void ADCSampler::_onBufferFull()
+{
+    if (active_sampler == nullptr) {
+        return;
+    }
+
+    for (size_t index = 0; index < active_sampler->_channels.size(); index++) {
+        int channel = active_sampler->_channels[index];
+        if (dma_channel_get_irq1_status(channel)) {
+            dma_channel_acknowledge_irq1(channel);
+            active_sampler->_process(index);
+        }
+    }
+}
+
+void ADCSampler::_process(size_t index)
+{
+    std::array<uint32_t, INPUT_COUNT> sums = {};
+    const std::array<uint16_t, BUFFER_SIZE>& buffer = _buffers[index];
+    for (size_t sample = 0; sample < _sample_count; sample += _input_count) {
+        for (size_t slot = 0; slot < _input_count; slot++) {
+            sums[slot] += buffer[sample + slot];
+        }
+    }
+
+    // Summing 4^n samples and dividing by 2^n gains n bits of resolution over a single conversion.
+    for (size_t slot = 0; slot < _input_count; slot++) {
+        _averages[_inputs[slot]] = sums[slot] >> OVERSAMPLE_BITS;
+    }
+    _ready_mask = _input_mask;
+
+    // The other channel is already filling its buffer, so this one is re-armed to take over when that one completes.
+    dma_channel_set_write_addr(_channels[index], _buffers[index].data(), false);
+}
+} // namespace sensors::detail
@@ -0,0 +1,92 @@
+/*------------------------------------------------------------------------------
+Copyright (c) 2023 Joe Porembski
+SPDX-License-Identifier: BSD-3-Clause
+------------------------------------------------------------------------------*/
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+
+namespace sensors::detail {
+/**
+ * Samples a set of ADC inputs continuously in the background, keeping the latest average of each.
+ *
+ * The ADC free-runs in round-robin mode, and two chained DMA channels ping-pong its FIFO between a pair of buffers. Each
+ * time a buffer fills, an interrupt averages it down into one value per input while the other buffer fills, so reading
+ * the latest value never touches the ADC.
+ *
+ * @note There is only one ADC, so only one sampler can be running at a time.
+ */
+class ADCSampler
+{
+public:
+    /** The number of ADC inputs: GPIO 26-29 and the temperature sensor. */
+    static constexpr size_t INPUT_COUNT = 5;
+
+    /** The number of fractional bits gained by averaging, i.e. averages are in 1/16ths of an ADC count. */
+    static constexpr uint8_t OVERSAMPLE_BITS = 4;
+
+    /** Constructor. */
+    ADCSampler();
+
+    /** Destructor. */
+    ~ADCSampler();
+
+    ADCSampler(const ADCSampler&) = delete;
+    ADCSampler& operator=(const ADCSampler&) = delete;
+
+    /**
+     * Starts sampling the inputs in @a input_mask.
+     *
+     * @note adc_init() must have been called.
+     * @param[in] input_mask A bit mask of the ADC inputs to sample, i.e. bit 4 is the temperature sensor.
+     * @return True if sampling started, false if another sampler is running or no DMA channels are available.
+     */
+    bool start(uint8_t input_mask);
+
+    /**
+     * @return True if this is sampling, false otherwise.
+     */
+    bool running() const;
+
+    /**
+     * Gets the latest average of an input.
+     *
+     * @param[in] input The ADC input.
+     * @param[out] average The average in 1/16ths of an ADC count, i.e. scaled up by OVERSAMPLE_BITS.
+     * @return True if @a input is being sampled and has an average, false otherwise.
+     */
+    bool average(uint8_t input, uint32_t& average) const;
+
+private:
+    /** The number of samples averaged into each value. */
+    static constexpr size_t SAMPLES_PER_AVERAGE = 1 << (2 * OVERSAMPLE_BITS);
+
+    /** A buffer holds one average's worth of samples for every input. */
+    static constexpr size_t BUFFER_SIZE = SAMPLES_PER_AVERAGE * INPUT_COUNT;
+
+    /**
+     * Handler for the DMA interrupt raised when a buffer fills.
+     */
+    static void _onBufferFull();
+
+    /**
+     * Averages a full buffer, and re-arms its DMA channel.
+     *
+     * @note This is called from interrupt context.
+     * @param[in] index The index of the buffer which filled.
+     */
+    void _process(size_t index);
+
+    std::array<std::array<uint16_t, BUFFER_SIZE>, 2> _buffers;
+    std::array<volatile uint32_t, INPUT_COUNT> _averages;
+    std::array<uint8_t, INPUT_COUNT> _inputs;
+    std::array<int, 2> _channels;
+    size_t _input_count;
+    size_t _sample_count;
+    uint8_t _input_mask;
+    volatile uint8_t _ready_mask;
+};
+} // namespace sensors::detail
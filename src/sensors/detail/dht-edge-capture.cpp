@@ -0,0 +1,109 @@
+/*------------------------------------------------------------------------------
+Copyright (c) 2023 Joe Porembski
+SPDX-License-Identifier: BSD-3-Clause
+------------------------------------------------------------------------------*/
+#include "sensors/detail/dht-edge-capture.hpp"
+
+#include <hardware/gpio.h>
+#include <hardware/irq.h>
+#include <pico/time.h>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+
+namespace sensors::detail {
+inline constexpr uint32_t EDGE_EVENTS = GPIO_IRQ_EDGE_RISE | GPIO_IRQ_EDGE_FALL;
+
+static std::array<DHTEdgeCapture*, NUM_BANK0_GPIOS> edge_captures = {};
+
+DHTEdgeCapture::DHTEdgeCapture() : _edges(), _edge_count(0), _overrun(false), _data_pin(0), _attached(false)
+{}
+
+DHTEdgeCapture::~DHTEdgeCapture()
+{
+    if (!_attached) {
+        return;
+    }
+
+    disarm();
+    gpio_remove_raw_irq_handler(_data_pin, _onEdge);
+    edge_captures[_data_pin] = nullptr;
+}
+
+void DHTEdgeCapture::attach(uint8_t data_pin)
+{
+    if (_attached || data_pin >= NUM_BANK0_GPIOS) {
+        return;
+    }
+
+    _data_pin = data_pin;
+    _attached = true;
+    edge_captures[_data_pin] = this;
+    gpio_add_raw_irq_handler(_data_pin, _onEdge);
+    irq_set_enabled(IO_IRQ_BANK0, true);
+}
+
+void DHTEdgeCapture::arm()
+{
+    _edge_count = 0;
+    _overrun = false;
+    gpio_acknowledge_irq(_data_pin, EDGE_EVENTS);
+    gpio_set_irq_enabled(_data_pin, EDGE_EVENTS, true);
+}
+
+void DHTEdgeCapture::disarm()
+{
+    gpio_set_irq_enabled(_data_pin, EDGE_EVENTS, false);
+}
+
+bool DHTEdgeCapture::complete() const
+{
+    return _edge_count >= EXPECTED_EDGES;
+}
+
+bool DHTEdgeCapture::overrun() const
+{
+    return _overrun;
+}
+
+const DHTEdge* DHTEdgeCapture::edges() const
+{
+    return _edges.data();
+}
+
+size_t DHTEdgeCapture::edgeCount() const
+{
+    return _edge_count;
+}
+
+void DHTEdgeCapture::_onEdge()
+{
+    uint32_t now = time_us_32();
+    for (uint8_t pin = 0; pin < edge_captures.size(); pin++) {
+        DHTEdgeCapture* capture = edge_captures[pin];
+        if (capture == nullptr) {
+            continue;
+        }
+
+        uint32_t events = gpio_get_irq_event_mask(pin) & EDGE_EVENTS;
+        if (events != 0) {
+            gpio_acknowledge_irq(pin, events);
+            capture->_record(now, events);
+        }
+    }
+}
+
+void DHTEdgeCapture::_record(uint32_t time_us, uint32_t events)
+{
+    // Both events pending means the opposite transition was missed, and its order cannot be recovered.
+    if (events == EDGE_EVENTS || _edge_count >= _edges.size()) {
+        _overrun = true;
+        return;
+    }
+
+    _edges[_edge_count] = DHTEdge{time_us, (events & GPIO_IRQ_EDGE_RISE) != 0};
+    _edge_count = _edge_count + 1;
+}
+} // namespace sensors::detail
@@ -0,0 +1,97 @@
+/*------------------------------------------------------------------------------
+Copyright (c) 2023 Joe Porembski
+SPDX-License-Identifier: BSD-3-Clause
+------------------------------------------------------------------------------*/
+#pragma once
+
+#include "sensors/detail/dht-frame.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+
+namespace sensors::detail {
+/**
+ * Timestamps every transition of a DHT data line from the GPIO edge interrupt.
+ *
+ * Capture is armed while the host still holds the line low, so a full read is the rising edge as the host releases
+ * it, the response preamble (3 transitions), two transitions per data bit and the sensor's final release of the line,
+ * all of which fit in a fixed buffer so the interrupt never allocates.
+ */
+class DHTEdgeCapture
+{
+public:
+    static constexpr size_t MAX_EDGES = 96;
+
+    /** The number of transitions in a complete read. */
+    static constexpr size_t EXPECTED_EDGES = 1 + 3 + (2 * DHT_FRAME_BITS) + 1;
+
+    /** Constructor. */
+    DHTEdgeCapture();
+
+    /** Destructor. */
+    ~DHTEdgeCapture();
+
+    /**
+     * Registers the edge interrupt for @a data_pin on the calling core. Does nothing if already attached.
+     *
+     * @note arm() only enables the interrupt on the core it runs on, so this must be called from that same core.
+     * @param[in] data_pin The data pin of the DHT sensor.
+     */
+    void attach(uint8_t data_pin);
+
+    /**
+     * Clears any previous capture and starts timestamping transitions.
+     */
+    void arm();
+
+    /**
+     * Stops timestamping transitions.
+     */
+    void disarm();
+
+    /**
+     * @return True if all transitions of a read have been captured, false otherwise.
+     */
+    bool complete() const;
+
+    /**
+     * @return True if transitions were lost, either because the buffer filled or the interrupt was serviced late.
+     */
+    bool overrun() const;
+
+    /**
+     * @return The captured transitions.
+     */
+    const DHTEdge* edges() const;
+
+    /**
+     * @return The number of captured transitions.
+     */
+    size_t edgeCount() const;
+
+private:
+    DHTEdgeCapture(const DHTEdgeCapture&) = delete;
+    DHTEdgeCapture& operator=(const DHTEdgeCapture&) = delete;
+
+    /**
+     * Handler for the GPIO interrupt, shared by every capture.
+     */
+    static void _onEdge();
+
+    /**
+     * Records a transition.
+     *
+     * @param[in] time_us The time of the transition in microseconds.
+     * @param[in] events The GPIO events pending for the data pin.
+     */
+    void _record(uint32_t time_us, uint32_t events);
+
+    std::array<DHTEdge, MAX_EDGES> _edges;
+    volatile size_t _edge_count;
+    volatile bool _overrun;
+    uint8_t _data_pin;
+    bool _attached;
+};
+} // namespace sensors::detail
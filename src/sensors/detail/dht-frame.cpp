@@ -0,0 +1,196 @@
+/*------------------------------------------------------------------------------
+Copyright (c) 2023 Joe Porembski
+SPDX-License-Identifier: BSD-3-Clause
+------------------------------------------------------------------------------*/
+#include "sensors/detail/dht-frame.hpp"
+
+#include <algorithm>
+#include <array>
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+
+
+namespace sensors::detail {
+inline constexpr size_t PARITY_INDEX = DHT_FRAME_SIZE - 1;
+inline constexpr uint16_t NOMINAL_THRESHOLD_US = 48;
+inline constexpr uint16_t MINIMUM_CLUSTER_SEPARATION_US = 20;
+inline constexpr uint8_t CLUSTER_ITERATIONS = 4;
+
+using PulseWidths = std::array<uint16_t, DHT_FRAME_BITS>;
+
+/**
+ * Collects the widths of the last DHT_FRAME_BITS high pulses, in transmission order.
+ *
+ * @return The number of widths collected.
+ */
+static size_t collectHighPulses(const DHTEdge* edges, size_t edge_count, PulseWidths& widths)
+{
+    PulseWidths ring;
+    size_t pulse_count = 0;
+    const DHTEdge* rising_edge = nullptr;
+
+    for (size_t index = 0; index < edge_count; index++) {
+        if (edges[index].rising) {
+            rising_edge = &edges[index];
+            continue;
+        }
+
+        if (rising_edge != nullptr) {
+            ring[pulse_count % ring.size()] = static_cast<uint16_t>(edges[index].time_us - rising_edge->time_us);
+            pulse_count++;
+            rising_edge = nullptr;
+        }
+    }
+
+    if (pulse_count < widths.size()) {
+        return pulse_count;
+    }
+
+    // The response preamble also has a high pulse, so only the last DHT_FRAME_BITS pulses are data.
+    size_t oldest = pulse_count % ring.size();
+    for (size_t index = 0; index < widths.size(); index++) {
+        widths[index] = ring[(oldest + index) % ring.size()];
+    }
+    return widths.size();
+}
+
+/**
+ * Places the threshold between the two clusters of pulse widths using an iterative two-means split.
+ */
+static uint16_t findThreshold(const PulseWidths& widths)
+{
+    auto [shortest, longest] = std::minmax_element(widths.cbegin(), widths.cend());
+    if (*longest - *shortest < MINIMUM_CLUSTER_SEPARATION_US) {
+        // Every bit has the same value, so there is only one cluster to go on.
+        return NOMINAL_THRESHOLD_US;
+    }
+
+    uint16_t threshold = (*shortest + *longest) / 2;
+    for (uint8_t iteration = 0; iteration < CLUSTER_ITERATIONS; iteration++) {
+        uint32_t zero_sum = 0;
+        uint32_t zero_count = 0;
+        uint32_t one_sum = 0;
+        uint32_t one_count = 0;
+        for (uint16_t width : widths) {
+            if (width > threshold) {
+                one_sum += width;
+                one_count++;
+            }
+            else {
+                zero_sum += width;
+                zero_count++;
+            }
+        }
+
+        uint16_t next = static_cast<uint16_t>((zero_sum / zero_count + one_sum / one_count) / 2);
+        if (next == threshold) {
+            break;
+        }
+        threshold = next;
+    }
+    return threshold;
+}
+
+DHTFrameBuilder::DHTFrameBuilder() : _bits(0), _bit_count(0)
+{}
+
+size_t DHTFrameBuilder::bitCount() const
+{
+    return _bit_count;
+}
+
+bool DHTFrameBuilder::complete() const
+{
+    return _bit_count >= DHT_FRAME_BITS;
+}
+
+DHTFrame DHTFrameBuilder::frame() const
+{
+    // Left align whatever has been received so that a partial frame still lines up with the byte boundaries.
+    uint64_t bits = _bits;
+    if (_bit_count < DHT_FRAME_BITS) {
+        bits <<= (DHT_FRAME_BITS - _bit_count);
+    }
+
+    DHTFrame result;
+    for (size_t index = 0; index < result.size(); index++) {
+        size_t shift = (DHT_FRAME_SIZE - 1 - index) * CHAR_BIT;
+        result[index] = static_cast<uint8_t>(bits >> shift);
+    }
+    return result;
+}
+
+void DHTFrameBuilder::push(bool bit)
+{
+    push(static_cast<uint32_t>(bit), 1);
+}
+
+void DHTFrameBuilder::push(uint32_t word, uint8_t bit_count)
+{
+    for (uint8_t remaining = bit_count; remaining > 0 && _bit_count < DHT_FRAME_BITS; remaining--) {
+        _bits = (_bits << 1) | ((word >> (remaining - 1)) & 1);
+        _bit_count++;
+    }
+}
+
+void DHTFrameBuilder::reset()
+{
+    _bits = 0;
+    _bit_count = 0;
+}
+
+bool decode(const DHTEdge* edges, size_t edge_count, DHTFrameBuilder& builder, DHTTiming& timing)
+{
+    timing = DHTTiming{0, 0, 0, 0, static_cast<uint8_t>(std::min<size_t>(edge_count, UINT8_MAX))};
+
+    PulseWidths widths;
+    if (collectHighPulses(edges, edge_count, widths) < widths.size()) {
+        return false;
+    }
+
+    uint16_t threshold = findThreshold(widths);
+    uint32_t zero_sum = 0;
+    uint32_t zero_count = 0;
+    uint32_t one_sum = 0;
+    uint32_t one_count = 0;
+    uint16_t margin = UINT16_MAX;
+
+    builder.reset();
+    for (uint16_t width : widths) {
+        bool bit = width > threshold;
+        builder.push(bit);
+
+        if (bit) {
+            one_sum += width;
+            one_count++;
+            margin = std::min<uint16_t>(margin, width - threshold);
+        }
+        else {
+            zero_sum += width;
+            zero_count++;
+            margin = std::min<uint16_t>(margin, threshold - width);
+        }
+    }
+
+    timing.threshold_us = threshold;
+    timing.zero_mean_us = zero_count > 0 ? static_cast<uint16_t>(zero_sum / zero_count) : 0;
+    timing.one_mean_us = one_count > 0 ? static_cast<uint16_t>(one_sum / one_count) : 0;
+    timing.margin_us = margin;
+    return true;
+}
+
+bool hasValidParity(const DHTFrame& frame)
+{
+    return parity(frame) == frame[PARITY_INDEX];
+}
+
+uint8_t parity(const DHTFrame& frame)
+{
+    uint8_t result = 0;
+    for (size_t index = 0; index < PARITY_INDEX; index++) {
+        result += frame[index];
+    }
+    return result;
+}
+} // namespace sensors::detail
@@ -0,0 +1,131 @@
+/*------------------------------------------------------------------------------
+Copyright (c) 2023 Joe Porembski
+SPDX-License-Identifier: BSD-3-Clause
+------------------------------------------------------------------------------*/
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+
+namespace sensors::detail {
+inline constexpr size_t DHT_FRAME_SIZE = 5;
+inline constexpr size_t DHT_FRAME_BITS = 40;
+
+using DHTFrame = std::array<uint8_t, DHT_FRAME_SIZE>;
+
+/**
+ * A transition of the DHT data line.
+ */
+struct DHTEdge
+{
+    /** The time of the transition in microseconds. */
+    uint32_t time_us;
+
+    /** True if the line went high, false if it went low. */
+    bool rising;
+};
+
+/**
+ * Timing statistics of the bits in a single DHT frame.
+ */
+struct DHTTiming
+{
+    /** The pulse width separating a logical 0 from a logical 1 in this frame. */
+    uint16_t threshold_us;
+
+    /** The mean high time of the logical 0 bits. */
+    uint16_t zero_mean_us;
+
+    /** The mean high time of the logical 1 bits. */
+    uint16_t one_mean_us;
+
+    /** The distance between the threshold and the closest bit on either side of it. */
+    uint16_t margin_us;
+
+    /** The number of transitions seen on the data line. */
+    uint8_t edge_count;
+};
+
+/**
+ * Assembles a DHT data frame from the bits read off of the data line.
+ *
+ * Bits are provided MSB first, in the order they are transmitted by the sensor. This is shared by every capture
+ * method, so that a frame is built the same way regardless of how its bits were sampled.
+ *
+ * @note This has no dependencies on the Pico hardware.
+ */
+class DHTFrameBuilder
+{
+public:
+    /** Constructor. */
+    DHTFrameBuilder();
+
+    /**
+     * @return The number of bits added since the last reset.
+     */
+    size_t bitCount() const;
+
+    /**
+     * @return True if a full frame's worth of bits has been added, false otherwise.
+     */
+    bool complete() const;
+
+    /**
+     * @return The frame made up of the bits added so far. Missing bits are treated as 0.
+     */
+    DHTFrame frame() const;
+
+    /**
+     * Adds a single bit to the frame.
+     *
+     * @param[in] bit The value of the bit.
+     */
+    void push(bool bit);
+
+    /**
+     * Adds multiple bits to the frame.
+     *
+     * @param[in] word The bits to add, right aligned with the first transmitted bit being the most significant.
+     * @param[in] bit_count The number of bits in @a word to add.
+     */
+    void push(uint32_t word, uint8_t bit_count);
+
+    /**
+     * Clears all bits added to the frame.
+     */
+    void reset();
+
+private:
+    uint64_t _bits;
+    size_t _bit_count;
+};
+
+/**
+ * Decodes the bits of a frame from the transitions of the data line.
+ *
+ * Each bit is the width of a high pulse. Rather than comparing against a fixed width, the widths of a frame are split
+ * into two clusters and the threshold is placed midway between them, which tolerates the timing shifts caused by long
+ * cables and different sensor clones.
+ *
+ * @param[in] edges The transitions of the data line, in the order they occurred.
+ * @param[in] edge_count The number of transitions in @a edges.
+ * @param[out] builder The builder the decoded bits are pushed into.
+ * @param[out] timing The timing statistics of the decoded bits.
+ * @return True if a full frame was decoded, false otherwise.
+ */
+bool decode(const DHTEdge* edges, size_t edge_count, DHTFrameBuilder& builder, DHTTiming& timing);
+
+/**
+ * @param[in] frame The data frame read from the sensor.
+ * @return True if the parity byte of @a frame matches its data, false otherwise.
+ */
+bool hasValidParity(const DHTFrame& frame);
+
+/**
+ * @param[in] frame The data frame read from the sensor.
+ * @return The parity expected for the data in @a frame.
+ */
+uint8_t parity(const DHTFrame& frame);
+} // namespace sensors::detail
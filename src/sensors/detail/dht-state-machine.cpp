@@ -0,0 +1,174 @@
+/*------------------------------------------------------------------------------
+Copyright (c) 2023 Joe Porembski
+SPDX-License-Identifier: BSD-3-Clause
+------------------------------------------------------------------------------*/
+#include "sensors/detail/dht-state-machine.hpp"
+
+#include "generated/dht.pio.h"
+
+#include <hardware/gpio.h>
+#include <hardware/pio.h>
+#include <pico/stdio.h>
+
+#include <array>
+#include <cstdint>
+#include <cstdio>
+
+
+namespace sensors::detail {
+inline constexpr int8_t NO_STATE_MACHINE = -1;
+inline constexpr uint8_t PIO_WORD_BITS = 20;
+inline constexpr uint8_t PIO_WORDS_PER_FRAME = DHT_FRAME_BITS / PIO_WORD_BITS;
+inline constexpr size_t PIO_BLOCK_COUNT = 2;
+
+/**
+ * Book-keeping for the DHT program in each PIO block, so the program is only loaded once no matter how many sensors
+ * are in use.
+ */
+struct ProgramSlot
+{
+    PIO pio;
+    uint8_t offset;
+    uint8_t users;
+    bool loaded;
+};
+
+static std::array<ProgramSlot, PIO_BLOCK_COUNT> program_slots = {{
+    {pio0, 0, 0, false},
+    {pio1, 0, 0, false},
+}};
+
+static ProgramSlot* findSlot(PIO pio)
+{
+    for (auto& slot : program_slots) {
+        if (slot.pio == pio) {
+            return &slot;
+        }
+    }
+    return nullptr;
+}
+
+DHTStateMachine::DHTStateMachine() : _pio(nullptr), _sm(NO_STATE_MACHINE), _offset(0), _data_pin(0)
+{}
+
+DHTStateMachine::~DHTStateMachine()
+{
+    if (!claimed()) {
+        return;
+    }
+
+    stop();
+    pio_sm_unclaim(_pio, _sm);
+
+    ProgramSlot* slot = findSlot(_pio);
+    if (slot != nullptr && --slot->users == 0) {
+        pio_remove_program(_pio, &dht_program, slot->offset);
+        slot->loaded = false;
+    }
+}
+
+bool DHTStateMachine::claim(uint8_t data_pin)
+{
+    if (claimed()) {
+        return true;
+    }
+
+    for (auto& slot : program_slots) {
+        if (!slot.loaded && !pio_can_add_program(slot.pio, &dht_program)) {
+            continue;
+        }
+
+        int32_t sm = pio_claim_unused_sm(slot.pio, false);
+        if (sm < 0) {
+            continue;
+        }
+
+        if (!slot.loaded) {
+            slot.offset = static_cast<uint8_t>(pio_add_program(slot.pio, &dht_program));
+            slot.loaded = true;
+        }
+
+        slot.users++;
+        _pio = slot.pio;
+        _sm = static_cast<int8_t>(sm);
+        _offset = slot.offset;
+        _data_pin = data_pin;
+
+        pio_gpio_init(_pio, _data_pin);
+        gpio_pull_up(_data_pin);
+        dht_program_init(_pio, _sm, _offset, _data_pin);
+        return true;
+    }
+
+    printf("No PIO state machine available for DHT on %u\n", data_pin);
+    return false;
+}
+
+bool DHTStateMachine::claimed() const
+{
+    return _sm != NO_STATE_MACHINE;
+}
+
+bool DHTStateMachine::complete() const
+{
+    return pio_sm_get_rx_fifo_level(_pio, _sm) >= PIO_WORDS_PER_FRAME;
+}
+
+bool DHTStateMachine::responded() const
+{
+    // The program counter only passes the data label once the full response preamble has been seen.
+    uint8_t program_counter = pio_sm_get_pc(_pio, _sm) - _offset;
+    return program_counter >= dht_offset_data;
+}
+
+void DHTStateMachine::arm(uint32_t start_pulse_us)
+{
+    dht_program_init(_pio, _sm, _offset, _data_pin);
+    pio_sm_put(_pio, _sm, start_pulse_us);
+}
+
+void DHTStateMachine::enable()
+{
+    pio_sm_set_enabled(_pio, _sm, true);
+}
+
+void DHTStateMachine::start(uint32_t start_pulse_us)
+{
+    arm(start_pulse_us);
+    enable();
+}
+
+bool DHTStateMachine::collect(DHTFrame& frame)
+{
+    bool is_complete = complete();
+    stop();
+
+    if (!is_complete) {
+        return false;
+    }
+
+    DHTFrameBuilder builder;
+    for (uint8_t word = 0; word < PIO_WORDS_PER_FRAME; word++) {
+        builder.push(pio_sm_get(_pio, _sm), PIO_WORD_BITS);
+    }
+    frame = builder.frame();
+    return true;
+}
+
+void DHTStateMachine::stop()
+{
+    // Stopping part way through the start pulse would otherwise leave the data line driven low.
+    pio_sm_set_enabled(_pio, _sm, false);
+    pio_sm_set_consecutive_pindirs(_pio, _sm, _data_pin, 1, false);
+}
+
+PIO DHTStateMachine::pio() const
+{
+    return _pio;
+}
+
+uint8_t DHTStateMachine::index() const
+{
+    return static_cast<uint8_t>(_sm);
+}
+} // namespace sensors::detail
@@ -0,0 +1,106 @@
+/*------------------------------------------------------------------------------
+Copyright (c) 2023 Joe Porembski
+SPDX-License-Identifier: BSD-3-Clause
+------------------------------------------------------------------------------*/
+#pragma once
+
+#include "sensors/detail/dht-frame.hpp"
+
+#include <hardware/pio.h>
+
+#include <cstdint>
+
+
+namespace sensors::detail {
+/**
+ * A PIO state machine running the DHT program (see dht.pio) on a single data pin.
+ *
+ * The state machine generates the start pulse, waits out the sensor's response and captures all 40 bits of a frame
+ * into its RX FIFO, so the CPU is only needed to start a read and to collect the result.
+ */
+class DHTStateMachine
+{
+public:
+    /** Constructor. */
+    DHTStateMachine();
+
+    /** Destructor. */
+    ~DHTStateMachine();
+
+    /**
+     * Claims a state machine for @a data_pin, loading the DHT program into PIO memory if necessary.
+     *
+     * @param[in] data_pin The data pin of the DHT sensor.
+     * @return True if a state machine was claimed, false if no PIO resources are available.
+     */
+    bool claim(uint8_t data_pin);
+
+    /**
+     * @return True if this has claimed a state machine, false otherwise.
+     */
+    bool claimed() const;
+
+    /**
+     * @return True if the state machine has captured a full frame, false otherwise.
+     */
+    bool complete() const;
+
+    /**
+     * @return True if the sensor responded to the last start pulse, false otherwise.
+     */
+    bool responded() const;
+
+    /**
+     * Resets the state machine and queues up a read, without enabling it.
+     *
+     * This allows multiple state machines to be enabled in sync.
+     *
+     * @param[in] start_pulse_us The length of the start pulse in microseconds.
+     */
+    void arm(uint32_t start_pulse_us);
+
+    /**
+     * Enables the state machine, starting an armed read.
+     */
+    void enable();
+
+    /**
+     * Arms and enables the state machine, starting a read.
+     *
+     * @param[in] start_pulse_us The length of the start pulse in microseconds.
+     */
+    void start(uint32_t start_pulse_us);
+
+    /**
+     * Stops the state machine and collects the captured frame.
+     *
+     * @param[out] frame The frame captured by the state machine.
+     * @return True if a full frame was captured, false otherwise.
+     */
+    bool collect(DHTFrame& frame);
+
+    /**
+     * Stops the state machine, discarding any partial capture.
+     */
+    void stop();
+
+    /**
+     * @return The PIO block of the claimed state machine.
+     */
+    PIO pio() const;
+
+    /**
+     * @return The index of the claimed state machine within its PIO block.
+     */
+    uint8_t index() const;
+
+private:
+    DHTStateMachine(const DHTStateMachine&) = delete;
+    DHTStateMachine& operator=(const DHTStateMachine&) = delete;
+
+    PIO _pio;
+    int8_t _sm;
+    uint8_t _offset;
+    uint8_t _data_pin;
+};
+} // namespace sensors::detail
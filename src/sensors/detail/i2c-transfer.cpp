@@ -0,0 +1,190 @@
+/*------------------------------------------------------------------------------
+Copyright (c) 2023 Joe Porembski
+SPDX-License-Identifier: BSD-3-Clause
+------------------------------------------------------------------------------*/
+#include "sensors/detail/i2c-transfer.hpp"
+
+#include <hardware/dma.h>
+#include <hardware/gpio.h>
+#include <hardware/i2c.h>
+#include <pico/time.h>
+
+#include <cstddef>
+#include <cstdint>
+
+
+namespace sensors::detail {
+inline constexpr int NO_CHANNEL = -1;
+inline constexpr uint8_t PINS_PER_I2C_BLOCK = 2;
+inline constexpr uint8_t I2C_BLOCK_COUNT = 2;
+inline constexpr uint64_t TRANSACTION_TIMEOUT_US = 50000;
+
+I2CTransfer::I2CTransfer()
+    : _requests(),
+      _response(),
+      _i2c(nullptr),
+      _request_channel(NO_CHANNEL),
+      _response_channel(NO_CHANNEL),
+      _failed(false)
+{}
+
+I2CTransfer::~I2CTransfer()
+{
+    if (!claimed()) {
+        return;
+    }
+
+    dma_channel_abort(_request_channel);
+    dma_channel_abort(_response_channel);
+    dma_channel_unclaim(_request_channel);
+    dma_channel_unclaim(_response_channel);
+    i2c_deinit(_i2c);
+}
+
+bool I2CTransfer::claim(uint8_t sda_pin, uint8_t scl_pin, uint32_t baudrate)
+{
+    if (claimed()) {
+        return true;
+    }
+
+    _request_channel = dma_claim_unused_channel(false);
+    _response_channel = dma_claim_unused_channel(false);
+    if (_request_channel == NO_CHANNEL || _response_channel == NO_CHANNEL) {
+        if (_request_channel != NO_CHANNEL) {
+            dma_channel_unclaim(_request_channel);
+        }
+        _request_channel = NO_CHANNEL;
+        _response_channel = NO_CHANNEL;
+        return false;
+    }
+
+    // Each pair of GPIOs alternates between the two I2C blocks, i.e. GP4/GP5 are I2C0 and GP6/GP7 are I2C1.
+    _i2c = i2c_get_instance((sda_pin / PINS_PER_I2C_BLOCK) % I2C_BLOCK_COUNT);
+    i2c_init(_i2c, baudrate);
+    i2c_get_hw(_i2c)->dma_cr = I2C_IC_DMA_CR_TDMAE_BITS | I2C_IC_DMA_CR_RDMAE_BITS;
+
+    gpio_set_function(sda_pin, GPIO_FUNC_I2C);
+    gpio_set_function(scl_pin, GPIO_FUNC_I2C);
+    gpio_pull_up(sda_pin);
+    gpio_pull_up(scl_pin);
+    return true;
+}
+
+bool I2CTransfer::claimed() const
+{
+    return _request_channel != NO_CHANNEL;
+}
+
+bool I2CTransfer::busy() const
+{
+    // An aborted transaction is over, even though its DMA channels are left waiting on the flushed FIFOs.
+    if (!claimed() || _aborted()) {
+        return false;
+    }
+
+    if (dma_channel_is_busy(_request_channel) || dma_channel_is_busy(_response_channel)) {
+        return true;
+    }
+
+    // The last request may still be on the bus after the DMA channel has handed it over.
+    return i2c_get_hw(_i2c)->status & I2C_IC_STATUS_ACTIVITY_BITS;
+}
+
+bool I2CTransfer::failed() const
+{
+    return _failed || _aborted();
+}
+
+const uint8_t* I2CTransfer::response() const
+{
+    return _response.data();
+}
+
+bool I2CTransfer::start(uint8_t address, const uint8_t* command, size_t command_size, size_t response_size)
+{
+    if (!claimed() || command_size > MAX_COMMAND_SIZE || response_size > MAX_RESPONSE_SIZE || command_size + response_size == 0) {
+        return false;
+    }
+
+    _checkAbort();
+    if (busy()) {
+        return false;
+    }
+
+    // Each entry of the data command register is a byte to write, or a request to read a byte. The final entry ends the
+    // transaction with a STOP, and the first read after a write turns the bus around with a RESTART.
+    size_t request_count = 0;
+    for (size_t index = 0; index < command_size; index++) {
+        _requests[request_count++] = command[index];
+    }
+    for (size_t index = 0; index < response_size; index++) {
+        uint16_t request = I2C_IC_DATA_CMD_CMD_BITS;
+        if (index == 0 && command_size > 0) {
+            request |= I2C_IC_DATA_CMD_RESTART_BITS;
+        }
+        _requests[request_count++] = request;
+    }
+    _requests[request_count - 1] |= I2C_IC_DATA_CMD_STOP_BITS;
+
+    i2c_hw_t* hw = i2c_get_hw(_i2c);
+    hw->enable = 0;
+    hw->tar = address;
+    hw->enable = 1;
+    _failed = false;
+
+    if (response_size > 0) {
+        dma_channel_config config = dma_channel_get_default_config(_response_channel);
+        channel_config_set_transfer_data_size(&config, DMA_SIZE_8);
+        channel_config_set_read_increment(&config, false);
+        channel_config_set_write_increment(&config, true);
+        channel_config_set_dreq(&config, i2c_get_dreq(_i2c, false));
+        dma_channel_configure(_response_channel, &config, _response.data(), &hw->data_cmd, response_size, true);
+    }
+
+    dma_channel_config config = dma_channel_get_default_config(_request_channel);
+    channel_config_set_transfer_data_size(&config, DMA_SIZE_16);
+    channel_config_set_read_increment(&config, true);
+    channel_config_set_write_increment(&config, false);
+    channel_config_set_dreq(&config, i2c_get_dreq(_i2c, true));
+    dma_channel_configure(_request_channel, &config, &hw->data_cmd, _requests.data(), request_count, true);
+    return true;
+}
+
+bool I2CTransfer::run(uint8_t address, const uint8_t* command, size_t command_size, size_t response_size)
+{
+    if (!start(address, command, command_size, response_size)) {
+        return false;
+    }
+
+    absolute_time_t timeout = make_timeout_time_us(TRANSACTION_TIMEOUT_US);
+    while (busy() && !time_reached(timeout)) {
+        tight_loop_contents();
+    }
+    _checkAbort();
+
+    if (busy()) {
+        dma_channel_abort(_request_channel);
+        dma_channel_abort(_response_channel);
+        _failed = true;
+    }
+    return !_failed;
+}
+
+bool I2CTransfer::_aborted() const
+{
+    return claimed() && (i2c_get_hw(_i2c)->raw_intr_stat & I2C_IC_RAW_INTR_STAT_TX_ABRT_BITS);
+}
+
+void I2CTransfer::_checkAbort()
+{
+    if (!_aborted()) {
+        return;
+    }
+
+    // The controller flushes its FIFOs on an abort, so the DMA channels would wait forever on requests that never come.
+    static_cast<void>(i2c_get_hw(_i2c)->clr_tx_abrt);
+    dma_channel_abort(_request_channel);
+    dma_channel_abort(_response_channel);
+    _failed = true;
+}
+} // namespace sensors::detail
@@ -0,0 +1,111 @@
+/*------------------------------------------------------------------------------
+Copyright (c) 2023 Joe Porembski
+SPDX-License-Identifier: BSD-3-Clause
+------------------------------------------------------------------------------*/
+#pragma once
+
+#include <hardware/i2c.h>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+
+namespace sensors::detail {
+/**
+ * Runs I2C transactions through a pair of DMA channels, so the CPU is only needed to start a transaction and to
+ * collect the result.
+ *
+ * A transaction writes a command and then optionally reads a response. One channel feeds the command bytes and read
+ * requests into the I2C controller's data register, the other drains the received bytes into the response buffer.
+ */
+class I2CTransfer
+{
+public:
+    /** The largest command which can be written in one transaction. */
+    static constexpr size_t MAX_COMMAND_SIZE = 4;
+
+    /** The largest response which can be read in one transaction. */
+    static constexpr size_t MAX_RESPONSE_SIZE = 32;
+
+    /** Constructor. */
+    I2CTransfer();
+
+    /** Destructor. */
+    ~I2CTransfer();
+
+    I2CTransfer(const I2CTransfer&) = delete;
+    I2CTransfer& operator=(const I2CTransfer&) = delete;
+
+    /**
+     * Sets up the I2C controller wired to @a sda_pin and @a scl_pin, and claims the DMA channels.
+     *
+     * @param[in] sda_pin The I2C data pin.
+     * @param[in] scl_pin The I2C clock pin.
+     * @param[in] baudrate The I2C clock rate in Hz.
+     * @return True if the controller was set up, false if no DMA channels are available.
+     */
+    bool claim(uint8_t sda_pin, uint8_t scl_pin, uint32_t baudrate);
+
+    /**
+     * @return True if this has claimed the DMA channels, false otherwise.
+     */
+    bool claimed() const;
+
+    /**
+     * @return True if a transaction has been started and not yet completed, false otherwise.
+     */
+    bool busy() const;
+
+    /**
+     * @return True if the target did not acknowledge the last transaction, false otherwise.
+     */
+    bool failed() const;
+
+    /**
+     * @return The response read by the last transaction.
+     */
+    const uint8_t* response() const;
+
+    /**
+     * Starts a transaction.
+     *
+     * @param[in] address The 7-bit address of the target.
+     * @param[in] command The bytes to write to the target.
+     * @param[in] command_size The number of bytes in @a command.
+     * @param[in] response_size The number of bytes to read from the target after the command, may be 0.
+     * @return True if the transaction was started, false if one is in progress or the sizes are too large.
+     */
+    bool start(uint8_t address, const uint8_t* command, size_t command_size, size_t response_size);
+
+    /**
+     * Runs a transaction to completion.
+     *
+     * @note This blocks, and is intended for setting up a target before it is read in the background.
+     * @param[in] address The 7-bit address of the target.
+     * @param[in] command The bytes to write to the target.
+     * @param[in] command_size The number of bytes in @a command.
+     * @param[in] response_size The number of bytes to read from the target after the command, may be 0.
+     * @return True if the transaction completed and was acknowledged, false otherwise.
+     */
+    bool run(uint8_t address, const uint8_t* command, size_t command_size, size_t response_size);
+
+private:
+    /**
+     * @return True if the controller gave up on the last transaction, false otherwise.
+     */
+    bool _aborted() const;
+
+    /**
+     * Clears an aborted transaction, stopping the DMA channels left waiting on it.
+     */
+    void _checkAbort();
+
+    std::array<uint16_t, MAX_COMMAND_SIZE + MAX_RESPONSE_SIZE> _requests;
+    std::array<uint8_t, MAX_RESPONSE_SIZE> _response;
+    i2c_inst_t* _i2c;
+    int _request_channel;
+    int _response_channel;
+    bool _failed;
+};
+} // namespace sensors::detail
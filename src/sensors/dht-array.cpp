@@ -0,0 +1,190 @@
+/*------------------------------------------------------------------------------
+Copyright (c) 2023 Joe Porembski
+SPDX-License-Identifier: BSD-3-Clause
+------------------------------------------------------------------------------*/
+#include "sensors/dht-array.hpp"
+
+#include "sensors/constants.hpp"
+#include "sensors/detail/dht-frame.hpp"
+#include "utilities.hpp"
+
+#include <hardware/gpio.h>
+#include <hardware/pio.h>
+#include <pico/stdio.h>
+#include <pico/time.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+
+inline constexpr uint32_t READ_POLL_PERIOD_MS = 1;
+
+DHTArray::DHTArray(DHTType type, const std::vector<uint8_t>& data_pins, uint8_t feedback_led_pin)
+    : _sensors(),
+      _size(std::min(data_pins.size(), MAX_SENSORS)),
+      _type(type),
+      _feedback_led_pin(feedback_led_pin),
+      _busy(false),
+      _captured(false)
+{
+    if (_feedback_led_pin < NUM_BANK0_GPIOS) {
+        gpio_init(_feedback_led_pin);
+        gpio_set_dir(_feedback_led_pin, GPIO_OUT);
+        gpio_put(_feedback_led_pin, LOW);
+    }
+
+    if (data_pins.size() > MAX_SENSORS) {
+        printf("DHT array only supports %u sensors, %u provided\n", MAX_SENSORS, data_pins.size());
+    }
+
+    for (size_t index = 0; index < _size; index++) {
+        Sensor& sensor = _sensors[index];
+        sensor.frame = DHT::Frame();
+        sensor.status = DHTStatus::NO_RESPONSE;
+        sensor.temperature = DEFAULT_TEMPERATURE;
+        sensor.humidity = DEFAULT_HUMIDITY;
+        sensor.data_pin = data_pins[index];
+        sensor.state_machine.claim(sensor.data_pin);
+    }
+}
+
+size_t DHTArray::size() const
+{
+    return _size;
+}
+
+DHTType DHTArray::type() const
+{
+    return _type;
+}
+
+const DHT::Frame& DHTArray::frame(size_t index) const
+{
+    return _sensors[index].frame;
+}
+
+DHTStatus DHTArray::status(size_t index) const
+{
+    return _sensors[index].status;
+}
+
+Centidegrees DHTArray::temperature(size_t index) const
+{
+    return _sensors[index].temperature;
+}
+
+Centipercent DHTArray::humidity(size_t index) const
+{
+    return _sensors[index].humidity;
+}
+
+bool DHTArray::busy() const
+{
+    return _busy;
+}
+
+bool DHTArray::beginRead()
+{
+    if (_busy) {
+        return false;
+    }
+
+    // Arm every state machine first, then enable each PIO block's state machines with a single write.
+    uint32_t pio0_mask = 0;
+    uint32_t pio1_mask = 0;
+    for (size_t index = 0; index < _size; index++) {
+        auto& state_machine = _sensors[index].state_machine;
+        if (!state_machine.claimed()) {
+            continue;
+        }
+
+        state_machine.arm(DHT_START_PULSE_US);
+        if (state_machine.pio() == pio0) {
+            pio0_mask |= (1u << state_machine.index());
+        }
+        else {
+            pio1_mask |= (1u << state_machine.index());
+        }
+    }
+
+    _setLED(ON);
+    _busy = true;
+    _captured = false;
+    pio_enable_sm_mask_in_sync(pio0, pio0_mask);
+    pio_enable_sm_mask_in_sync(pio1, pio1_mask);
+
+    alarm_id_t alarm = alarm_pool_add_alarm_in_ms(controlAlarmPool(), DHT_PIO_CAPTURE_WINDOW_MS, _onCaptureComplete, this, true);
+    if (alarm < 0) {
+        printf("No alarm available for DHT array\n");
+        _captured = true;
+    }
+    return true;
+}
+
+bool DHTArray::poll()
+{
+    if (!_busy || !_captured) {
+        return false;
+    }
+
+    for (size_t index = 0; index < _size; index++) {
+        _collect(_sensors[index]);
+    }
+
+    _setLED(OFF);
+    _busy = false;
+    return true;
+}
+
+void DHTArray::read()
+{
+    if (!beginRead()) {
+        return;
+    }
+
+    while (!poll()) {
+        sleep_ms(READ_POLL_PERIOD_MS);
+    }
+}
+
+int64_t DHTArray::_onCaptureComplete(alarm_id_t /* unused */, void* user_data)
+{
+    static_cast<DHTArray*>(user_data)->_captured = true;
+    return 0;
+}
+
+void DHTArray::_collect(Sensor& sensor)
+{
+    if (!sensor.state_machine.claimed()) {
+        sensor.status = DHTStatus::NO_RESPONSE;
+        return;
+    }
+
+    bool responded = sensor.state_machine.responded();
+    if (!sensor.state_machine.collect(sensor.frame)) {
+        sensor.status = responded ? DHTStatus::TIMEOUT : DHTStatus::NO_RESPONSE;
+        printf("DHT on %u did not send a full frame\n", sensor.data_pin);
+        return;
+    }
+
+    if (!sensors::detail::hasValidParity(sensor.frame)) {
+        sensor.status = DHTStatus::PARITY_FAILURE;
+        printf("DHT on %u failed its parity check\n", sensor.data_pin);
+        return;
+    }
+
+    sensor.status = DHTStatus::OK;
+    DHT::parse(_type, sensor.frame, sensor.temperature, sensor.humidity);
+}
+
+void DHTArray::_setLED(uint8_t state) const
+{
+    if (_feedback_led_pin >= NUM_BANK0_GPIOS) {
+        return;
+    }
+
+    gpio_put(_feedback_led_pin, state);
+}
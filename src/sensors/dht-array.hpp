@@ -0,0 +1,146 @@
+/*------------------------------------------------------------------------------
+Copyright (c) 2023 Joe Porembski
+SPDX-License-Identifier: BSD-3-Clause
+------------------------------------------------------------------------------*/
+#pragma once
+
+#include "sensors/detail/dht-state-machine.hpp"
+#include "sensors/dht.hpp"
+#include "measurement.hpp"
+
+#include <pico/time.h>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+
+/**
+ * A group of DHT sensors of the same type, such as one per bay of a multi-bay dryer, read at the same time.
+ *
+ * Every sensor gets its own PIO state machine, and all state machines are started in sync, so a read of the whole
+ * array takes as long as a read of a single sensor.
+ */
+class DHTArray
+{
+public:
+    /**
+     * The maximum number of sensors: the two PIO blocks have 8 state machines between them, the wireless driver's SPI bus
+     * takes one, and a DHT measuring the container another.
+     */
+    static constexpr size_t MAX_SENSORS = 6;
+
+    /**
+     * Constructor.
+     *
+     * @note Pins beyond MAX_SENSORS are ignored.
+     * @param[in] type The type of every sensor in the array.
+     * @param[in] data_pins The data pins of the DHT sensors, one per sensor.
+     * @param[in] feedback_led_pin The pin of the LED to toggle on/off. If provided, the LED will be on when data is being read from the
+     * sensors, and off otherwise.
+     */
+    DHTArray(DHTType type, const std::vector<uint8_t>& data_pins, uint8_t feedback_led_pin);
+
+    /**
+     * @return The number of sensors in the array.
+     */
+    size_t size() const;
+
+    /**
+     * @return The type of every sensor in the array.
+     */
+    DHTType type() const;
+
+    /**
+     * @param[in] index The index of the sensor, in the order its data pin was provided.
+     * @return The data frame most recently read from the sensor.
+     */
+    const DHT::Frame& frame(size_t index) const;
+
+    /**
+     * @param[in] index The index of the sensor, in the order its data pin was provided.
+     * @return The outcome of the most recent read of the sensor.
+     */
+    DHTStatus status(size_t index) const;
+
+    /**
+     * @param[in] index The index of the sensor, in the order its data pin was provided.
+     * @return The measured temperature in hundredths of a degree Celsius.
+     */
+    Centidegrees temperature(size_t index) const;
+
+    /**
+     * @param[in] index The index of the sensor, in the order its data pin was provided.
+     * @return The measured humidity in hundredths of a percent.
+     */
+    Centipercent humidity(size_t index) const;
+
+    /**
+     * @return True if a read has been started and not yet completed, false otherwise.
+     */
+    bool busy() const;
+
+    /**
+     * Starts reading every sensor in the array, without waiting for the read to complete.
+     *
+     * @return True if the read was started, false if a read is already in progress.
+     */
+    bool beginRead();
+
+    /**
+     * Completes a read started by beginRead() once its capture window has closed.
+     *
+     * @return True if a read was completed by this call, and every sensor's measurements and status updated, false otherwise.
+     */
+    bool poll();
+
+    /**
+     * Reads every sensor in the array, waiting for the read to complete.
+     */
+    void read();
+
+private:
+    /**
+     * The state of a single sensor in the array.
+     */
+    struct Sensor
+    {
+        sensors::detail::DHTStateMachine state_machine;
+        DHT::Frame frame;
+        DHTStatus status;
+        Centidegrees temperature;
+        Centipercent humidity;
+        uint8_t data_pin;
+    };
+
+    /**
+     * Handler for the alarm closing the capture window.
+     *
+     * @param[in] id The alarm ID.
+     * @param[in] user_data The DHT array being read.
+     * @return Always 0, the alarm does not repeat.
+     */
+    static int64_t _onCaptureComplete(alarm_id_t id, void* user_data);
+
+    /**
+     * Collects the frame captured for @a sensor and updates its measurements.
+     *
+     * @param[in] sensor The sensor to collect.
+     */
+    void _collect(Sensor& sensor);
+
+    /**
+     * Sets the LED to the value indicated by @a state.
+     *
+     * @param[in] state The desired state of the LED.
+     */
+    void _setLED(uint8_t state) const;
+
+    std::array<Sensor, MAX_SENSORS> _sensors;
+    size_t _size;
+    DHTType _type;
+    uint8_t _feedback_led_pin;
+    volatile bool _busy;
+    volatile bool _captured;
+};
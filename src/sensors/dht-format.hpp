@@ -0,0 +1,96 @@
+/*------------------------------------------------------------------------------
+Copyright (c) 2023 Joe Porembski
+SPDX-License-Identifier: BSD-3-Clause
+------------------------------------------------------------------------------*/
+#pragma once
+
+#include "sensors/detail/dht-frame.hpp"
+#include "measurement.hpp"
+
+#include <cstddef>
+#include <cstdint>
+
+
+/**
+ * Enumerates the types of DHT sensors supported.
+ */
+enum class DHTType : uint8_t
+{
+    /** DHT 11 type sensor. */
+    DHT11,
+
+    /** DHT 21 type sensor. */
+    DHT21,
+
+    /** DHT 22 type sensor. */
+    DHT22
+};
+
+/**
+ * Describes the data format of a DHT sensor, resolved at compile time from its type.
+ *
+ * DHT21/22 sensors report 16-bit values in tenths, with the sign of the temperature in the top bit. DHT11 sensors report
+ * whole units in the first byte of each value.
+ *
+ * @tparam TYPE The type of sensor.
+ */
+template <DHTType TYPE>
+struct DHTFormat
+{
+    /** True if values span both bytes, false if only the first byte is used. */
+    static constexpr bool WIDE_VALUES = TYPE != DHTType::DHT11;
+
+    /** The number of hundredths per count of a raw value. */
+    static constexpr int32_t DATA_FACTOR = WIDE_VALUES ? CENTI_PER_UNIT / 10 : CENTI_PER_UNIT;
+
+    /** The shortest time between reads supported by the sensor, in milliseconds. */
+    static constexpr uint32_t MINIMUM_READ_PERIOD_MS = TYPE == DHTType::DHT11 ? 1000 : 2000;
+
+    /** The largest humidity the sensor can report, in hundredths of a percent. */
+    static constexpr int32_t MAXIMUM_HUMIDITY = toCenti(100);
+
+    /** The largest temperature the sensor can report, in hundredths of a degree Celsius. */
+    static constexpr int32_t MAXIMUM_TEMPERATURE = toCenti(125);
+
+    /**
+     * Parses a data frame into a temperature and humidity.
+     *
+     * @param[in] data The data frame read from the sensor.
+     * @param[out] temperature The temperature in hundredths of a degree Celsius.
+     * @param[out] humidity The humidity in hundredths of a percent.
+     */
+    static void parse(const sensors::detail::DHTFrame& data, Centidegrees& temperature, Centipercent& humidity)
+    {
+        constexpr size_t HUMIDITY_MSB_INDEX = 0;
+        constexpr size_t HUMIDITY_LSB_INDEX = 1;
+        constexpr size_t TEMP_MSB_INDEX = 2;
+        constexpr size_t TEMP_LSB_INDEX = 3;
+        constexpr uint8_t SIGN_BIT = 0x80;
+        constexpr uint8_t BITS_PER_BYTE = 8;
+
+        int32_t parsed_humidity = data[HUMIDITY_MSB_INDEX];
+        int32_t parsed_temperature = data[TEMP_MSB_INDEX] & ~SIGN_BIT;
+        if constexpr (WIDE_VALUES) {
+            parsed_humidity = (parsed_humidity << BITS_PER_BYTE) + data[HUMIDITY_LSB_INDEX];
+            parsed_temperature = (parsed_temperature << BITS_PER_BYTE) + data[TEMP_LSB_INDEX];
+        }
+        parsed_humidity *= DATA_FACTOR;
+        parsed_temperature *= DATA_FACTOR;
+
+        // A DHT11 wired up as a DHT22 reports values out of range, so fall back to the whole units in the first byte.
+        if (parsed_humidity > MAXIMUM_HUMIDITY) {
+            parsed_humidity = toCenti(data[HUMIDITY_MSB_INDEX]);
+        }
+
+        if (parsed_temperature > MAXIMUM_TEMPERATURE) {
+            parsed_temperature = toCenti(data[TEMP_MSB_INDEX]);
+        }
+
+        if (data[TEMP_MSB_INDEX] & SIGN_BIT) {
+            parsed_temperature = -1 * parsed_temperature;
+        }
+
+        humidity = static_cast<Centipercent>(parsed_humidity);
+        temperature = static_cast<Centidegrees>(parsed_temperature);
+    }
+};
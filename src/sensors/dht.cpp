@@ -14,26 +14,75 @@ SPDX-License-Identifier: BSD-3-Clause
 #include <pico/types.h>
 
 #include <array>
-#include <cfloat>
-#include <chrono>
 #include <cstdint>
 #include <cstdio>
-#include <thread>
 
 
-inline constexpr size_t HUMIDITY_MSB_INDEX = 0;
-inline constexpr size_t HUMIDITY_LSB_INDEX = 1;
-inline constexpr size_t TEMP_MSB_INDEX = 2;
-inline constexpr size_t TEMP_LSB_INDEX = 3;
 inline constexpr size_t PARITY_INDEX = 4;
-inline constexpr float DATA_FACTOR = 10.0;
+inline constexpr uint32_t US_PER_MS = 1000;
 inline constexpr uint64_t MAX_WAIT_TIME_US = 100;
 inline constexpr uint64_t LOGICAL_ZERO_THRESHOLD_US = 40;
 inline constexpr uint64_t READ_REQUEST_LOW_TIME_MS = 20;
 inline constexpr uint64_t READ_REQUEST_HIGH_TIME_US = 30;
+inline constexpr uint32_t EDGE_CAPTURE_TIMEOUT_MS = 10;
+inline constexpr uint32_t READ_POLL_PERIOD_MS = 1;
 
-DHT::DHT(DHTType type, uint8_t data_pin, uint8_t feedback_led_pin)
-    : _humidity(DEFAULT_HUMIDITY), _temperature(DEFAULT_TEMPERATURE), _type(type), _data_pin(data_pin), _feedback_led_pin(feedback_led_pin)
+DHT::DHT(DHTType type, uint8_t data_pin, uint8_t feedback_led_pin) : DHT(type, data_pin, feedback_led_pin, DHTCapture::SOFTWARE)
+{}
+
+/**
+ * @param[in] type The type of sensor.
+ * @return The parser for frames sent by a sensor of @a type.
+ */
+static DHT::Parser parserFor(DHTType type)
+{
+    switch (type) {
+    case DHTType::DHT11:
+        return &DHTFormat<DHTType::DHT11>::parse;
+    case DHTType::DHT21:
+        return &DHTFormat<DHTType::DHT21>::parse;
+    case DHTType::DHT22:
+    default:
+        return &DHTFormat<DHTType::DHT22>::parse;
+    }
+}
+
+/**
+ * @param[in] type The type of sensor.
+ * @return The shortest time between reads supported by a sensor of @a type, in milliseconds.
+ */
+static uint32_t minimumReadPeriodFor(DHTType type)
+{
+    switch (type) {
+    case DHTType::DHT11:
+        return DHTFormat<DHTType::DHT11>::MINIMUM_READ_PERIOD_MS;
+    case DHTType::DHT21:
+        return DHTFormat<DHTType::DHT21>::MINIMUM_READ_PERIOD_MS;
+    case DHTType::DHT22:
+    default:
+        return DHTFormat<DHTType::DHT22>::MINIMUM_READ_PERIOD_MS;
+    }
+}
+
+DHT::DHT(DHTType type, uint8_t data_pin, uint8_t feedback_led_pin, DHTCapture capture)
+    : DHT(type, parserFor(type), minimumReadPeriodFor(type), data_pin, feedback_led_pin, capture)
+{}
+
+DHT::DHT(DHTType type, Parser parser, uint32_t minimum_read_period_ms, uint8_t data_pin, uint8_t feedback_led_pin, DHTCapture capture)
+    : _humidity(DEFAULT_HUMIDITY),
+      _temperature(DEFAULT_TEMPERATURE),
+      _type(type),
+      _parser(parser),
+      _minimum_read_period_ms(minimum_read_period_ms),
+      _capture(capture),
+      _status(DHTStatus::OK),
+      _state(ReadState::IDLE),
+      _frame(),
+      _timing(),
+      _data_pin(data_pin),
+      _feedback_led_pin(feedback_led_pin),
+      _state_machine(),
+      _edge_capture()
 {
     if (_feedback_led_pin < NUM_BANK0_GPIOS) {
         gpio_init(_feedback_led_pin);
@@ -44,27 +93,195 @@ DHT::DHT(DHTType type, uint8_t data_pin, uint8_t feedback_led_pin)
         printf("DHT Feedback disabled, LED PIN %u is invalid\n", _feedback_led_pin);
     }
 
-    gpio_init(_data_pin);
+    if (_capture == DHTCapture::PIO && !_state_machine.claim(_data_pin)) {
+        printf("DHT on %u falling back to software capture\n", _data_pin);
+        _capture = DHTCapture::SOFTWARE;
+    }
+
+    if (_capture == DHTCapture::SOFTWARE) {
+        gpio_init(_data_pin);
+    }
+
+    if (_capture == DHTCapture::EDGE_IRQ) {
+        gpio_init(_data_pin);
+        gpio_pull_up(_data_pin);
+    }
+}
+
+void DHT::parse(DHTType type, const Frame& data, Centidegrees& temperature, Centipercent& humidity)
+{
+    parserFor(type)(data, temperature, humidity);
 }
 
-float DHT::temperature() const
+Centidegrees DHT::temperature() const
 {
     return _temperature;
 }
 
-float DHT::humidity() const
+Centipercent DHT::humidity() const
 {
     return _humidity;
 }
 
+bool DHT::valid() const
+{
+    return _status == DHTStatus::OK;
+}
+
+uint32_t DHT::minimumReadPeriod() const
+{
+    return _minimum_read_period_ms;
+}
+
 DHTType DHT::type() const
 {
     return _type;
 }
 
+DHTCapture DHT::capture() const
+{
+    return _capture;
+}
+
+DHTStatus DHT::status() const
+{
+    return _status;
+}
+
+const DHT::Timing& DHT::timing() const
+{
+    return _timing;
+}
+
+bool DHT::busy() const
+{
+    return _state != ReadState::IDLE;
+}
+
+bool DHT::beginRead()
+{
+    if (busy()) {
+        return false;
+    }
+
+    _setLED(ON);
+    switch (_capture) {
+    case DHTCapture::PIO:
+        // The state machine generates the start pulse itself, so the alarm only needs to close the capture window.
+        _state_machine.start(DHT_START_PULSE_US);
+        _state = ReadState::CAPTURING;
+        _schedule(DHT_PIO_CAPTURE_WINDOW_MS);
+        break;
+    case DHTCapture::EDGE_IRQ:
+        // The edge interrupt is enabled per core, and the capture is armed from the alarms of the core reading the sensor,
+        // which need not be the one that constructed it; attaching on the first read puts the handler on the same core.
+        _edge_capture.attach(_data_pin);
+        gpio_set_dir(_data_pin, GPIO_OUT);
+        gpio_put(_data_pin, LOW);
+        _state = ReadState::START_PULSE;
+        _schedule(READ_REQUEST_LOW_TIME_MS);
+        break;
+    case DHTCapture::SOFTWARE:
+    default:
+        _status = _captureSoftware(_frame);
+        _state = ReadState::CAPTURED;
+        break;
+    }
+    return true;
+}
+
+bool DHT::poll()
+{
+    if (_state != ReadState::CAPTURED) {
+        return false;
+    }
+
+    _finish();
+    _state = ReadState::IDLE;
+    return true;
+}
+
 void DHT::read()
 {
-    _read();
+    if (!beginRead()) {
+        return;
+    }
+
+    while (!poll()) {
+        sleep_ms(READ_POLL_PERIOD_MS);
+    }
+}
+
+int64_t DHT::_onAlarm(alarm_id_t /* unused */, void* user_data)
+{
+    return static_cast<DHT*>(user_data)->_advance();
+}
+
+int64_t DHT::_advance()
+{
+    switch (_state) {
+    case ReadState::START_PULSE:
+        // Releasing the line lets the pull-up take it high, and the sensor's first transition follows from there.
+        _edge_capture.arm();
+        gpio_set_dir(_data_pin, GPIO_IN);
+        _state = ReadState::CAPTURING;
+        return EDGE_CAPTURE_TIMEOUT_MS * US_PER_MS;
+    case ReadState::CAPTURING:
+        _state = ReadState::CAPTURED;
+        return 0;
+    case ReadState::IDLE:
+    case ReadState::CAPTURED:
+    default:
+        return 0;
+    }
+}
+
+DHTStatus DHT::_captureSoftware(Frame& data)
+{
+    _start();
+
+    if (!_checkResponse()) {
+        return DHTStatus::NO_RESPONSE;
+    }
+
+    sensors::detail::DHTFrameBuilder builder;
+    while (!builder.complete()) {
+        builder.push(_getDataBit());
+    }
+
+    data = builder.frame();
+    return DHTStatus::OK;
+}
+
+DHTStatus DHT::_collectEdges(Frame& data)
+{
+    _edge_capture.disarm();
+
+    if (_edge_capture.edgeCount() == 0) {
+        return DHTStatus::NO_RESPONSE;
+    }
+
+    if (_edge_capture.overrun()) {
+        printf("DHT on %u missed transitions\n", _data_pin);
+    }
+
+    sensors::detail::DHTFrameBuilder builder;
+    if (!sensors::detail::decode(_edge_capture.edges(), _edge_capture.edgeCount(), builder, _timing)) {
+        return DHTStatus::TIMEOUT;
+    }
+
+    data = builder.frame();
+    return DHTStatus::OK;
+}
+
+DHTStatus DHT::_collectPIO(Frame& data)
+{
+    bool responded = _state_machine.responded();
+    if (_state_machine.collect(data)) {
+        return DHTStatus::OK;
+    }
+
+    return responded ? DHTStatus::TIMEOUT : DHTStatus::NO_RESPONSE;
 }
 
 bool DHT::_checkResponse() const
@@ -110,72 +327,60 @@ bool DHT::_getDataBit() const
     return gpio_get(_data_pin);
 }
 
-uint8_t DHT::_getDataByte() const
-{
-    uint8_t data = 0;
-    for (size_t i = 0; i < BITS_IN_BYTE; i++) {
-        data <<= 1;
-        data |= _getDataBit();
-    }
-    return data;
-}
-
-void DHT::_parse(const Frame& data)
+void DHT::_finish()
 {
-    switch (_type) {
-    case DHTType::DHT11:
-        _humidity = static_cast<float>(data[HUMIDITY_MSB_INDEX]);
-        _temperature = static_cast<float>(data[TEMP_MSB_INDEX]);
+    switch (_capture) {
+    case DHTCapture::PIO:
+        _status = _collectPIO(_frame);
         break;
-    case DHTType::DHT21:
-    case DHTType::DHT22:
+    case DHTCapture::EDGE_IRQ:
+        _status = _collectEdges(_frame);
+        break;
+    case DHTCapture::SOFTWARE:
     default:
-        _humidity = ((data[HUMIDITY_MSB_INDEX] << BITS_IN_BYTE) + data[HUMIDITY_LSB_INDEX]) / DATA_FACTOR;
-        _temperature = (((data[TEMP_MSB_INDEX] & 0x7F) << BITS_IN_BYTE) + data[TEMP_LSB_INDEX]) / DATA_FACTOR;
+        // The frame and status were captured when the read began.
         break;
     }
 
-    if (_humidity > 100) {
-        _humidity = data[HUMIDITY_MSB_INDEX];
-    }
-
-    if (_temperature > 125) {
-        _temperature = data[TEMP_MSB_INDEX];
-    }
-
-    if (data[TEMP_MSB_INDEX] & 0x80) {
-        _temperature = -1 * _temperature;
-    }
-}
-
-void DHT::_read()
-{
-    Frame data;
-
-    _setLED(ON);
-    _start();
-
-    if (!_checkResponse()) {
+    if (_status == DHTStatus::NO_RESPONSE) {
         _setLED(OFF);
-        _temperature = DEFAULT_TEMPERATURE;
-        _humidity = DEFAULT_HUMIDITY;
         printf("DHT Sensor did not respond to reset\n");
         return;
     }
 
-    for (size_t index = 0; index < data.size(); index++) {
-        data[index] = _getDataByte();
+    if (_status == DHTStatus::TIMEOUT) {
+        _setLED(OFF);
+        printf("DHT Sensor did not send a full frame\n");
+        return;
     }
 
-    uint8_t calculated_parity = data[HUMIDITY_MSB_INDEX] + data[HUMIDITY_LSB_INDEX] + data[TEMP_MSB_INDEX] + data[TEMP_LSB_INDEX];
-    if (calculated_parity != data[PARITY_INDEX]) {
-        printf("DHT data parity check failed (%u != %u)\n", calculated_parity, data[PARITY_INDEX]);
+    if (!sensors::detail::hasValidParity(_frame)) {
+        printf("DHT data parity check failed (%u != %u)\n", sensors::detail::parity(_frame), _frame[PARITY_INDEX]);
+        _status = DHTStatus::PARITY_FAILURE;
         _setLED(OFF);
         return;
     }
 
+    if (_capture == DHTCapture::EDGE_IRQ) {
+        printf("DHT bit timing: threshold %uus, 0: %uus, 1: %uus, margin %uus\n",
+               _timing.threshold_us,
+               _timing.zero_mean_us,
+               _timing.one_mean_us,
+               _timing.margin_us);
+    }
+
     _setLED(OFF);
-    _parse(data);
+    _parser(_frame, _temperature, _humidity);
+}
+
+void DHT::_schedule(uint32_t delay_ms)
+{
+    alarm_id_t alarm = alarm_pool_add_alarm_in_ms(controlAlarmPool(), delay_ms, _onAlarm, this, true);
+    if (alarm < 0) {
+        // Without an alarm the read would never complete, so end it now and let it fail its checks.
+        printf("No alarm available for DHT on %u\n", _data_pin);
+        _state = ReadState::CAPTURED;
+    }
 }
 
 void DHT::_setLED(uint8_t state) const
@@ -4,24 +4,51 @@ SPDX-License-Identifier: BSD-3-Clause
 ------------------------------------------------------------------------------*/
 #pragma once
 
+#include "sensors/detail/dht-edge-capture.hpp"
+#include "sensors/detail/dht-frame.hpp"
+#include "sensors/detail/dht-state-machine.hpp"
+#include "sensors/dht-format.hpp"
+#include "sensors/environment-sensor.hpp"
+#include "measurement.hpp"
+
+#include <pico/time.h>
+
 #include <array>
 #include <cstddef>
 #include <cstdint>
 
 
 /**
- * Enumerates the types of DHT sensors supported.
+ * Enumerates the methods of capturing data from a DHT sensor.
+ */
+enum class DHTCapture : uint8_t
+{
+    /** The CPU bit-bangs the data line. */
+    SOFTWARE,
+
+    /** A PIO state machine captures the frame, leaving the CPU free during the transfer. */
+    PIO,
+
+    /** A GPIO interrupt timestamps each transition, and bits are classified with a threshold fitted to each frame. */
+    EDGE_IRQ
+};
+
+/**
+ * Enumerates the outcomes of reading a DHT sensor.
  */
-enum class DHTType : uint8_t
+enum class DHTStatus : uint8_t
 {
-    /** DHT 11 type sensor. */
-    DHT11,
+    /** The frame was read and passed its parity check. */
+    OK,
 
-    /** DHT 21 type sensor. */
-    DHT21,
+    /** The sensor did not respond to the start pulse. */
+    NO_RESPONSE,
 
-    /** DHT 22 type sensor. */
-    DHT22
+    /** The sensor responded, but a full frame was not received in time. */
+    TIMEOUT,
+
+    /** A full frame was received, but failed its parity check. */
+    PARITY_FAILURE
 };
 
 /**
@@ -29,12 +56,17 @@ enum class DHTType : uint8_t
  *
  * @note See https://www.waveshare.com/wiki/DHT22_Temperature-Humidity_Sensor
  */
-class DHT
+class DHT : public sensors::EnvironmentSensor
 {
 public:
-    static constexpr size_t FRAME_SIZE = 5;
+    static constexpr size_t FRAME_SIZE = sensors::detail::DHT_FRAME_SIZE;
+
+    using Frame = sensors::detail::DHTFrame;
 
-    using Frame = std::array<uint8_t, FRAME_SIZE>;
+    using Timing = sensors::detail::DHTTiming;
+
+    /** Parses a data frame into a temperature and humidity, see DHTFormat::parse(). */
+    using Parser = void (*)(const Frame&, Centidegrees&, Centipercent&);
 
     /**
      * Constructor.
@@ -47,55 +79,189 @@ public:
     DHT(DHTType type, uint8_t data_pin, uint8_t feedback_led_pin);
 
     /**
-     * @return The measured temperature in degrees Celsius.
+     * Constructor.
+     *
+     * @note If @a capture is DHTCapture::PIO and no PIO state machine is available, the sensor falls back to
+     * DHTCapture::SOFTWARE.
+     * @param[in] type The type of sensor.
+     * @param[in] data_pin The data pin of the DHT sensor.
+     * @param[in] feedback_led_pin The pin of the LED to toggle on/off. If provided, the LED will be on when data is being read from the
+     * sensor, and off otherwise.
+     * @param[in] capture The method used to capture data from the sensor.
      */
-    float temperature() const;
+    DHT(DHTType type, uint8_t data_pin, uint8_t feedback_led_pin, DHTCapture capture);
 
     /**
-     * @return The measured humidity as a percentage.
+     * Parses a data frame into a temperature and humidity.
+     *
+     * @note Where the type is known at compile time, prefer DHTFormat::parse().
+     * @param[in] type The type of sensor which sent @a data.
+     * @param[in] data The data frame read from the sensor.
+     * @param[out] temperature The temperature in hundredths of a degree Celsius.
+     * @param[out] humidity The humidity in hundredths of a percent.
      */
-    float humidity() const;
+    static void parse(DHTType type, const Frame& data, Centidegrees& temperature, Centipercent& humidity);
+
+    /**
+     * @return The measured temperature in hundredths of a degree Celsius.
+     */
+    Centidegrees temperature() const override;
+
+    /**
+     * @return The measured humidity in hundredths of a percent.
+     */
+    Centipercent humidity() const override;
+
+    /**
+     * @return True if the most recent read completed with DHTStatus::OK, false otherwise.
+     */
+    bool valid() const override;
+
+    /**
+     * @return The shortest time between reads supported by the sensor, in milliseconds.
+     */
+    uint32_t minimumReadPeriod() const override;
 
     /**
      * @return The type of DHT sensor.
      */
     DHTType type() const;
 
+    /**
+     * @return The method used to capture data from the sensor.
+     */
+    DHTCapture capture() const;
+
+    /**
+     * @return The outcome of the most recent read.
+     */
+    DHTStatus status() const;
+
+    /**
+     * @note Only available when using DHTCapture::EDGE_IRQ, otherwise all statistics are 0.
+     * @return The bit timing statistics of the most recent read.
+     */
+    const Timing& timing() const;
+
+    /**
+     * @return True if a read has been started and not yet completed, false otherwise.
+     */
+    bool busy() const override;
+
+    /**
+     * Starts reading the temperature and humidity from the sensor, without waiting for the read to complete.
+     *
+     * The start pulse and capture window are timed by alarms from the control alarm pool, so the caller is free to do other
+     * work until poll() reports completion.
+     *
+     * @note DHTCapture::SOFTWARE cannot capture in the background, so the read completes before this returns.
+     * @return True if the read was started, false if a read is already in progress.
+     */
+    bool beginRead() override;
+
+    /**
+     * Completes a read started by beginRead() once its capture window has closed.
+     *
+     * @return True if a read was completed by this call, and the measurements and status updated, false otherwise.
+     */
+    bool poll() override;
+
+    /**
+     * Reads the temperature and humidity from the sensor, waiting for the read to complete.
+     */
     void read();
 
+protected:
+    /**
+     * Constructor.
+     *
+     * @param[in] type The type of sensor.
+     * @param[in] parser The parser for frames sent by a sensor of @a type.
+     * @param[in] minimum_read_period_ms The shortest time between reads supported by the sensor, in milliseconds.
+     * @param[in] data_pin The data pin of the DHT sensor.
+     * @param[in] feedback_led_pin The pin of the LED to toggle on/off.
+     * @param[in] capture The method used to capture data from the sensor.
+     */
+    DHT(DHTType type, Parser parser, uint32_t minimum_read_period_ms, uint8_t data_pin, uint8_t feedback_led_pin, DHTCapture capture);
+
 private:
     /**
-     * Checks for the sensor's response indicating it is ready to be read from.
+     * Enumerates the stages of a read.
+     */
+    enum class ReadState : uint8_t
+    {
+        IDLE,
+        START_PULSE,
+        CAPTURING,
+        CAPTURED
+    };
+
+    /**
+     * Handler for the alarms which time each stage of a read.
      *
-     * @return true if the sensor is ready, false otherwise.
+     * @param[in] id The alarm ID.
+     * @param[in] user_data The DHT sensor being read.
+     * @return The time in microseconds until the alarm should fire again, or 0 if it should not.
      */
-    bool _checkResponse() const;
+    static int64_t _onAlarm(alarm_id_t id, void* user_data);
 
     /**
-     * Reads a bit from the sensor's data pin according to the protocol used by DHT sensors.
+     * Advances the read to its next stage.
      *
-     * @return true if the bit is high, false if the bit is low.
+     * @note This is called from interrupt context.
+     * @return The time in microseconds until the next stage, or 0 if there is no next stage.
      */
-    bool _getDataBit() const;
+    int64_t _advance();
+
+    /**
+     * Captures a data frame by bit-banging the data line.
+     *
+     * @param[out] data The data frame read from the sensor.
+     * @return The outcome of the capture.
+     */
+    DHTStatus _captureSoftware(Frame& data);
 
     /**
-     * Reads a byte from the sensor's data pin according to the protocol used by DHT sensors.
+     * Collects the data frame from the transitions timestamped during the capture window.
      *
-     * @return The byte read from the sensor.
+     * @param[out] data The data frame read from the sensor.
+     * @return The outcome of the capture.
      */
-    uint8_t _getDataByte() const;
+    DHTStatus _collectEdges(Frame& data);
 
     /**
-     * Parses the provided frame into a humidity and temperate.
+     * Collects the data frame from the PIO state machine.
      *
-     * @param[in] data The data frame read from the sensor
+     * @param[out] data The data frame read from the sensor.
+     * @return The outcome of the capture.
      */
-    void _parse(const Frame& data);
+    DHTStatus _collectPIO(Frame& data);
 
     /**
-     * Reads data from the sensor.
+     * Completes a read, validating and parsing the captured frame.
      */
-    void _read();
+    void _finish();
+
+    /**
+     * Schedules the next stage of a read.
+     *
+     * @param[in] delay_ms The time until the next stage in milliseconds.
+     */
+    void _schedule(uint32_t delay_ms);
+
+    /**
+     * Checks for the sensor's response indicating it is ready to be read from.
+     *
+     * @return true if the sensor is ready, false otherwise.
+     */
+    bool _checkResponse() const;
+
+    /**
+     * Reads a bit from the sensor's data pin according to the protocol used by DHT sensors.
+     *
+     * @return true if the bit is high, false if the bit is low.
+     */
+    bool _getDataBit() const;
 
     /**
      * Sets the LED to the value indicated by @a state.
@@ -109,9 +275,40 @@ private:
      */
     void _start();
 
-    float _humidity;
-    float _temperature;
+    Centipercent _humidity;
+    Centidegrees _temperature;
     DHTType _type;
+    Parser _parser;
+    uint32_t _minimum_read_period_ms;
+    DHTCapture _capture;
+    DHTStatus _status;
+    volatile ReadState _state;
+    Frame _frame;
+    Timing _timing;
     uint8_t _data_pin;
     uint8_t _feedback_led_pin;
+    sensors::detail::DHTStateMachine _state_machine;
+    sensors::detail::DHTEdgeCapture _edge_capture;
+};
+
+/**
+ * A DHT sensor whose type is fixed at compile time, so frames are parsed without dispatching on the type.
+ *
+ * @tparam TYPE The type of sensor.
+ */
+template <DHTType TYPE>
+class DHTSensor final : public DHT
+{
+public:
+    /**
+     * Constructor.
+     *
+     * @param[in] data_pin The data pin of the DHT sensor.
+     * @param[in] feedback_led_pin The pin of the LED to toggle on/off. If provided, the LED will be on when data is being read from the
+     * sensor, and off otherwise.
+     * @param[in] capture The method used to capture data from the sensor.
+     */
+    DHTSensor(uint8_t data_pin, uint8_t feedback_led_pin, DHTCapture capture)
+        : DHT(TYPE, &DHTFormat<TYPE>::parse, DHTFormat<TYPE>::MINIMUM_READ_PERIOD_MS, data_pin, feedback_led_pin, capture)
+    {}
 };
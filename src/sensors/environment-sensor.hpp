@@ -0,0 +1,62 @@
+/*------------------------------------------------------------------------------
+Copyright (c) 2023 Joe Porembski
+SPDX-License-Identifier: BSD-3-Clause
+------------------------------------------------------------------------------*/
+#pragma once
+
+#include "measurement.hpp"
+
+#include <cstdint>
+
+
+namespace sensors {
+/**
+ * The interface shared by all sensors which measure the temperature and humidity of the container.
+ *
+ * Reads are split into beginRead() and poll(), so the caller is free to do other work while a read completes.
+ */
+class EnvironmentSensor
+{
+public:
+    virtual ~EnvironmentSensor() = default;
+
+    /**
+     * @return The measured temperature in hundredths of a degree Celsius.
+     */
+    virtual Centidegrees temperature() const = 0;
+
+    /**
+     * @return The measured humidity in hundredths of a percent.
+     */
+    virtual Centipercent humidity() const = 0;
+
+    /**
+     * @return True if the most recent read succeeded, false otherwise.
+     */
+    virtual bool valid() const = 0;
+
+    /**
+     * @return The shortest time between the start of consecutive reads supported by the sensor, in milliseconds.
+     */
+    virtual uint32_t minimumReadPeriod() const = 0;
+
+    /**
+     * @return True if a read has been started and not yet completed, false otherwise.
+     */
+    virtual bool busy() const = 0;
+
+    /**
+     * Starts reading the temperature and humidity from the sensor, without waiting for the read to complete.
+     *
+     * @return True if the read was started, false if a read is already in progress.
+     */
+    virtual bool beginRead() = 0;
+
+    /**
+     * Advances a read started by beginRead().
+     *
+     * @return True if a read was completed by this call, and the measurements updated, false otherwise.
+     */
+    virtual bool poll() = 0;
+};
+} // namespace sensors
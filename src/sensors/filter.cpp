@@ -0,0 +1,124 @@
+/*------------------------------------------------------------------------------
+Copyright (c) 2023 Joe Porembski
+SPDX-License-Identifier: BSD-3-Clause
+------------------------------------------------------------------------------*/
+#include "sensors/filter.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+
+
+namespace sensors {
+inline constexpr uint32_t MS_PER_S = 1000;
+
+/** Allowance for sensor noise on top of the rate limit, so consecutive readings are never rejected for jitter alone. */
+inline constexpr int32_t NOISE_ALLOWANCE = 50;
+
+SampleFilter::SampleFilter(int32_t max_rate, uint8_t ewma_shift, uint32_t max_age_ms)
+    : _window(),
+      _window_count(0),
+      _window_index(0),
+      _average(0),
+      _max_rate(max_rate),
+      _ewma_shift(ewma_shift),
+      _consecutive_rejections(0),
+      _max_age_ms(max_age_ms),
+      _rejected_count(0),
+      _good_timepoint(0),
+      _sample{0, SampleQuality::INVALID, 0}
+{}
+
+const Sample& SampleFilter::sample() const
+{
+    return _sample;
+}
+
+uint32_t SampleFilter::rejectedCount() const
+{
+    return _rejected_count;
+}
+
+void SampleFilter::reset()
+{
+    _window_count = 0;
+    _window_index = 0;
+    _average = 0;
+    _consecutive_rejections = 0;
+    _sample = Sample{0, SampleQuality::INVALID, 0};
+}
+
+const Sample& SampleFilter::update(int16_t reading, bool valid, uint64_t timepoint)
+{
+    if (!valid) {
+        _hold(timepoint);
+        return _sample;
+    }
+
+    if (_window_count > 0) {
+        uint64_t elapsed_ms = timepoint - _good_timepoint;
+        int64_t allowed_change = (static_cast<int64_t>(_max_rate) * elapsed_ms) / MS_PER_S + NOISE_ALLOWANCE;
+        bool is_outlier = std::abs(static_cast<int32_t>(reading) - _median()) > allowed_change;
+
+        if (is_outlier && _consecutive_rejections + 1u < WINDOW_SIZE) {
+            _consecutive_rejections++;
+            _rejected_count++;
+            _hold(timepoint);
+            return _sample;
+        }
+
+        if (is_outlier) {
+            // The "outlier" has persisted for a full window, so this is a real change. Start over from it.
+            _window_count = 0;
+            _window_index = 0;
+        }
+    }
+
+    _consecutive_rejections = 0;
+    _window[_window_index] = reading;
+    _window_index = (_window_index + 1) % WINDOW_SIZE;
+    _window_count = std::min(_window_count + 1, WINDOW_SIZE);
+
+    // The average is kept scaled up by the EWMA weight, so the division does not throw away precision every update.
+    int32_t median = _median();
+    if (_window_count == 1) {
+        _average = median << _ewma_shift;
+    }
+    else {
+        _average += median - (_average >> _ewma_shift);
+    }
+
+    _good_timepoint = timepoint;
+    _sample = Sample{static_cast<int16_t>(_average >> _ewma_shift), SampleQuality::GOOD, 0};
+    return _sample;
+}
+
+void SampleFilter::_hold(uint64_t timepoint)
+{
+    if (_window_count == 0) {
+        _sample.quality = SampleQuality::INVALID;
+        return;
+    }
+
+    uint64_t age_ms = timepoint - _good_timepoint;
+    _sample.age_ms = static_cast<uint32_t>(std::min<uint64_t>(age_ms, UINT32_MAX));
+    _sample.quality = age_ms > _max_age_ms ? SampleQuality::INVALID : SampleQuality::STALE;
+}
+
+int32_t SampleFilter::_median() const
+{
+    // An insertion sort, which for a window this small is as quick as std::sort and needs no library code.
+    std::array<int16_t, WINDOW_SIZE> sorted = _window;
+    for (size_t index = 1; index < _window_count; index++) {
+        int16_t reading = sorted[index];
+        size_t position = index;
+        for (; position > 0 && sorted[position - 1] > reading; position--) {
+            sorted[position] = sorted[position - 1];
+        }
+        sorted[position] = reading;
+    }
+    return sorted[_window_count / 2];
+}
+} // namespace sensors
@@ -0,0 +1,93 @@
+/*------------------------------------------------------------------------------
+Copyright (c) 2023 Joe Porembski
+SPDX-License-Identifier: BSD-3-Clause
+------------------------------------------------------------------------------*/
+#pragma once
+
+#include "measurement.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+
+namespace sensors {
+/**
+ * Filters a stream of raw readings into samples tagged with their quality.
+ *
+ * Each accepted reading goes through a median-of-N window followed by an exponentially weighted moving average. Readings
+ * which moved further from the median of the window than the rate limit allows are rejected as outliers, unless they
+ * persist for a full window, in which case they are treated as a real step change. The median is used rather than the
+ * output, since the moving average lags a real change and would reject readings which follow it. All state is
+ * statically sized.
+ *
+ * The window and average count readings rather than time, so their time constants scale with how often update() is
+ * called: a step held back as an outlier is accepted after WINDOW_SIZE readings. The rate limit and maximum age are in
+ * real time, and do not.
+ */
+class SampleFilter
+{
+public:
+    /** The number of readings in the median window. */
+    static constexpr size_t WINDOW_SIZE = 5;
+
+    /**
+     * Constructor.
+     *
+     * @param[in] max_rate The largest believable change per second, in hundredths of the measured unit.
+     * @param[in] ewma_shift The weight of each new median in the moving average, as a power of two (i.e. 2 means 1/4).
+     * @param[in] max_age_ms How long the last good value may be held before the sample is invalid, in milliseconds.
+     */
+    SampleFilter(int32_t max_rate, uint8_t ewma_shift, uint32_t max_age_ms);
+
+    /**
+     * @return The current filtered sample.
+     */
+    const Sample& sample() const;
+
+    /**
+     * @return The number of readings rejected as outliers.
+     */
+    uint32_t rejectedCount() const;
+
+    /**
+     * Clears all readings, invalidating the sample.
+     */
+    void reset();
+
+    /**
+     * Adds a reading to the filter.
+     *
+     * @param[in] reading The raw reading, in hundredths of the measured unit.
+     * @param[in] valid False if the reading failed, in which case @a reading is ignored.
+     * @param[in] timepoint The time of the reading in milliseconds since boot.
+     * @return The updated sample.
+     */
+    const Sample& update(int16_t reading, bool valid, uint64_t timepoint);
+
+private:
+    /**
+     * Marks the sample as holding its last good value as of @a timepoint.
+     *
+     * @param[in] timepoint The current time in milliseconds since boot.
+     */
+    void _hold(uint64_t timepoint);
+
+    /**
+     * @return The median of the readings in the window.
+     */
+    int32_t _median() const;
+
+    std::array<int16_t, WINDOW_SIZE> _window;
+    size_t _window_count;
+    size_t _window_index;
+    int32_t _average;
+    int32_t _max_rate;
+    uint8_t _ewma_shift;
+    uint8_t _consecutive_rejections;
+    uint32_t _max_age_ms;
+    uint32_t _rejected_count;
+    uint64_t _good_timepoint;
+    Sample _sample;
+};
+} // namespace sensors
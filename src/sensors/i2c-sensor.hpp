@@ -0,0 +1,193 @@
+/*------------------------------------------------------------------------------
+Copyright (c) 2023 Joe Porembski
+SPDX-License-Identifier: BSD-3-Clause
+------------------------------------------------------------------------------*/
+#pragma once
+
+#include "sensors/constants.hpp"
+#include "sensors/detail/i2c-transfer.hpp"
+#include "sensors/environment-sensor.hpp"
+#include "measurement.hpp"
+
+#include <pico/stdio.h>
+#include <pico/time.h>
+
+#include <cstdint>
+#include <cstdio>
+
+
+namespace sensors {
+/**
+ * A temperature and humidity sensor on an I2C bus, with its protocol resolved at compile time from @a Chip.
+ *
+ * A read triggers a measurement, waits out the conversion time, then fetches and decodes the result. Each transfer runs
+ * through DMA, so beginRead() and poll() never wait on the bus.
+ *
+ * @tparam Chip Describes the sensor, see SHT3x and BME280.
+ */
+template <typename Chip>
+class I2CSensor final : public EnvironmentSensor
+{
+public:
+    /**
+     * Constructor.
+     *
+     * @param[in] sda_pin The I2C data pin.
+     * @param[in] scl_pin The I2C clock pin.
+     * @param[in] address The I2C address of the sensor.
+     */
+    I2CSensor(uint8_t sda_pin, uint8_t scl_pin, uint8_t address = Chip::DEFAULT_ADDRESS)
+        : _humidity(DEFAULT_HUMIDITY),
+          _temperature(DEFAULT_TEMPERATURE),
+          _address(address),
+          _initialized(false),
+          _valid(false),
+          _state(ReadState::IDLE),
+          _ready_time(),
+          _calibration(),
+          _transfer()
+    {
+        if (!_transfer.claim(sda_pin, scl_pin, SENSOR_I2C_BAUDRATE)) {
+            printf("%s on %u/%u has no DMA channels available\n", Chip::NAME.data(), sda_pin, scl_pin);
+            return;
+        }
+
+        _initialize();
+    }
+
+    Centidegrees temperature() const override
+    {
+        return _temperature;
+    }
+
+    Centipercent humidity() const override
+    {
+        return _humidity;
+    }
+
+    bool valid() const override
+    {
+        return _valid;
+    }
+
+    uint32_t minimumReadPeriod() const override
+    {
+        return Chip::MINIMUM_READ_PERIOD_MS;
+    }
+
+    bool busy() const override
+    {
+        return _state != ReadState::IDLE;
+    }
+
+    bool beginRead() override
+    {
+        if (busy()) {
+            return false;
+        }
+
+        // A sensor which was missing at boot may have been connected since.
+        if (!_initialized && !_initialize()) {
+            _state = ReadState::FAILED;
+            return true;
+        }
+
+        if (!_transfer.start(_address, Chip::TRIGGER_COMMAND.data(), Chip::TRIGGER_COMMAND.size(), 0)) {
+            _state = ReadState::FAILED;
+            return true;
+        }
+
+        _state = ReadState::TRIGGERING;
+        return true;
+    }
+
+    bool poll() override
+    {
+        switch (_state) {
+        case ReadState::TRIGGERING:
+            if (_transfer.busy()) {
+                return false;
+            }
+            if (_transfer.failed()) {
+                return _finish(false);
+            }
+            _ready_time = make_timeout_time_ms(Chip::CONVERSION_TIME_MS);
+            _state = ReadState::CONVERTING;
+            return false;
+        case ReadState::CONVERTING:
+            if (!time_reached(_ready_time)) {
+                return false;
+            }
+            if (!_transfer.start(_address, Chip::FETCH_COMMAND.data(), Chip::FETCH_COMMAND.size(), Chip::RESPONSE_SIZE)) {
+                return _finish(false);
+            }
+            _state = ReadState::FETCHING;
+            return false;
+        case ReadState::FETCHING:
+            if (_transfer.busy()) {
+                return false;
+            }
+            return _finish(!_transfer.failed() && Chip::decode(_transfer.response(), _calibration, _temperature, _humidity));
+        case ReadState::FAILED:
+            return _finish(false);
+        case ReadState::IDLE:
+        default:
+            return false;
+        }
+    }
+
+private:
+    /**
+     * Enumerates the stages of a read.
+     */
+    enum class ReadState : uint8_t
+    {
+        IDLE,
+        TRIGGERING,
+        CONVERTING,
+        FETCHING,
+        FAILED
+    };
+
+    /**
+     * Completes a read.
+     *
+     * @param[in] valid True if the measurements were updated, false if the read failed.
+     * @return True, since a read was completed.
+     */
+    bool _finish(bool valid)
+    {
+        if (!valid) {
+            printf("%s read failed\n", Chip::NAME.data());
+        }
+
+        _valid = valid;
+        _state = ReadState::IDLE;
+        return true;
+    }
+
+    /**
+     * Sets up the sensor.
+     *
+     * @return True if the sensor was set up, false otherwise.
+     */
+    bool _initialize()
+    {
+        _initialized = _transfer.claimed() && Chip::initialize(_transfer, _address, _calibration);
+        if (!_initialized) {
+            printf("Failed to initialize %s at address 0x%02x\n", Chip::NAME.data(), _address);
+        }
+        return _initialized;
+    }
+
+    Centipercent _humidity;
+    Centidegrees _temperature;
+    uint8_t _address;
+    bool _initialized;
+    bool _valid;
+    ReadState _state;
+    absolute_time_t _ready_time;
+    typename Chip::Calibration _calibration;
+    detail::I2CTransfer _transfer;
+};
+} // namespace sensors
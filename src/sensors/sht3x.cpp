@@ -0,0 +1,73 @@
+/*------------------------------------------------------------------------------
+Copyright (c) 2023 Joe Porembski
+SPDX-License-Identifier: BSD-3-Clause
+------------------------------------------------------------------------------*/
+#include "sensors/sht3x.hpp"
+
+#include "gpio.hpp"
+
+#include <pico/time.h>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+
+namespace sensors {
+inline constexpr std::array<uint8_t, 2> SOFT_RESET_COMMAND = {0x30, 0xA2};
+inline constexpr uint32_t SOFT_RESET_TIME_MS = 2;
+inline constexpr uint8_t CRC_POLYNOMIAL = 0x31;
+inline constexpr uint8_t CRC_INITIAL_VALUE = 0xFF;
+inline constexpr size_t TEMPERATURE_INDEX = 0;
+inline constexpr size_t HUMIDITY_INDEX = 3;
+inline constexpr size_t CRC_OFFSET = 2;
+inline constexpr int32_t RAW_FULL_SCALE = 65535;
+inline constexpr int32_t TEMPERATURE_OFFSET = toCenti(-45);
+inline constexpr int32_t TEMPERATURE_SPAN = toCenti(175);
+inline constexpr int32_t HUMIDITY_SPAN = toCenti(100);
+
+/**
+ * Calculates the CRC-8 the sensor appends to each 16-bit word.
+ *
+ * @param[in] data The two bytes of the word.
+ * @return The CRC of @a data.
+ */
+static uint8_t crc(const uint8_t* data)
+{
+    uint8_t value = CRC_INITIAL_VALUE;
+    for (size_t index = 0; index < CRC_OFFSET; index++) {
+        value ^= data[index];
+        for (uint32_t bit = 0; bit < BITS_IN_BYTE; bit++) {
+            value = (value & 0x80) ? (value << 1) ^ CRC_POLYNOMIAL : value << 1;
+        }
+    }
+    return value;
+}
+
+bool SHT3x::initialize(detail::I2CTransfer& transfer, uint8_t address, Calibration& calibration)
+{
+    static_cast<void>(calibration);
+    if (!transfer.run(address, SOFT_RESET_COMMAND.data(), SOFT_RESET_COMMAND.size(), 0)) {
+        return false;
+    }
+
+    sleep_ms(SOFT_RESET_TIME_MS);
+    return true;
+}
+
+bool SHT3x::decode(const uint8_t* data, const Calibration& calibration, Centidegrees& temperature, Centipercent& humidity)
+{
+    static_cast<void>(calibration);
+    const uint8_t* raw_temperature = data + TEMPERATURE_INDEX;
+    const uint8_t* raw_humidity = data + HUMIDITY_INDEX;
+    if (crc(raw_temperature) != raw_temperature[CRC_OFFSET] || crc(raw_humidity) != raw_humidity[CRC_OFFSET]) {
+        return false;
+    }
+
+    int32_t temperature_counts = (raw_temperature[0] << BITS_IN_BYTE) | raw_temperature[1];
+    int32_t humidity_counts = (raw_humidity[0] << BITS_IN_BYTE) | raw_humidity[1];
+    temperature = static_cast<Centidegrees>(TEMPERATURE_OFFSET + (TEMPERATURE_SPAN * temperature_counts) / RAW_FULL_SCALE);
+    humidity = static_cast<Centipercent>((HUMIDITY_SPAN * humidity_counts) / RAW_FULL_SCALE);
+    return true;
+}
+} // namespace sensors
@@ -0,0 +1,72 @@
+/*------------------------------------------------------------------------------
+Copyright (c) 2023 Joe Porembski
+SPDX-License-Identifier: BSD-3-Clause
+------------------------------------------------------------------------------*/
+#pragma once
+
+#include "sensors/detail/i2c-transfer.hpp"
+#include "measurement.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+
+namespace sensors {
+/**
+ * Describes the Sensirion SHT3x temperature and humidity sensor, for use with I2CSensor.
+ *
+ * Each read is a single-shot, high repeatability measurement without clock stretching.
+ *
+ * @note See https://sensirion.com/media/documents/213E6A3B/63A5A569/Datasheet_SHT3x_DIS.pdf
+ */
+struct SHT3x
+{
+    /** Human readable name of the sensor. */
+    static constexpr std::string_view NAME = "SHT3x";
+
+    /** The I2C address of the sensor with its ADDR pin pulled low. */
+    static constexpr uint8_t DEFAULT_ADDRESS = 0x44;
+
+    /** The command which starts a measurement. */
+    static constexpr std::array<uint8_t, 2> TRIGGER_COMMAND = {0x24, 0x00};
+
+    /** The command which precedes reading back a measurement, the SHT3x is read without one. */
+    static constexpr std::array<uint8_t, 0> FETCH_COMMAND = {};
+
+    /** The number of bytes in a measurement: temperature, CRC, humidity, CRC. */
+    static constexpr size_t RESPONSE_SIZE = 6;
+
+    /** The longest time a high repeatability measurement can take, in milliseconds. */
+    static constexpr uint32_t CONVERSION_TIME_MS = 16;
+
+    /** The shortest time between reads which avoids heating the sensor, in milliseconds. */
+    static constexpr uint32_t MINIMUM_READ_PERIOD_MS = 1000;
+
+    /** The SHT3x has no calibration data to read back. */
+    struct Calibration
+    {};
+
+    /**
+     * Resets the sensor.
+     *
+     * @param[in] transfer The I2C bus the sensor is on.
+     * @param[in] address The I2C address of the sensor.
+     * @param[out] calibration Unused.
+     * @return True if the sensor acknowledged the reset, false otherwise.
+     */
+    static bool initialize(detail::I2CTransfer& transfer, uint8_t address, Calibration& calibration);
+
+    /**
+     * Decodes a measurement.
+     *
+     * @param[in] data The RESPONSE_SIZE bytes read from the sensor.
+     * @param[in] calibration Unused.
+     * @param[out] temperature The temperature in hundredths of a degree Celsius.
+     * @param[out] humidity The humidity in hundredths of a percent.
+     * @return True if the measurement passed its CRC checks, false otherwise.
+     */
+    static bool decode(const uint8_t* data, const Calibration& calibration, Centidegrees& temperature, Centipercent& humidity);
+};
+} // namespace sensors
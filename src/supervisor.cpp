@@ -0,0 +1,216 @@
+/*------------------------------------------------------------------------------
+Copyright (c) 2023 Joe Porembski
+SPDX-License-Identifier: BSD-3-Clause
+------------------------------------------------------------------------------*/
+#include "supervisor.hpp"
+
+#include "utilities.hpp"
+
+#include <hardware/watchdog.h>
+#include <pico/platform.h>
+#include <pico/stdio.h>
+#include <pico/time.h>
+
+#include <array>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <string_view>
+
+
+namespace supervisor {
+inline constexpr uint32_t WATCHDOG_TIMEOUT_MS = 5000;
+inline constexpr int32_t SUPERVISOR_PERIOD_MS = 1000;
+
+inline constexpr uint32_t CORE0_STALL_TIMEOUT_MS = 30 * 1000;
+inline constexpr uint32_t CORE1_STALL_TIMEOUT_MS = 30 * 1000;
+inline constexpr std::array<uint32_t, CORE_COUNT> STALL_TIMEOUTS_MS = {CORE0_STALL_TIMEOUT_MS, CORE1_STALL_TIMEOUT_MS};
+
+/*
+ * The stall record lives in watchdog scratch registers 0-3; the pico-sdk uses 4-7 for watchdog_reboot().
+ *   0: STALL_RECORD_MAGIC, so a record is only trusted if the supervisor wrote it.
+ *   1: The stalled cores as a bit mask in bits 0-7, and the checkpoint of core N in bits 8N+8 to 8N+15.
+ *   2-3: The time since core 0 and core 1 last checked in, in milliseconds.
+ */
+inline constexpr uint8_t RECORD_MAGIC_REGISTER = 0;
+inline constexpr uint8_t RECORD_CORES_REGISTER = 1;
+inline constexpr uint8_t RECORD_TIME_REGISTER = 2;
+inline constexpr uint32_t STALL_RECORD_MAGIC = 0x5354414C;
+inline constexpr uint8_t BITS_PER_FIELD = 8;
+inline constexpr uint32_t FIELD_MASK = 0xFF;
+inline constexpr uint32_t MS_PER_SECOND = 1000;
+
+inline constexpr std::string_view CHECKPOINT_NONE = "none";
+inline constexpr std::string_view CHECKPOINT_WIFI_CONNECT = "wifi_connect";
+inline constexpr std::string_view CHECKPOINT_MQTT_CONNECT = "mqtt_connect";
+inline constexpr std::string_view CHECKPOINT_MQTT_SUBSCRIBE = "mqtt_subscribe";
+inline constexpr std::string_view CHECKPOINT_MQTT_PUBLISH = "mqtt_publish";
+inline constexpr std::string_view CHECKPOINT_COMMUNICATION_IDLE = "communication_idle";
+inline constexpr std::string_view CHECKPOINT_SENSOR_READ = "sensor_read";
+inline constexpr std::string_view CHECKPOINT_HEATER_UPDATE = "heater_update";
+inline constexpr std::string_view CHECKPOINT_CONTROL_IDLE = "control_idle";
+
+/**
+ * The progress of a single core, as seen by the supervisor.
+ */
+struct Heartbeat
+{
+    /** Incremented by the core at every check in. */
+    volatile uint32_t count;
+
+    /** The last checkpoint the core reached. */
+    volatile Checkpoint checkpoint;
+
+    /** The count when the supervisor last saw it change. */
+    uint32_t seen_count;
+
+    /** The time the supervisor last saw the count change, in milliseconds since boot. */
+    uint32_t seen_timepoint;
+};
+
+static std::array<Heartbeat, CORE_COUNT> heartbeats = {};
+static repeating_timer_t supervisor_timer;
+static std::string last_reset;
+
+std::string_view toString(Checkpoint checkpoint)
+{
+    switch (checkpoint) {
+    case Checkpoint::WIFI_CONNECT:
+        return CHECKPOINT_WIFI_CONNECT;
+    case Checkpoint::MQTT_CONNECT:
+        return CHECKPOINT_MQTT_CONNECT;
+    case Checkpoint::MQTT_SUBSCRIBE:
+        return CHECKPOINT_MQTT_SUBSCRIBE;
+    case Checkpoint::MQTT_PUBLISH:
+        return CHECKPOINT_MQTT_PUBLISH;
+    case Checkpoint::COMMUNICATION_IDLE:
+        return CHECKPOINT_COMMUNICATION_IDLE;
+    case Checkpoint::SENSOR_READ:
+        return CHECKPOINT_SENSOR_READ;
+    case Checkpoint::HEATER_UPDATE:
+        return CHECKPOINT_HEATER_UPDATE;
+    case Checkpoint::CONTROL_IDLE:
+        return CHECKPOINT_CONTROL_IDLE;
+    case Checkpoint::NONE:
+    default:
+        return CHECKPOINT_NONE;
+    }
+}
+
+/**
+ * Writes a record of the stalled cores to the watchdog scratch registers.
+ *
+ * @param[in] stalled_cores A bit mask of the stalled cores.
+ * @param[in] timepoint The current time in milliseconds since boot.
+ */
+static void recordStall(uint32_t stalled_cores, uint32_t timepoint)
+{
+    uint32_t cores = stalled_cores;
+    for (uint8_t core = 0; core < CORE_COUNT; core++) {
+        cores |= static_cast<uint32_t>(heartbeats[core].checkpoint) << (BITS_PER_FIELD * (core + 1));
+        watchdog_hw->scratch[RECORD_TIME_REGISTER + core] = timepoint - heartbeats[core].seen_timepoint;
+    }
+    watchdog_hw->scratch[RECORD_CORES_REGISTER] = cores;
+    watchdog_hw->scratch[RECORD_MAGIC_REGISTER] = STALL_RECORD_MAGIC;
+}
+
+/**
+ * Reads the record left by the supervisor before the last reset, if there is one, then clears it.
+ *
+ * @return A description of the last reset.
+ */
+static std::string readLastReset()
+{
+    if (!watchdog_caused_reboot()) {
+        return "power on";
+    }
+
+    if (watchdog_hw->scratch[RECORD_MAGIC_REGISTER] != STALL_RECORD_MAGIC) {
+        return "watchdog";
+    }
+
+    watchdog_hw->scratch[RECORD_MAGIC_REGISTER] = 0;
+    uint32_t cores = watchdog_hw->scratch[RECORD_CORES_REGISTER];
+    std::string description = "watchdog:";
+    for (uint8_t core = 0; core < CORE_COUNT; core++) {
+        if ((cores & (1U << core)) == 0) {
+            continue;
+        }
+
+        auto checkpoint = static_cast<Checkpoint>((cores >> (BITS_PER_FIELD * (core + 1))) & FIELD_MASK);
+        uint32_t stalled_s = watchdog_hw->scratch[RECORD_TIME_REGISTER + core] / MS_PER_SECOND;
+        description += " core" + std::to_string(core) + " stalled at " + std::string(toString(checkpoint)) + " for "
+                       + std::to_string(stalled_s) + "s";
+    }
+    return description;
+}
+
+/**
+ * Feeds the watchdog while every supervised core is making progress.
+ *
+ * @return True while the watchdog is being fed, false once a stall has been recorded.
+ */
+static bool onSupervisorTimer(repeating_timer_t* /* unused */)
+{
+    uint32_t timepoint = static_cast<uint32_t>(milliseconds());
+    uint32_t stalled_cores = 0;
+    for (uint8_t core = 0; core < CORE_COUNT; core++) {
+        Heartbeat& heartbeat = heartbeats[core];
+        uint32_t count = heartbeat.count;
+        if (count == 0) {
+            // The core has not started its work yet, so there is nothing to supervise.
+            continue;
+        }
+
+        if (count != heartbeat.seen_count) {
+            heartbeat.seen_count = count;
+            heartbeat.seen_timepoint = timepoint;
+        }
+        else if (timepoint - heartbeat.seen_timepoint > STALL_TIMEOUTS_MS[core]) {
+            stalled_cores |= 1U << core;
+        }
+    }
+
+    if (stalled_cores != 0) {
+        // Without a feed the watchdog resets the system once it times out, and the record explains why after the reset.
+        recordStall(stalled_cores, timepoint);
+        printf("Supervisor stopped feeding the watchdog (stalled cores: 0x%02X)\n", stalled_cores);
+        return false;
+    }
+
+    watchdog_update();
+    return true;
+}
+
+bool start()
+{
+    last_reset = readLastReset();
+    printf("Last reset: %s\n", last_reset.c_str());
+
+    uint32_t timepoint = static_cast<uint32_t>(milliseconds());
+    for (Heartbeat& heartbeat : heartbeats) {
+        heartbeat.seen_timepoint = timepoint;
+    }
+
+    if (!add_repeating_timer_ms(-SUPERVISOR_PERIOD_MS, onSupervisorTimer, nullptr, &supervisor_timer)) {
+        printf("Failed to start the supervisor\n");
+        return false;
+    }
+
+    // Pausing on debug keeps a breakpoint from resetting the board.
+    watchdog_enable(WATCHDOG_TIMEOUT_MS, true);
+    return true;
+}
+
+void checkIn(Checkpoint checkpoint)
+{
+    Heartbeat& heartbeat = heartbeats[get_core_num()];
+    heartbeat.checkpoint = checkpoint;
+    heartbeat.count = heartbeat.count + 1;
+}
+
+const std::string& lastReset()
+{
+    return last_reset;
+}
+} // namespace supervisor
@@ -0,0 +1,80 @@
+/*------------------------------------------------------------------------------
+Copyright (c) 2023 Joe Porembski
+SPDX-License-Identifier: BSD-3-Clause
+------------------------------------------------------------------------------*/
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+
+namespace supervisor {
+inline constexpr uint8_t CORE_COUNT = 2;
+
+/**
+ * Enumerates the points in each core's work at which it checks in with the supervisor.
+ */
+enum class Checkpoint : uint8_t
+{
+    /** The core has not checked in. */
+    NONE,
+
+    /** Core 0 is waiting for the wireless connection. */
+    WIFI_CONNECT,
+
+    /** Core 0 is connecting to the MQTT broker. */
+    MQTT_CONNECT,
+
+    /** Core 0 is subscribing to MQTT topics. */
+    MQTT_SUBSCRIBE,
+
+    /** Core 0 is publishing data over MQTT. */
+    MQTT_PUBLISH,
+
+    /** Core 0 has nothing to publish. */
+    COMMUNICATION_IDLE,
+
+    /** Core 1 is reading the environment sensor. */
+    SENSOR_READ,
+
+    /** Core 1 is updating the heater. */
+    HEATER_UPDATE,
+
+    /** Core 1 is waiting between control cycles. */
+    CONTROL_IDLE
+};
+
+/**
+ * Converts @a checkpoint to a human readable string.
+ *
+ * @param[in] checkpoint The Checkpoint value.
+ * @return A human readable name for @a checkpoint.
+ */
+std::string_view toString(Checkpoint checkpoint);
+
+/**
+ * Starts the hardware watchdog, and the timer which feeds it while every core is making progress.
+ *
+ * Each core which has checked in must check in again within its stall timeout, or the supervisor stops feeding the
+ * watchdog and the system resets. Before it stops, the supervisor records which cores stalled, and where, in the
+ * watchdog scratch registers, which survive the reset.
+ *
+ * @note This must be called from core 0, whose default alarm pool runs the supervisor.
+ * @return True if the supervisor was started, false otherwise.
+ */
+bool start();
+
+/**
+ * Records that the calling core has reached @a checkpoint, showing that it is making progress.
+ *
+ * @note A core is only supervised once it has checked in.
+ * @param[in] checkpoint The point the calling core has reached.
+ */
+void checkIn(Checkpoint checkpoint);
+
+/**
+ * @return A description of what caused the last reset, including which cores stalled if it was the supervisor.
+ */
+const std::string& lastReset();
+} // namespace supervisor
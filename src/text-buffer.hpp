@@ -0,0 +1,105 @@
+/*------------------------------------------------------------------------------
+Copyright (c) 2023 Joe Porembski
+SPDX-License-Identifier: BSD-3-Clause
+------------------------------------------------------------------------------*/
+#pragma once
+
+#include "measurement.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+
+/**
+ * Builds up text in a fixed amount of space, so that a message made of several values can be put together without
+ * allocating.
+ *
+ * Text which does not fit is not added at all, rather than being cut short, and marks the buffer as overflowed.
+ *
+ * @tparam N The largest number of characters held.
+ */
+template <size_t N>
+class TextBuffer
+{
+public:
+    TextBuffer()
+        : _size(0),
+          _overflowed(false),
+          _text()
+    {
+    }
+
+    /**
+     * @return The text added so far.
+     */
+    std::string_view view() const
+    {
+        return std::string_view(_text.data(), _size);
+    }
+
+    /**
+     * @return True if any text was left out because it did not fit, false otherwise.
+     */
+    bool overflowed() const
+    {
+        return _overflowed;
+    }
+
+    /**
+     * Removes all the text, and clears the overflowed flag.
+     */
+    void clear()
+    {
+        _size = 0;
+        _overflowed = false;
+    }
+
+    /**
+     * Adds @a text to the end, if it fits.
+     *
+     * @param[in] text The text to add.
+     * @return True if @a text was added, false if it did not fit.
+     */
+    bool append(std::string_view text)
+    {
+        if (text.size() > N - _size) {
+            _overflowed = true;
+            return false;
+        }
+
+        text.copy(_text.data() + _size, text.size());
+        _size += text.size();
+        return true;
+    }
+
+    /**
+     * Adds an integer to the end as decimal text, if it fits.
+     *
+     * @param[in] value The value to add.
+     * @return True if @a value was added, false if it did not fit.
+     */
+    bool appendInteger(int64_t value)
+    {
+        NumberBuffer buffer;
+        return append(formatInteger(value, buffer));
+    }
+
+    /**
+     * Adds a value in hundredths to the end as a decimal with two decimal places, if it fits.
+     *
+     * @param[in] value The value in hundredths.
+     * @return True if @a value was added, false if it did not fit.
+     */
+    bool appendCenti(int32_t value)
+    {
+        NumberBuffer buffer;
+        return append(formatCenti(value, buffer));
+    }
+
+private:
+    size_t _size;
+    bool _overflowed;
+    std::array<char, N> _text;
+};
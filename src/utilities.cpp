@@ -22,6 +22,8 @@ inline constexpr size_t CONFIGURATION_OFFSET = PICO_FLASH_SIZE_BYTES - sizeof(ui
 inline constexpr size_t CONFIGURATION_MAX_SIZE = 1024;
 inline constexpr size_t STRING_MAX_SIZE = 256;
 inline constexpr int32_t STRING_IS_TOO_BIG = -1;
+inline constexpr uint8_t CONTROL_ALARM_NUMBER = 2;
+inline constexpr uint8_t CONTROL_ALARM_MAX_TIMERS = 16;
 
 
 static int32_t consumeString(const std::vector<uint8_t>& serialized_data, size_t starting_index, std::string& deserialized_data)
@@ -31,9 +33,12 @@ static int32_t consumeString(const std::vector<uint8_t>& serialized_data, size_t
     size_t string_index = starting_index + sizeof(uint32_t);
     size_t end_index = string_index + string_size;
 
-    printf("Reading configuration string from index %lu\n", starting_index);
+    printf("Reading configuration string from index %u\n", static_cast<unsigned>(starting_index));
     if (string_size > STRING_MAX_SIZE || end_index > serialized_data.size()) {
-        printf("Failed to read: [String size: %u, End: %u, data size: %lu]\n", string_size, end_index, serialized_data.size());
+        printf("Failed to read: [String size: %u, End: %u, data size: %u]\n",
+               string_size,
+               static_cast<unsigned>(end_index),
+               static_cast<unsigned>(serialized_data.size()));
         return STRING_IS_TOO_BIG;
     }
 
@@ -110,6 +115,12 @@ void SystemConfiguration::_parse(const std::vector<uint8_t>& configuration)
     }
 }
 
+alarm_pool_t* controlAlarmPool()
+{
+    static alarm_pool_t* pool = alarm_pool_create(CONTROL_ALARM_NUMBER, CONTROL_ALARM_MAX_TIMERS);
+    return pool;
+}
+
 uint64_t microseconds()
 {
     return to_us_since_boot(get_absolute_time());
@@ -160,7 +171,7 @@ bool read(SystemConfiguration& cfg)
     // understanding the configuration contents, and a lot of pointer math is avoided. As of time of
     // implementation, the configuration data is on the order of 50-60 bytes, so this appears like
     // a small hit in memory efficiency for a more object-oriented design.
-    printf("Configuration contents are %u bytes @ 0x%08X\n", total_length, configuration_contents);
+    printf("Configuration contents are %u bytes @ %p\n", total_length, static_cast<void*>(configuration_contents));
     std::vector<uint8_t> configuration(total_length);
     for (size_t i = 0; i < total_length; i++, configuration_contents++) {
         configuration[i] = *(configuration_contents);
@@ -67,6 +67,14 @@ private:
     std::string _device_name;
 };
 
+/**
+ * Provides the alarm pool used by the control loop.
+ *
+ * @note The pool is created on first use, and its alarms fire on the core which first used it.
+ * @return The alarm pool used by the control loop.
+ */
+alarm_pool_t* controlAlarmPool();
+
 /**
  * @return The microseconds since boot.
  */